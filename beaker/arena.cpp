@@ -0,0 +1,104 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/arena.hpp"
+#include "beaker/context.hpp"
+
+#include <cstdlib>
+
+
+namespace beaker
+{
+
+// Create an arena whose blocks are (at least) `n` bytes.
+// No memory is allocated until the first allocation.
+Arena::Arena(std::size_t n)
+  : size_(n)
+  , first_(nullptr)
+  , last_(nullptr)
+  , block_(nullptr)
+  , cleanup_(nullptr)
+  , allocs_(0)
+  , bytes_(0)
+  , blocks_(0)
+{ }
+
+
+Arena::~Arena()
+{
+  for (Cleanup* c = cleanup_; c; c = c->prev)
+    c->fn(c->obj);
+  while (block_) {
+    Block* b = block_->prev;
+    std::free(block_);
+    block_ = b;
+  }
+}
+
+
+// Acquire a new block having at least `n` bytes of storage
+// aligned to `a`, and allocate from that. Allocations larger
+// than the block size get their own block.
+void*
+Arena::grow(std::size_t n, std::size_t a)
+{
+  std::size_t size = sizeof(Block) + n + a;
+  if (size < size_)
+    size = size_;
+  Block* b = static_cast<Block*>(std::malloc(size));
+  if (!b)
+    throw std::bad_alloc();
+  b->prev = block_;
+  block_ = b;
+  ++blocks_;
+
+  first_ = reinterpret_cast<char*>(b + 1);
+  last_ = reinterpret_cast<char*>(b) + size;
+  std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(first_) + a - 1) & ~(a - 1);
+  first_ = reinterpret_cast<char*>(p + n);
+  return reinterpret_cast<void*>(p);
+}
+
+
+namespace
+{
+
+// The selected arena of each thread, if any.
+thread_local Arena* arena_ = nullptr;
+
+} // namespace
+
+
+// Returns the arena in which nodes are currently allocated.
+// When no arena has been selected, this is the arena of the
+// current context.
+Arena&
+get_arena()
+{
+  return arena_ ? *arena_ : current_context().arena;
+}
+
+
+// Allocate `n` bytes with the alignment `a` for the elements
+// of a small vector (see sequence.hpp).
+void*
+allocate_sequence(std::size_t n, std::size_t a)
+{
+  return get_arena().allocate(n, a);
+}
+
+
+Use_arena::Use_arena(Arena& a)
+  : prev(arena_)
+{
+  arena_ = &a;
+}
+
+
+Use_arena::~Use_arena()
+{
+  arena_ = prev;
+}
+
+
+} // namespace beaker
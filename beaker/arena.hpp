@@ -0,0 +1,130 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_ARENA_HPP
+#define BEAKER_ARENA_HPP
+
+// The arena module provides region-based allocation for the
+// nodes of the abstract syntax tree. Nodes are allocated by
+// bumping a pointer within a large block of memory, and all
+// of the nodes in an arena are released at once, when the
+// arena is destroyed.
+
+#include "beaker/prelude.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace beaker
+{
+
+// An arena allocates objects from a sequence of blocks. When
+// the arena is destroyed, the objects that it allocated are
+// destroyed (in the reverse order of their construction) and
+// its blocks are released.
+//
+// Objects whose destructors are trivial are never destroyed.
+// Otherwise, a record of the object and its destructor is
+// also allocated in the arena.
+struct Arena
+{
+  static constexpr std::size_t default_block_size = 64 << 10;
+
+  explicit Arena(std::size_t = default_block_size);
+  ~Arena();
+
+  Arena(Arena const&) = delete;
+  Arena& operator=(Arena const&) = delete;
+
+  void* allocate(std::size_t, std::size_t);
+
+  template<typename T, typename... Args>
+  T* make(Args&&...);
+
+  // Statistics
+  std::size_t allocations() const { return allocs_; }
+  std::size_t bytes() const       { return bytes_; }
+  std::size_t blocks() const      { return blocks_; }
+
+  // A block of memory. The storage follows the header.
+  struct Block
+  {
+    Block* prev;
+  };
+
+  // A destructor record.
+  struct Cleanup
+  {
+    void   (*fn)(void*);
+    void*    obj;
+    Cleanup* prev;
+  };
+
+  void* grow(std::size_t, std::size_t);
+
+  template<typename T>
+  static void destroy(void* p) { static_cast<T*>(p)->~T(); }
+
+  std::size_t size_;    // The default block size
+  char*       first_;   // The next free byte in the block
+  char*       last_;    // The end of the current block
+  Block*      block_;   // The current block
+  Cleanup*    cleanup_; // The most recent destructor
+  std::size_t allocs_;  // Number of allocations
+  std::size_t bytes_;   // Number of bytes allocated
+  std::size_t blocks_;  // Number of blocks acquired
+};
+
+
+// Allocate `n` bytes with the given alignment.
+inline void*
+Arena::allocate(std::size_t n, std::size_t a)
+{
+  ++allocs_;
+  bytes_ += n;
+  std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(first_) + a - 1) & ~(a - 1);
+  if (p + n > reinterpret_cast<std::uintptr_t>(last_))
+    return grow(n, a);
+  first_ = reinterpret_cast<char*>(p + n);
+  return reinterpret_cast<void*>(p);
+}
+
+
+// Allocate and construct an object of type T.
+template<typename T, typename... Args>
+inline T*
+Arena::make(Args&&... args)
+{
+  T* p = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  if (!std::is_trivially_destructible<T>::value) {
+    void* q = allocate(sizeof(Cleanup), alignof(Cleanup));
+    cleanup_ = new (q) Cleanup{&destroy<T>, p, cleanup_};
+  }
+  return p;
+}
+
+
+Arena& get_arena();
+
+
+// Within the lifetime of this object, nodes are allocated
+// in the given arena. When no arena has been selected, nodes
+// are allocated in the arena of the current context (see
+// context.hpp).
+struct Use_arena
+{
+  Use_arena(Arena&);
+  ~Use_arena();
+
+  Arena* prev;
+};
+
+
+} // namespace beaker
+
+
+#endif
@@ -0,0 +1,979 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/bytecode.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+#include "beaker/unit.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+
+namespace beaker
+{
+
+char const*
+get_spelling(Opcode op)
+{
+  switch (op) {
+    case const_ins: return "const";
+    case move_ins: return "move";
+    case load_ins: return "load";
+    case store_ins: return "store";
+    case neg_ins: return "neg";
+    case pos_ins: return "pos";
+    case compl_ins: return "compl";
+    case not_ins: return "not";
+    case add_ins: return "add";
+    case sub_ins: return "sub";
+    case mul_ins: return "mul";
+    case div_ins: return "div";
+    case mod_ins: return "mod";
+    case and_ins: return "and";
+    case or_ins: return "or";
+    case xor_ins: return "xor";
+    case lsh_ins: return "lsh";
+    case rsh_ins: return "rsh";
+    case eq_ins: return "eq";
+    case ne_ins: return "ne";
+    case lt_ins: return "lt";
+    case gt_ins: return "gt";
+    case le_ins: return "le";
+    case ge_ins: return "ge";
+    case add_imm_ins: return "add_imm";
+    case jump_ins: return "jump";
+    case jump_if_ins: return "jump_if";
+    case jump_not_ins: return "jump_not";
+    case jump_eq_ins: return "jump_eq";
+    case jump_ne_ins: return "jump_ne";
+    case jump_lt_ins: return "jump_lt";
+    case jump_gt_ins: return "jump_gt";
+    case jump_le_ins: return "jump_le";
+    case jump_ge_ins: return "jump_ge";
+    case jump_eq_imm_ins: return "jump_eq_imm";
+    case jump_ne_imm_ins: return "jump_ne_imm";
+    case jump_lt_imm_ins: return "jump_lt_imm";
+    case jump_gt_imm_ins: return "jump_gt_imm";
+    case jump_le_imm_ins: return "jump_le_imm";
+    case jump_ge_imm_ins: return "jump_ge_imm";
+    case call_ins: return "call";
+    case ret_ins: return "ret";
+  }
+  lingo_unreachable();
+}
+
+
+// Returns the procedure translated from the function `f`, or
+// nullptr if `f` was not translated.
+Procedure const*
+Program::find(Function_decl const* f) const
+{
+  auto iter = index.find(f);
+  if (iter == index.end())
+    return nullptr;
+  return &procs[iter->second];
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Translation
+
+namespace
+{
+
+// Returns the slot of the variable or parameter `d`.
+inline Slot
+get_slot(Decl const* d)
+{
+  if (Variable_decl const* v = as<Variable_decl>(d))
+    return v->slot();
+  return cast<Parameter_decl>(d)->slot();
+}
+
+
+// Returns the compare-and-branch instruction for the relational
+// operator `op`. If `neg` is true, the branch is taken when the
+// comparison is false. If `imm` is true, the instruction compares
+// with an immediate operand.
+Opcode
+get_branch(Binary_op op, bool neg, bool imm)
+{
+  if (neg) {
+    switch (op) {
+      case rel_eq_op: op = rel_ne_op; break;
+      case rel_ne_op: op = rel_eq_op; break;
+      case rel_lt_op: op = rel_ge_op; break;
+      case rel_gt_op: op = rel_le_op; break;
+      case rel_le_op: op = rel_gt_op; break;
+      case rel_ge_op: op = rel_lt_op; break;
+      default: lingo_unreachable();
+    }
+  }
+  Opcode base = imm ? jump_eq_imm_ins : jump_eq_ins;
+  return Opcode(base + (op - rel_eq_op));
+}
+
+
+// Returns the relational operator that gives the same result
+// when its operands are exchanged.
+Binary_op
+get_converse(Binary_op op)
+{
+  switch (op) {
+    case rel_lt_op: return rel_gt_op;
+    case rel_gt_op: return rel_lt_op;
+    case rel_le_op: return rel_ge_op;
+    case rel_ge_op: return rel_le_op;
+    default: return op;
+  }
+}
+
+
+// Returns true if `e` is a constant whose value, and the
+// negation of that value, fit in an immediate operand. The
+// value is stored in `n`.
+bool
+is_immediate(Expr const* e, int& n)
+{
+  if (Constant_expr const* c = as<Constant_expr>(e)) {
+    Value v = c->value();
+    if (std::numeric_limits<int>::min() < v && v <= std::numeric_limits<int>::max()) {
+      n = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+inline bool
+is_relational(Binary_op op)
+{
+  return rel_eq_op <= op && op <= rel_ge_op;
+}
+
+
+// A list of branches whose target is not yet known.
+using Jump_list = std::vector<int>;
+
+
+struct Translator;
+
+
+// Translates a single function into a procedure. Temporary
+// registers are allocated above the slots of the frame, and
+// released when the expression that needs them is translated.
+//
+// Expressions, conditions, and statements are translated using
+// an explicit stack of tasks, so their depth is limited only by
+// available memory. The state of a task is the number of its
+// parts that have been translated. Jump lists of tasks are kept
+// on a separate stack, and tasks refer to them by index.
+//
+// Note that the procedure is not stored in the program until
+// it is finished, since translating a call may add procedures
+// to the program.
+struct Procedure_builder
+{
+  enum Task_kind
+  {
+    value_task,  // Store the value of an expression
+    branch_task, // Branch on the value of a condition
+    stmt_task,   // Translate a statement
+  };
+
+  struct Task
+  {
+    Task_kind   kind;
+    Expr const* expr;  // The expression or condition
+    Stmt const* stmt;  // The statement
+    int         dst;   // The register of a value, or when to branch
+    int         list;  // The jump list of a branch
+    int         mark;  // The next free register on entry
+    int         state;
+    int         a, b, c; // Registers and positions between parts
+  };
+
+  Procedure_builder(Translator& t, Function_decl const* f, int n)
+    : trans(t), proc(f), top(n), lists(0)
+  {
+    proc.registers = n;
+  }
+
+  int  here() const { return proc.code.size(); }
+  int  emit(Opcode, int = 0, int = 0, int = 0);
+  int  temp();
+  int  constant(Value);
+  void resolve(Jump_list&, int);
+
+  int  open_list();
+  void close_list(int);
+
+  Slot slot(Expr const*);
+  void expr(Expr const*, int);
+  int  operand(Expr const*);
+  void branch(Expr const*, bool, int);
+  void stmt(Stmt const*);
+  void run();
+  void finish();
+
+  bool value(Task&);
+  bool test(Task&);
+  bool exec(Task&);
+
+  Translator&                       trans;
+  Procedure                         proc;
+  int                               top;    // The next free register
+  std::unordered_set<Decl const*>   locals; // Variables in the frame
+  std::vector<Task>                 work;   // Tasks in progress
+  std::vector<Jump_list>            jumps;  // Jump lists of tasks
+  int                               lists;  // The number of jump lists in use
+};
+
+
+// Translates a unit into a program. The procedures of the unit's
+// functions are indexed in order of declaration, followed by the
+// procedure that initializes global variables, and then those of
+// nested functions, as they are called.
+struct Translator
+{
+  int  procedure(Function_decl const*);
+  void translate(Unit const*);
+  void translate(Function_decl const*);
+
+  Program                            prog;
+  std::vector<Function_decl const*> work;
+};
+
+
+int
+Procedure_builder::emit(Opcode op, int a, int b, int c)
+{
+  proc.code.push_back(Instr{op, a, b, c});
+  return proc.code.size() - 1;
+}
+
+
+int
+Procedure_builder::temp()
+{
+  int r = top++;
+  proc.registers = std::max(proc.registers, top);
+  return r;
+}
+
+
+// Returns the index of the value `v` in the constant pool.
+int
+Procedure_builder::constant(Value v)
+{
+  Value_seq& k = proc.constants;
+  auto iter = std::find(k.begin(), k.end(), v);
+  if (iter != k.end())
+    return iter - k.begin();
+  k.push_back(v);
+  return k.size() - 1;
+}
+
+
+// Set the target of each branch in `js` to `n`.
+void
+Procedure_builder::resolve(Jump_list& js, int n)
+{
+  for (int j : js)
+    proc.code[j].c = n;
+  js.clear();
+}
+
+
+// Returns the index of a new, empty jump list.
+int
+Procedure_builder::open_list()
+{
+  if (lists == int(jumps.size()))
+    jumps.emplace_back();
+  return lists++;
+}
+
+
+// Release the jump list `n`, which was the last opened.
+void
+Procedure_builder::close_list(int n)
+{
+  lingo_assert(n == lists - 1 && jumps[n].empty());
+  --lists;
+}
+
+
+// Returns the slot of the object named by the identifier `e`.
+// A local variable or parameter of an enclosing function is
+// not in this frame. That is diagnosed, and the slot of a new
+// temporary is returned instead.
+Slot
+Procedure_builder::slot(Expr const* e)
+{
+  Decl const* d = cast<Identifier_expr>(e)->decl();
+  Slot s = get_slot(d);
+  if (!s.global && !locals.count(d)) {
+    error(e->location(), "'{}' is local to an enclosing function", d->name());
+    return Slot(false, temp());
+  }
+  return s;
+}
+
+
+// Translate the expression `e`, storing its value in the
+// register `dst`. Note that `dst` is written only after its
+// operands have been read, so `dst` may be the register of a
+// variable that appears in `e`.
+void
+Procedure_builder::expr(Expr const* e, int dst)
+{
+  work.push_back(Task{value_task, e, nullptr, dst, 0, top, 0, 0, 0, 0});
+}
+
+
+// Returns a register holding the value of `e`. Variables in the
+// frame are used directly; other values are stored in a new
+// temporary register.
+int
+Procedure_builder::operand(Expr const* e)
+{
+  if (Identifier_expr const* id = as<Identifier_expr>(e)) {
+    if (!is<Function_decl>(id->decl())) {
+      Slot s = slot(e);
+      if (!s.global)
+        return s.offset;
+    }
+  }
+  int r = temp();
+  expr(e, r);
+  return r;
+}
+
+
+// Translate the condition `e` into branches that are taken when
+// its value is `when`. Those branches are added to the jump list
+// `js`, and execution continues with the next instruction
+// otherwise.
+void
+Procedure_builder::branch(Expr const* e, bool when, int js)
+{
+  work.push_back(Task{branch_task, e, nullptr, when, js, top, 0, 0, 0, 0});
+}
+
+
+// Translate the statement `s`.
+void
+Procedure_builder::stmt(Stmt const* s)
+{
+  work.push_back(Task{stmt_task, nullptr, s, 0, 0, top, 0, 0, 0, 0});
+}
+
+
+// Run the tasks on the stack. A task is updated in a copy,
+// since the tasks of its parts are added to the stack. When
+// it is finished, the registers that it allocated are released.
+void
+Procedure_builder::run()
+{
+  while (!work.empty()) {
+    std::size_t i = work.size() - 1;
+    Task t = work[i];
+    bool done;
+    if (t.kind == value_task)
+      done = value(t);
+    else if (t.kind == branch_task)
+      done = test(t);
+    else
+      done = exec(t);
+    if (done) {
+      top = t.mark;
+      work.pop_back();
+    } else {
+      work[i] = t;
+    }
+  }
+}
+
+
+// Advance the translation of an expression. Returns true when
+// its value is stored.
+bool
+Procedure_builder::value(Task& t)
+{
+  Expr const* e = t.expr;
+  int dst = t.dst;
+  switch (e->kind()) {
+    case constant_expr_kind:
+      emit(const_ins, dst, constant(cast<Constant_expr>(e)->value()));
+      return true;
+
+    case identifier_expr_kind: {
+      Decl const* d = cast<Identifier_expr>(e)->decl();
+      if (is<Function_decl>(d)) {
+        error(e->location(), "'{}' is not an object", d->name());
+        return true;
+      }
+      Slot s = slot(e);
+      if (s.global)
+        emit(load_ins, dst, s.offset);
+      else if (s.offset != dst)
+        emit(move_ins, dst, s.offset);
+      return true;
+    }
+
+    case unary_expr_kind: {
+      Unary_expr const* u = cast<Unary_expr>(e);
+      if (t.state++ == 0) {
+        t.a = operand(u->arg());
+        return false;
+      }
+      emit(Opcode(neg_ins + u->op()), dst, t.a);
+      return true;
+    }
+
+    case binary_expr_kind: {
+      Binary_expr const* b = cast<Binary_expr>(e);
+      if (b->op() == log_and_op || b->op() == log_or_op) {
+        if (t.state++ == 0) {
+          t.a = open_list();
+          branch(e, false, t.a);
+          return false;
+        }
+        emit(const_ins, dst, constant(1));
+        int j = emit(jump_ins);
+        resolve(jumps[t.a], here());
+        close_list(t.a);
+        emit(const_ins, dst, constant(0));
+        proc.code[j].c = here();
+        return true;
+      }
+
+      // Add or subtract a constant with an immediate. The
+      // immediate is kept in `b`, and `c` is 1 if it is used.
+      if (t.state == 0) {
+        t.state = 1;
+        int k;
+        if (b->op() == num_add_op || b->op() == num_sub_op) {
+          if (is_immediate(b->right(), k)) {
+            t.b = b->op() == num_add_op ? k : -k;
+            t.c = 1;
+            t.a = operand(b->left());
+            return false;
+          }
+          if (b->op() == num_add_op && is_immediate(b->left(), k)) {
+            t.b = k;
+            t.c = 1;
+            t.a = operand(b->right());
+            return false;
+          }
+        }
+        t.a = operand(b->left());
+        return false;
+      }
+      if (t.c) {
+        emit(add_imm_ins, dst, t.a, t.b);
+        return true;
+      }
+      if (t.state == 1) {
+        t.state = 2;
+        t.b = operand(b->right());
+        return false;
+      }
+      emit(Opcode(add_ins + b->op()), dst, t.a, t.b);
+      return true;
+    }
+
+    case call_expr_kind: {
+      Call_expr const* c = cast<Call_expr>(e);
+      Function_decl const* f = nullptr;
+      if (Identifier_expr const* id = as<Identifier_expr>(c->function()))
+        f = as<Function_decl>(id->decl());
+      if (!f) {
+        error(c->location(), "indirect calls are not supported");
+        return true;
+      }
+
+      // Arguments are stored in consecutive registers, which
+      // become the parameters of the callee. The first is kept
+      // in `a`.
+      Expr_seq const& args = c->arguments();
+      if (t.state == 0)
+        t.a = top;
+      if (t.state < int(args.size())) {
+        Expr const* arg = args[t.state++];
+        expr(arg, temp());
+        return false;
+      }
+      emit(call_ins, dst, trans.procedure(f), t.a);
+      return true;
+    }
+
+    default:
+      lingo_unreachable();
+  }
+}
+
+
+// Advance the translation of a condition. Returns true when
+// its branches have been added to its jump list.
+bool
+Procedure_builder::test(Task& t)
+{
+  Expr const* e = t.expr;
+  bool when = t.dst;
+  int js = t.list;
+  if (Constant_expr const* c = as<Constant_expr>(e)) {
+    if (bool(c->value()) == when)
+      jumps[js].push_back(emit(jump_ins));
+    return true;
+  }
+
+  // The operand of a negation replaces the condition.
+  if (Unary_expr const* u = as<Unary_expr>(e)) {
+    if (u->op() == log_not_op) {
+      t.expr = u->arg();
+      t.dst = !when;
+      return false;
+    }
+  }
+
+  if (Binary_expr const* b = as<Binary_expr>(e)) {
+    Binary_op op = b->op();
+
+    // Branch when both (either) operands are true (false).
+    // Otherwise, skip the second operand when the first
+    // decides the value of the expression. The list of
+    // skipping branches is kept in `a`.
+    if (op == log_and_op || op == log_or_op) {
+      if (when == (op == log_or_op)) {
+        if (t.state++ == 0) {
+          branch(b->left(), when, js);
+          return false;
+        }
+        t.expr = b->right();
+        t.state = 0;
+        return false;
+      }
+      switch (t.state++) {
+        case 0:
+          t.a = open_list();
+          branch(b->left(), !when, t.a);
+          return false;
+        case 1:
+          branch(b->right(), when, js);
+          return false;
+        default:
+          resolve(jumps[t.a], here());
+          close_list(t.a);
+          return true;
+      }
+    }
+
+    // Compare with a constant operand as an immediate. The
+    // immediate is kept in `b`, and `c` is 1 if the right
+    // operand is the immediate, 2 if the left is, and 0
+    // otherwise.
+    if (is_relational(op)) {
+      int k;
+      switch (t.state++) {
+        case 0:
+          if (is_immediate(b->right(), k)) {
+            t.b = k;
+            t.c = 1;
+            t.a = operand(b->left());
+          } else if (is_immediate(b->left(), k)) {
+            t.b = k;
+            t.c = 2;
+            t.a = operand(b->right());
+          } else {
+            t.a = operand(b->left());
+          }
+          return false;
+        case 1:
+          if (t.c == 1) {
+            jumps[js].push_back(emit(get_branch(op, !when, true), t.a, t.b));
+            return true;
+          }
+          if (t.c == 2) {
+            jumps[js].push_back(emit(get_branch(get_converse(op), !when, true), t.a, t.b));
+            return true;
+          }
+          t.b = operand(b->right());
+          return false;
+        default:
+          jumps[js].push_back(emit(get_branch(op, !when, false), t.a, t.b));
+          return true;
+      }
+    }
+  }
+
+  if (t.state++ == 0) {
+    t.a = operand(e);
+    return false;
+  }
+  jumps[js].push_back(emit(when ? jump_if_ins : jump_not_ins, t.a));
+  return true;
+}
+
+
+// Advance the translation of a statement. Returns true when
+// the statement is translated. Jump lists and positions of
+// branches are kept in `a` and `b`.
+bool
+Procedure_builder::exec(Task& t)
+{
+  Stmt const* s = t.stmt;
+  switch (s->kind()) {
+    case empty_stmt_kind:
+      return true;
+
+    case declaration_stmt_kind: {
+      // Nested functions are translated when they are called.
+      Decl const* d = cast<Declaration_stmt>(s)->decl();
+      if (Variable_decl const* v = as<Variable_decl>(d)) {
+        if (t.state++ == 0) {
+          locals.insert(v);
+          if (v->initializer()) {
+            expr(v->initializer(), v->slot().offset);
+            return false;
+          }
+          emit(const_ins, v->slot().offset, constant(0));
+        }
+      }
+      return true;
+    }
+
+    case expression_stmt_kind:
+      if (t.state++ == 0) {
+        expr(cast<Expression_stmt>(s)->expr(), temp());
+        return false;
+      }
+      return true;
+
+    // The slot of the variable is kept in `b`, and `c` is 1
+    // if it is global.
+    case assignment_stmt_kind: {
+      Assignment_stmt const* a = cast<Assignment_stmt>(s);
+      if (t.state++ == 0) {
+        Slot v = slot(a->lhs());
+        t.b = v.offset;
+        t.c = v.global;
+        if (v.global)
+          t.a = operand(a->rhs());
+        else
+          expr(a->rhs(), v.offset);
+        return false;
+      }
+      if (t.c)
+        emit(store_ins, t.b, t.a);
+      return true;
+    }
+
+    case if_then_stmt_kind: {
+      If_then_stmt const* s1 = cast<If_then_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          t.a = open_list();
+          branch(s1->condition(), false, t.a);
+          return false;
+        case 1:
+          stmt(s1->branch());
+          return false;
+        default:
+          resolve(jumps[t.a], here());
+          close_list(t.a);
+          return true;
+      }
+    }
+
+    case if_else_stmt_kind: {
+      If_else_stmt const* s1 = cast<If_else_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          t.a = open_list();
+          branch(s1->condition(), false, t.a);
+          return false;
+        case 1:
+          stmt(s1->true_branch());
+          return false;
+        case 2:
+          t.b = emit(jump_ins);
+          resolve(jumps[t.a], here());
+          close_list(t.a);
+          stmt(s1->false_branch());
+          return false;
+        default:
+          proc.code[t.b].c = here();
+          return true;
+      }
+    }
+
+    // The condition is placed after the body, so that each
+    // iteration executes a single branch.
+    case while_stmt_kind: {
+      While_stmt const* s1 = cast<While_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          t.a = emit(jump_ins);
+          t.b = here();
+          stmt(s1->body());
+          return false;
+        case 1:
+          proc.code[t.a].c = here();
+          t.a = open_list();
+          branch(s1->condition(), true, t.a);
+          return false;
+        default:
+          resolve(jumps[t.a], t.b);
+          close_list(t.a);
+          return true;
+      }
+    }
+
+    case do_stmt_kind: {
+      Do_stmt const* s1 = cast<Do_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          t.b = here();
+          stmt(s1->body());
+          return false;
+        case 1:
+          t.a = open_list();
+          branch(s1->condition(), true, t.a);
+          return false;
+        default:
+          resolve(jumps[t.a], t.b);
+          close_list(t.a);
+          return true;
+      }
+    }
+
+    case exit_stmt_kind: {
+      int r = temp();
+      emit(const_ins, r, constant(0));
+      emit(ret_ins, r);
+      return true;
+    }
+
+    case return_stmt_kind:
+      if (t.state++ == 0) {
+        t.a = operand(cast<Return_stmt>(s)->result());
+        return false;
+      }
+      emit(ret_ins, t.a);
+      return true;
+
+    case block_stmt_kind: {
+      Stmt_seq const& ss = cast<Block_stmt>(s)->statements();
+      if (t.state < int(ss.size())) {
+        stmt(ss[t.state++]);
+        return false;
+      }
+      return true;
+    }
+  }
+  lingo_unreachable();
+}
+
+
+// Return 0 when control reaches the end of the procedure.
+void
+Procedure_builder::finish()
+{
+  int r = temp();
+  emit(const_ins, r, constant(0));
+  emit(ret_ins, r);
+}
+
+
+// Returns the index of the procedure for `f`, adding it to
+// the work list if it has not been translated.
+int
+Translator::procedure(Function_decl const* f)
+{
+  auto ins = prog.index.insert({f, prog.procs.size()});
+  if (ins.second) {
+    prog.procs.emplace_back(f);
+    work.push_back(f);
+  }
+  return ins.first->second;
+}
+
+
+// Translate the function `f`.
+void
+Translator::translate(Function_decl const* f)
+{
+  Procedure_builder b(*this, f, f->frame_size());
+  b.proc.params = f->parameters().size();
+  Stmt const* s = f->body();
+  if (is_valid_node(s)) {
+    for (Decl const* p : f->parameters())
+      b.locals.insert(p);
+    b.stmt(s);
+    b.run();
+  } else
+    error(f->location(), "'{}' is not defined", f->name());
+  b.finish();
+  prog.procs[prog.index[f]] = std::move(b.proc);
+}
+
+
+void
+Translator::translate(Unit const* u)
+{
+  allocate_slots(u);
+
+  prog.globals = 0;
+  for (Decl const* d : u->declarations()) {
+    if (Function_decl const* f = as<Function_decl>(d))
+      procedure(f);
+    else if (is<Variable_decl>(d))
+      ++prog.globals;
+  }
+
+  // Translate the initialization of globals.
+  Procedure_builder b(*this, nullptr, 0);
+  for (Decl const* d : u->declarations()) {
+    if (Variable_decl const* v = as<Variable_decl>(d)) {
+      if (v->initializer()) {
+        int r = b.operand(v->initializer());
+        b.run();
+        b.emit(store_ins, v->slot().offset, r);
+        b.top = 0;
+      }
+    }
+  }
+  b.finish();
+  prog.init = prog.procs.size();
+  prog.procs.push_back(std::move(b.proc));
+
+  // Translate functions until no more are called.
+  for (std::size_t i = 0; i < work.size(); ++i)
+    translate(work[i]);
+}
+
+
+} // namespace
+
+
+// Translate the unit `u` into bytecode. This assigns the slots
+// of variables in `u` (see allocate_slots).
+Program
+to_bytecode(Unit const* u)
+{
+  Translator t;
+  t.translate(u);
+  return std::move(t.prog);
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Disassembly
+
+namespace
+{
+
+void
+disassemble(std::ostream& os, Procedure const& p, Instr const& i)
+{
+  os << std::setw(12) << std::left << get_spelling(i.op) << std::right;
+  switch (i.op) {
+    case const_ins:
+      os << 'r' << i.a << ", " << p.constants[i.b];
+      break;
+    case move_ins:
+    case neg_ins:
+    case pos_ins:
+    case compl_ins:
+    case not_ins:
+      os << 'r' << i.a << ", r" << i.b;
+      break;
+    case load_ins:
+      os << 'r' << i.a << ", g" << i.b;
+      break;
+    case store_ins:
+      os << 'g' << i.a << ", r" << i.b;
+      break;
+    case jump_ins:
+      os << '@' << i.c;
+      break;
+    case jump_if_ins:
+    case jump_not_ins:
+      os << 'r' << i.a << ", @" << i.c;
+      break;
+    case jump_eq_ins:
+    case jump_ne_ins:
+    case jump_lt_ins:
+    case jump_gt_ins:
+    case jump_le_ins:
+    case jump_ge_ins:
+      os << 'r' << i.a << ", r" << i.b << ", @" << i.c;
+      break;
+    case jump_eq_imm_ins:
+    case jump_ne_imm_ins:
+    case jump_lt_imm_ins:
+    case jump_gt_imm_ins:
+    case jump_le_imm_ins:
+    case jump_ge_imm_ins:
+      os << 'r' << i.a << ", " << i.b << ", @" << i.c;
+      break;
+    case add_imm_ins:
+      os << 'r' << i.a << ", r" << i.b << ", " << i.c;
+      break;
+    case call_ins:
+      os << 'r' << i.a << ", p" << i.b << ", r" << i.c;
+      break;
+    case ret_ins:
+      os << 'r' << i.a;
+      break;
+    default:
+      os << 'r' << i.a << ", r" << i.b << ", r" << i.c;
+      break;
+  }
+}
+
+
+} // namespace
+
+
+// Write a readable listing of the procedure `p` to `os`. Each
+// instruction is preceded by its index, which is the target of
+// branches to it.
+void
+disassemble(std::ostream& os, Procedure const& p)
+{
+  if (p.decl)
+    os << *p.decl->name();
+  else
+    os << "<globals>";
+  os << ": params " << p.params << ", registers " << p.registers << '\n';
+  for (std::size_t n = 0; n < p.code.size(); ++n) {
+    os << std::setw(6) << n << "  ";
+    disassemble(os, p, p.code[n]);
+    os << '\n';
+  }
+}
+
+
+void
+disassemble(std::ostream& os, Program const& prog)
+{
+  for (std::size_t n = 0; n < prog.procs.size(); ++n) {
+    os << 'p' << n << ' ';
+    disassemble(os, prog.procs[n]);
+    os << '\n';
+  }
+}
+
+
+} // namespace beaker
@@ -0,0 +1,163 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_BYTECODE_HPP
+#define BEAKER_BYTECODE_HPP
+
+// This module defines a register bytecode for Beaker programs
+// and the translation of checked programs into that bytecode.
+// The bytecode is run by the machine (see machine.hpp).
+//
+// Each function is translated into a procedure. The registers
+// of a procedure are the slots of its frame (see Slot in
+// decl.hpp), followed by temporaries. A call passes arguments
+// in consecutive registers of the caller, which become the
+// first registers (the parameters) of the callee.
+
+#include "beaker/prelude.hpp"
+#include "beaker/value.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+
+namespace beaker
+{
+
+// The kinds of instructions. Each instruction has three operands
+// a, b, and c, whose meaning depends on the instruction. In the
+// comments below, r[n] is the nth register of the current frame,
+// g[n] is the nth global variable, and k[n] is the nth constant
+// of the procedure.
+//
+// There is one instruction for each unary operator and each
+// binary operator, except for && and ||, which are translated
+// into branches. The order of those instructions is the same
+// as the order of the operators.
+//
+// Superinstructions combine common sequences of instructions.
+// These take an immediate operand in place of a register that
+// would hold a constant. For example, the assignment x = x + 1
+// is a single add_imm, and the condition of while (i < 10) is
+// a single jump_lt_imm.
+//
+// Note that the machine's table of labels (see machine.cpp)
+// lists the instructions in the order they are declared.
+enum Opcode
+{
+  const_ins,   // r[a] = k[b]
+  move_ins,    // r[a] = r[b]
+  load_ins,    // r[a] = g[b]
+  store_ins,   // g[a] = r[b]
+
+  // Unary operators: r[a] = op r[b]
+  neg_ins,
+  pos_ins,
+  compl_ins,
+  not_ins,
+
+  // Binary operators: r[a] = r[b] op r[c]
+  add_ins,
+  sub_ins,
+  mul_ins,
+  div_ins,
+  mod_ins,
+  and_ins,
+  or_ins,
+  xor_ins,
+  lsh_ins,
+  rsh_ins,
+  eq_ins,
+  ne_ins,
+  lt_ins,
+  gt_ins,
+  le_ins,
+  ge_ins,
+  add_imm_ins, // r[a] = r[b] + c
+
+  // Branches to the instruction c.
+  jump_ins,    // goto c
+  jump_if_ins, // if (r[a]) goto c
+  jump_not_ins,// if (!r[a]) goto c
+
+  // Compare-and-branch: if (r[a] op r[b]) goto c
+  jump_eq_ins,
+  jump_ne_ins,
+  jump_lt_ins,
+  jump_gt_ins,
+  jump_le_ins,
+  jump_ge_ins,
+
+  // Compare-and-branch with an immediate: if (r[a] op b) goto c
+  jump_eq_imm_ins,
+  jump_ne_imm_ins,
+  jump_lt_imm_ins,
+  jump_gt_imm_ins,
+  jump_le_imm_ins,
+  jump_ge_imm_ins,
+
+  call_ins,    // r[a] = p[b](r[c], r[c + 1], ...)
+  ret_ins,     // return r[a]
+};
+
+
+char const* get_spelling(Opcode);
+
+
+// An instruction.
+struct Instr
+{
+  Opcode op;
+  int    a;
+  int    b;
+  int    c;
+};
+
+
+using Code = std::vector<Instr>;
+
+
+// A procedure is the translation of a function. The size of
+// its frame is the number of its registers.
+//
+// The procedure that initializes global variables has no
+// function.
+struct Procedure
+{
+  Procedure(Function_decl const* f)
+    : decl(f), params(0), registers(0)
+  { }
+
+  Function_decl const* decl;      // The translated function
+  int                  params;    // The number of parameters
+  int                  registers; // The size of the frame
+  Value_seq            constants; // The constant pool
+  Code                 code;      // The instructions
+};
+
+
+// A program is the translation of a unit. Procedures are
+// indexed by their position in the program.
+struct Program
+{
+  Procedure const* find(Function_decl const*) const;
+
+  using Index = std::unordered_map<Function_decl const*, int>;
+
+  std::vector<Procedure> procs;   // The procedures
+  Index                  index;   // Procedures of functions
+  int                    globals; // The number of globals
+  int                    init;    // Initializes globals
+};
+
+
+Program to_bytecode(Unit const*);
+
+void disassemble(std::ostream&, Procedure const&);
+void disassemble(std::ostream&, Program const&);
+
+
+} // namespace beaker
+
+
+#endif
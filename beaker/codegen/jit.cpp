@@ -0,0 +1,899 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "jit.hpp"
+
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/interpret.hpp"
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <atomic>
+#include <vector>
+
+
+namespace beaker
+{
+
+// The LLVM objects of the JIT. The LLJIT is created when the
+// first module is compiled, so that constructing a JIT is cheap.
+struct Jit_state
+{
+  llvm::orc::LLJIT* get();
+
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  std::once_flag                    init;
+  std::atomic<int>                  modules; // Names modules
+};
+
+
+// Returns the LLJIT, or nullptr if it cannot be created.
+llvm::orc::LLJIT*
+Jit_state::get()
+{
+  std::call_once(init, [this]() {
+    auto j = llvm::orc::LLJITBuilder().create();
+    if (!j)
+      error("cannot create JIT: {}", llvm::toString(j.takeError()));
+    else
+      jit = std::move(*j);
+  });
+  return jit.get();
+}
+
+
+namespace
+{
+
+// -------------------------------------------------------------------------- //
+//                            IR generation
+//
+// Each variable and parameter has its own stack allocation,
+// which the optimizer promotes to registers. Values of type
+// bool are widened to 64 bits when stored and narrowed to 1
+// bit when tested.
+
+// Diagnoses division by 0 in native code, as the machine does.
+// Native code calls this function through its address.
+void
+divide_by_zero()
+{
+  error("division by zero");
+}
+
+
+// Generates a module containing a function, the functions it
+// calls, and its entry point.
+//
+// Expressions, conditions, and statements are generated using
+// an explicit stack of tasks, so their depth is limited only by
+// available memory. The state of a task is the number of its
+// parts that have been generated. Each expression or condition
+// leaves its value on a stack of values, from which it is taken
+// by the task that needs it.
+struct Generator
+{
+  enum Task_kind
+  {
+    value_task,     // Compute the value of an expression
+    condition_task, // Compute the value of a condition
+    stmt_task,      // Generate a statement
+  };
+
+  struct Task
+  {
+    Task_kind          kind;
+    Expr const*        expr;
+    Stmt const*        stmt;
+    int                state;
+    llvm::BasicBlock*  blocks[3]; // Blocks between parts
+  };
+
+  Generator(llvm::LLVMContext& c, llvm::Module& m, Value* g)
+    : cxt(c), mod(m), ir(c), globals(g), fn(nullptr)
+  {
+    int_type = llvm::Type::getInt64Ty(cxt);
+  }
+
+  llvm::Function* function(Function_decl const*);
+  llvm::Function* entry(Function_decl const*);
+  llvm::Function* init(Unit const*);
+  void            define(Function_decl const*);
+  void            define_all();
+
+  llvm::Value* constant(Value n) { return llvm::ConstantInt::get(int_type, n); }
+  llvm::Value* widen(llvm::Value* v) { return ir.CreateZExt(v, int_type); }
+  llvm::Value* test(llvm::Value* v) { return ir.CreateICmpNE(v, constant(0)); }
+  llvm::Value* global(Slot);
+  llvm::Value* address(Expr const*);
+  llvm::Value* local(char const*);
+  llvm::Value* divide(Binary_expr const*, llvm::Value*, llvm::Value*);
+  llvm::Value* pop();
+  void         expr(Expr const*);
+  void         condition(Expr const*);
+  void         stmt(Stmt const*);
+  void         run();
+  bool         value(Task&);
+  bool         logical(Task&);
+  bool         exec(Task&);
+  void         start(llvm::Function*);
+  void         resume(char const*);
+
+  llvm::LLVMContext& cxt;
+  llvm::Module&      mod;
+  llvm::IRBuilder<>  ir;
+  llvm::Type*        int_type;
+  Value*             globals;
+  llvm::Function*    fn;       // The current function
+
+  std::unordered_map<Function_decl const*, llvm::Function*> fns;
+  std::unordered_map<Decl const*, llvm::Value*>             locals;
+  std::vector<Function_decl const*>                         work;
+  std::vector<Task>                                         tasks;  // Tasks in progress
+  std::vector<llvm::Value*>                                 values; // Values of tasks
+};
+
+
+// Returns the declaration of the function `f`, adding it to the
+// work list if it has not been declared. All functions have
+// internal linkage, so they may be inlined or removed.
+llvm::Function*
+Generator::function(Function_decl const* f)
+{
+  auto iter = fns.find(f);
+  if (iter != fns.end())
+    return iter->second;
+
+  std::vector<llvm::Type*> parms(f->parameters().size(), int_type);
+  llvm::FunctionType* t = llvm::FunctionType::get(int_type, parms, false);
+  llvm::Function* g = llvm::Function::Create(
+    t, llvm::Function::InternalLinkage, f->name()->c_str(), mod);
+  fns.emplace(f, g);
+  work.push_back(f);
+  return g;
+}
+
+
+// Begin generating the body of `f`.
+void
+Generator::start(llvm::Function* f)
+{
+  fn = f;
+  locals.clear();
+  ir.SetInsertPoint(llvm::BasicBlock::Create(cxt, "entry", f));
+}
+
+
+// Continue after a return, in a block that is unreachable.
+void
+Generator::resume(char const* name)
+{
+  ir.SetInsertPoint(llvm::BasicBlock::Create(cxt, name, fn));
+}
+
+
+// Returns the entry point of the function `f`, which loads the
+// arguments of `f` from an array.
+llvm::Function*
+Generator::entry(Function_decl const* f)
+{
+  llvm::Type* arg = llvm::PointerType::getUnqual(int_type);
+  llvm::FunctionType* t = llvm::FunctionType::get(int_type, {arg}, false);
+  llvm::Function* e = llvm::Function::Create(
+    t, llvm::Function::ExternalLinkage, "entry", mod);
+  llvm::Function* g = function(f);
+
+  start(e);
+  std::vector<llvm::Value*> args;
+  for (std::size_t i = 0; i < f->parameters().size(); ++i) {
+    llvm::Value* p = ir.CreateConstGEP1_64(int_type, e->getArg(0), i);
+    args.push_back(ir.CreateLoad(int_type, p));
+  }
+  ir.CreateRet(ir.CreateCall(g, args));
+  return e;
+}
+
+
+// Returns an entry point that initializes the global variables
+// of `u`, in order of declaration.
+llvm::Function*
+Generator::init(Unit const* u)
+{
+  llvm::Type* arg = llvm::PointerType::getUnqual(int_type);
+  llvm::FunctionType* t = llvm::FunctionType::get(int_type, {arg}, false);
+  llvm::Function* e = llvm::Function::Create(
+    t, llvm::Function::ExternalLinkage, "entry", mod);
+
+  start(e);
+  for (Decl const* d : u->declarations()) {
+    if (Variable_decl const* v = as<Variable_decl>(d)) {
+      if (v->initializer()) {
+        expr(v->initializer());
+        run();
+        ir.CreateStore(pop(), global(v->slot()));
+      }
+    }
+  }
+  ir.CreateRet(constant(0));
+  return e;
+}
+
+
+// Define the function `f`. Control that reaches the end of a
+// function returns 0.
+void
+Generator::define(Function_decl const* f)
+{
+  llvm::Function* g = fns[f];
+  start(g);
+  Decl_seq const& parms = f->parameters();
+  for (std::size_t i = 0; i < parms.size(); ++i) {
+    llvm::Value* p = ir.CreateAlloca(int_type, nullptr, parms[i]->name()->c_str());
+    ir.CreateStore(g->getArg(i), p);
+    locals.emplace(parms[i], p);
+  }
+
+  Stmt const* s = f->body();
+  if (is_valid_node(s)) {
+    stmt(s);
+    run();
+  } else {
+    error(f->location(), "'{}' is not defined", f->name());
+  }
+  if (!ir.GetInsertBlock()->getTerminator())
+    ir.CreateRet(constant(0));
+}
+
+
+// Define functions until no more are called.
+void
+Generator::define_all()
+{
+  for (std::size_t i = 0; i < work.size(); ++i)
+    define(work[i]);
+}
+
+
+// Returns the address of the global variable in the slot `s`,
+// which is a constant.
+llvm::Value*
+Generator::global(Slot s)
+{
+  llvm::Value* p = constant(reinterpret_cast<std::intptr_t>(globals + s.offset));
+  return ir.CreateIntToPtr(p, llvm::PointerType::getUnqual(int_type));
+}
+
+
+// Returns the address of the variable or parameter named by the
+// identifier `e`. A local variable or parameter of an enclosing
+// function has no address in this function. That is diagnosed,
+// and the address of a new variable is returned instead.
+llvm::Value*
+Generator::address(Expr const* e)
+{
+  Decl const* d = cast<Identifier_expr>(e)->decl();
+  if (Variable_decl const* v = as<Variable_decl>(d)) {
+    if (v->slot().global)
+      return global(v->slot());
+  }
+  auto iter = locals.find(d);
+  if (iter == locals.end()) {
+    error(e->location(), "'{}' is local to an enclosing function", d->name());
+    return local(d->name()->c_str());
+  }
+  return iter->second;
+}
+
+
+// Returns the address of a new variable, allocated in the entry
+// block of the current function.
+llvm::Value*
+Generator::local(char const* name)
+{
+  llvm::IRBuilder<> top(&fn->getEntryBlock(), fn->getEntryBlock().begin());
+  return top.CreateAlloca(int_type, nullptr, name);
+}
+
+
+// Returns the value on the top of the stack, removing it.
+llvm::Value*
+Generator::pop()
+{
+  llvm::Value* v = values.back();
+  values.pop_back();
+  return v;
+}
+
+
+// Compute the value of `e` as a 64-bit integer.
+void
+Generator::expr(Expr const* e)
+{
+  tasks.push_back(Task{value_task, e, nullptr, 0, {}});
+}
+
+
+// Compute the value of the condition `e` as a 1-bit integer.
+void
+Generator::condition(Expr const* e)
+{
+  tasks.push_back(Task{condition_task, e, nullptr, 0, {}});
+}
+
+
+// Generate the statement `s`.
+void
+Generator::stmt(Stmt const* s)
+{
+  tasks.push_back(Task{stmt_task, nullptr, s, 0, {}});
+}
+
+
+// Run the tasks on the stack. A task is updated in a copy,
+// since the tasks of its parts are added to the stack.
+void
+Generator::run()
+{
+  while (!tasks.empty()) {
+    std::size_t i = tasks.size() - 1;
+    Task t = tasks[i];
+    bool done;
+    if (t.kind == value_task)
+      done = value(t);
+    else if (t.kind == condition_task)
+      done = logical(t);
+    else
+      done = exec(t);
+    if (done)
+      tasks.pop_back();
+    else
+      tasks[i] = t;
+  }
+}
+
+
+// Advance the computation of an expression. Returns true when
+// its value is on the stack.
+bool
+Generator::value(Task& t)
+{
+  Expr const* e = t.expr;
+  switch (e->kind()) {
+    case constant_expr_kind:
+      values.push_back(constant(cast<Constant_expr>(e)->value()));
+      return true;
+
+    case identifier_expr_kind: {
+      Decl const* d = cast<Identifier_expr>(e)->decl();
+      if (is<Function_decl>(d)) {
+        error(e->location(), "'{}' is not an object", d->name());
+        values.push_back(constant(0));
+        return true;
+      }
+      values.push_back(ir.CreateLoad(int_type, address(e)));
+      return true;
+    }
+
+    case unary_expr_kind: {
+      Unary_expr const* u = cast<Unary_expr>(e);
+      if (t.state++ == 0) {
+        expr(u->arg());
+        return false;
+      }
+      llvm::Value* v = pop();
+      switch (u->op()) {
+        case num_neg_op: v = ir.CreateNeg(v); break;
+        case num_pos_op: break;
+        case bit_not_op: v = ir.CreateNot(v); break;
+        case log_not_op: v = widen(ir.CreateICmpEQ(v, constant(0))); break;
+      }
+      values.push_back(v);
+      return true;
+    }
+
+    case binary_expr_kind: {
+      Binary_expr const* b = cast<Binary_expr>(e);
+      if (b->op() == log_and_op || b->op() == log_or_op) {
+        if (t.state++ == 0) {
+          condition(e);
+          return false;
+        }
+        values.push_back(widen(pop()));
+        return true;
+      }
+      switch (t.state++) {
+        case 0:
+          expr(b->left());
+          return false;
+        case 1:
+          expr(b->right());
+          return false;
+      }
+      llvm::Value* v2 = pop();
+      llvm::Value* v1 = pop();
+      llvm::Value* v;
+      switch (b->op()) {
+        case num_add_op: v = ir.CreateAdd(v1, v2); break;
+        case num_sub_op: v = ir.CreateSub(v1, v2); break;
+        case num_mul_op: v = ir.CreateMul(v1, v2); break;
+        case num_div_op: v = divide(b, v1, v2); break;
+        case num_mod_op: v = divide(b, v1, v2); break;
+        case bit_and_op: v = ir.CreateAnd(v1, v2); break;
+        case bit_or_op: v = ir.CreateOr(v1, v2); break;
+        case bit_xor_op: v = ir.CreateXor(v1, v2); break;
+        case bit_lsh_op: v = ir.CreateShl(v1, v2); break;
+        case bit_rsh_op: v = ir.CreateAShr(v1, v2); break;
+        case rel_eq_op: v = widen(ir.CreateICmpEQ(v1, v2)); break;
+        case rel_ne_op: v = widen(ir.CreateICmpNE(v1, v2)); break;
+        case rel_lt_op: v = widen(ir.CreateICmpSLT(v1, v2)); break;
+        case rel_gt_op: v = widen(ir.CreateICmpSGT(v1, v2)); break;
+        case rel_le_op: v = widen(ir.CreateICmpSLE(v1, v2)); break;
+        case rel_ge_op: v = widen(ir.CreateICmpSGE(v1, v2)); break;
+        default: lingo_unreachable();
+      }
+      values.push_back(v);
+      return true;
+    }
+
+    case call_expr_kind: {
+      Call_expr const* c = cast<Call_expr>(e);
+      Function_decl const* f = nullptr;
+      if (Identifier_expr const* id = as<Identifier_expr>(c->function()))
+        f = as<Function_decl>(id->decl());
+      if (!f) {
+        error(c->location(), "indirect calls are not supported");
+        values.push_back(constant(0));
+        return true;
+      }
+      Expr_seq const& args = c->arguments();
+      if (t.state < int(args.size())) {
+        expr(args[t.state++]);
+        return false;
+      }
+      auto first = values.end() - args.size();
+      std::vector<llvm::Value*> vs(first, values.end());
+      values.erase(first, values.end());
+      values.push_back(ir.CreateCall(function(f), vs));
+      return true;
+    }
+
+    default:
+      lingo_unreachable();
+  }
+}
+
+
+// Advance the computation of a condition. The value of && or ||
+// is computed by evaluating the right operand only when the left
+// does not decide the result. The block of the left operand and
+// the block that joins them are kept in `blocks`.
+bool
+Generator::logical(Task& t)
+{
+  Binary_expr const* b = as<Binary_expr>(t.expr);
+  if (!b || (b->op() != log_and_op && b->op() != log_or_op)) {
+    if (t.state++ == 0) {
+      expr(t.expr);
+      return false;
+    }
+    values.push_back(test(pop()));
+    return true;
+  }
+
+  bool is_and = b->op() == log_and_op;
+  switch (t.state++) {
+    case 0:
+      condition(b->left());
+      return false;
+
+    case 1: {
+      llvm::Value* v1 = pop();
+      llvm::BasicBlock* left = ir.GetInsertBlock();
+      llvm::BasicBlock* right = llvm::BasicBlock::Create(cxt, "rhs", fn);
+      llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "done", fn);
+      if (is_and)
+        ir.CreateCondBr(v1, right, done);
+      else
+        ir.CreateCondBr(v1, done, right);
+      ir.SetInsertPoint(right);
+      t.blocks[0] = left;
+      t.blocks[1] = done;
+      condition(b->right());
+      return false;
+    }
+
+    default: {
+      llvm::Value* v2 = pop();
+      llvm::BasicBlock* right = ir.GetInsertBlock();
+      llvm::BasicBlock* done = t.blocks[1];
+      ir.CreateBr(done);
+      ir.SetInsertPoint(done);
+      llvm::PHINode* phi = ir.CreatePHI(llvm::Type::getInt1Ty(cxt), 2);
+      phi->addIncoming(ir.getInt1(!is_and), t.blocks[0]);
+      phi->addIncoming(v2, right);
+      values.push_back(phi);
+      return true;
+    }
+  }
+}
+
+
+// Returns the quotient or remainder of `v1` and `v2`. As in the
+// machine, division by 0 is diagnosed and yields 0.
+llvm::Value*
+Generator::divide(Binary_expr const* e, llvm::Value* v1, llvm::Value* v2)
+{
+  llvm::BasicBlock* fail = llvm::BasicBlock::Create(cxt, "divzero", fn);
+  llvm::BasicBlock* ok = llvm::BasicBlock::Create(cxt, "div", fn);
+  llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "enddiv", fn);
+  ir.CreateCondBr(ir.CreateICmpEQ(v2, constant(0)), fail, ok);
+
+  ir.SetInsertPoint(fail);
+  llvm::FunctionType* t = llvm::FunctionType::get(llvm::Type::getVoidTy(cxt), false);
+  llvm::Value* p = constant(reinterpret_cast<std::intptr_t>(&divide_by_zero));
+  ir.CreateCall(t, ir.CreateIntToPtr(p, llvm::PointerType::getUnqual(t)));
+  ir.CreateBr(done);
+
+  ir.SetInsertPoint(ok);
+  llvm::Value* q = e->op() == num_div_op
+                 ? ir.CreateSDiv(v1, v2)
+                 : ir.CreateSRem(v1, v2);
+  ir.CreateBr(done);
+
+  ir.SetInsertPoint(done);
+  llvm::PHINode* phi = ir.CreatePHI(int_type, 2);
+  phi->addIncoming(constant(0), fail);
+  phi->addIncoming(q, ok);
+  return phi;
+}
+
+
+// Advance the generation of a statement. Returns true when the
+// statement is generated. The blocks of branches are created
+// before their parts, and kept in `blocks`.
+bool
+Generator::exec(Task& t)
+{
+  Stmt const* s = t.stmt;
+  llvm::BasicBlock** bs = t.blocks;
+  switch (s->kind()) {
+    case empty_stmt_kind:
+      return true;
+
+    case declaration_stmt_kind: {
+      // Nested functions are defined when they are called.
+      Decl const* d = cast<Declaration_stmt>(s)->decl();
+      if (Variable_decl const* v = as<Variable_decl>(d)) {
+        if (t.state++ == 0) {
+          locals[v] = local(v->name()->c_str());
+          if (v->initializer()) {
+            expr(v->initializer());
+            return false;
+          }
+          values.push_back(constant(0));
+        }
+        ir.CreateStore(pop(), locals[v]);
+      }
+      return true;
+    }
+
+    case expression_stmt_kind:
+      if (t.state++ == 0) {
+        expr(cast<Expression_stmt>(s)->expr());
+        return false;
+      }
+      pop();
+      return true;
+
+    case assignment_stmt_kind: {
+      Assignment_stmt const* a = cast<Assignment_stmt>(s);
+      if (t.state++ == 0) {
+        expr(a->rhs());
+        return false;
+      }
+      llvm::Value* x = pop();
+      ir.CreateStore(x, address(a->lhs()));
+      return true;
+    }
+
+    case if_then_stmt_kind: {
+      If_then_stmt const* s1 = cast<If_then_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          bs[0] = llvm::BasicBlock::Create(cxt, "then", fn);
+          bs[1] = llvm::BasicBlock::Create(cxt, "endif", fn);
+          condition(s1->condition());
+          return false;
+        case 1:
+          ir.CreateCondBr(pop(), bs[0], bs[1]);
+          ir.SetInsertPoint(bs[0]);
+          stmt(s1->branch());
+          return false;
+        default:
+          ir.CreateBr(bs[1]);
+          ir.SetInsertPoint(bs[1]);
+          return true;
+      }
+    }
+
+    case if_else_stmt_kind: {
+      If_else_stmt const* s1 = cast<If_else_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          bs[0] = llvm::BasicBlock::Create(cxt, "then", fn);
+          bs[1] = llvm::BasicBlock::Create(cxt, "else", fn);
+          bs[2] = llvm::BasicBlock::Create(cxt, "endif", fn);
+          condition(s1->condition());
+          return false;
+        case 1:
+          ir.CreateCondBr(pop(), bs[0], bs[1]);
+          ir.SetInsertPoint(bs[0]);
+          stmt(s1->true_branch());
+          return false;
+        case 2:
+          ir.CreateBr(bs[2]);
+          ir.SetInsertPoint(bs[1]);
+          stmt(s1->false_branch());
+          return false;
+        default:
+          ir.CreateBr(bs[2]);
+          ir.SetInsertPoint(bs[2]);
+          return true;
+      }
+    }
+
+    case while_stmt_kind: {
+      While_stmt const* s1 = cast<While_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          bs[0] = llvm::BasicBlock::Create(cxt, "while", fn);
+          bs[1] = llvm::BasicBlock::Create(cxt, "body", fn);
+          bs[2] = llvm::BasicBlock::Create(cxt, "endwhile", fn);
+          ir.CreateBr(bs[0]);
+          ir.SetInsertPoint(bs[0]);
+          condition(s1->condition());
+          return false;
+        case 1:
+          ir.CreateCondBr(pop(), bs[1], bs[2]);
+          ir.SetInsertPoint(bs[1]);
+          stmt(s1->body());
+          return false;
+        default:
+          ir.CreateBr(bs[0]);
+          ir.SetInsertPoint(bs[2]);
+          return true;
+      }
+    }
+
+    case do_stmt_kind: {
+      Do_stmt const* s1 = cast<Do_stmt>(s);
+      switch (t.state++) {
+        case 0:
+          bs[0] = llvm::BasicBlock::Create(cxt, "do", fn);
+          bs[1] = llvm::BasicBlock::Create(cxt, "enddo", fn);
+          ir.CreateBr(bs[0]);
+          ir.SetInsertPoint(bs[0]);
+          stmt(s1->body());
+          return false;
+        case 1:
+          condition(s1->condition());
+          return false;
+        default:
+          ir.CreateCondBr(pop(), bs[0], bs[1]);
+          ir.SetInsertPoint(bs[1]);
+          return true;
+      }
+    }
+
+    case exit_stmt_kind:
+      ir.CreateRet(constant(0));
+      resume("exit");
+      return true;
+
+    case return_stmt_kind:
+      if (t.state++ == 0) {
+        expr(cast<Return_stmt>(s)->result());
+        return false;
+      }
+      ir.CreateRet(pop());
+      resume("return");
+      return true;
+
+    case block_stmt_kind: {
+      Stmt_seq const& ss = cast<Block_stmt>(s)->statements();
+      if (t.state < int(ss.size())) {
+        stmt(ss[t.state++]);
+        return false;
+      }
+      return true;
+    }
+  }
+  lingo_unreachable();
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Compilation
+
+std::once_flag native_target;
+
+
+// Run the pass pipeline `p` over the module `m`.
+bool
+optimize(llvm::Module& m, std::string const& p)
+{
+  if (p.empty())
+    return true;
+
+  llvm::LoopAnalysisManager lam;
+  llvm::FunctionAnalysisManager fam;
+  llvm::CGSCCAnalysisManager cgam;
+  llvm::ModuleAnalysisManager mam;
+  llvm::PassBuilder pb;
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  llvm::ModulePassManager mpm;
+  if (llvm::Error err = pb.parsePassPipeline(mpm, p)) {
+    error("invalid pass pipeline '{}': {}", p, llvm::toString(std::move(err)));
+    return false;
+  }
+  mpm.run(m, mam);
+  return true;
+}
+
+
+// Returns the entry point of a module, generated by `gen`, or
+// nullptr if the module cannot be compiled.
+template<typename F>
+Jit::Entry
+compile_module(Jit& j, F gen)
+{
+  llvm::orc::LLJIT* jit = j.state->get();
+  if (!jit)
+    return nullptr;
+
+  auto cxt = std::make_unique<llvm::LLVMContext>();
+  auto mod = std::make_unique<llvm::Module>("beaker", *cxt);
+  mod->setDataLayout(jit->getDataLayout());
+
+  Generator g(*cxt, *mod, j.globals);
+  gen(g);
+  g.define_all();
+
+  std::string msg;
+  llvm::raw_string_ostream os(msg);
+  if (llvm::verifyModule(*mod, &os)) {
+    error("invalid module: {}", os.str());
+    return nullptr;
+  }
+  if (!optimize(*mod, j.options.pipeline))
+    return nullptr;
+
+  // Each module has its own library, so that the names of entry
+  // points and functions do not conflict.
+  std::string name = "beaker." + std::to_string(j.state->modules++);
+  auto lib = jit->createJITDylib(name);
+  if (!lib) {
+    error("cannot create library: {}", llvm::toString(lib.takeError()));
+    return nullptr;
+  }
+  llvm::orc::ThreadSafeModule tsm(std::move(mod), std::move(cxt));
+  if (llvm::Error err = jit->addIRModule(*lib, std::move(tsm))) {
+    error("cannot add module: {}", llvm::toString(std::move(err)));
+    return nullptr;
+  }
+  auto sym = jit->lookup(*lib, "entry");
+  if (!sym) {
+    error("cannot compile module: {}", llvm::toString(sym.takeError()));
+    return nullptr;
+  }
+  return reinterpret_cast<Jit::Entry>(sym->getAddress());
+}
+
+
+} // namespace
+
+
+// Construct a JIT that owns the globals of `u`.
+Jit::Jit(Unit const* u, Jit_options const& opts)
+  : Jit(u, nullptr, opts)
+{
+  int n = 0;
+  for (Decl const* d : u->declarations())
+    if (is<Variable_decl>(d))
+      ++n;
+  store.resize(n);
+  globals = store.data();
+  if (n == 0)
+    return;
+  if (Entry e = compile_module(*this, [u](Generator& g) { g.init(u); }))
+    e(nullptr);
+}
+
+
+// Construct a JIT that shares the array of globals `g`. The
+// globals are not initialized.
+Jit::Jit(Unit const* u, Value* g, Jit_options const& opts)
+  : unit(u), options(opts), globals(g), state(new Jit_state())
+{
+  std::call_once(native_target, []() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+
+  allocate_slots(u);
+  state->modules = 0;
+}
+
+
+Jit::~Jit()
+{ }
+
+
+// Returns the entry point of the function `f`, compiling it if
+// needed. Returns nullptr if `f` cannot be compiled.
+Jit::Entry
+Jit::compile(Function_decl const* f)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = entries.find(f);
+    if (iter != entries.end())
+      return iter->second;
+  }
+  Entry e = compile_module(*this, [f](Generator& g) { g.entry(f); });
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.emplace(f, e).first->second;
+}
+
+
+// Call the function `f` with the given arguments.
+Value
+Jit::call(Function_decl const* f, Value_seq const& args)
+{
+  if (args.size() != f->parameters().size()) {
+    error(f->location(), "'{}' expects {} arguments but got {}",
+          f->name(), f->parameters().size(), args.size());
+    return 0;
+  }
+  Entry e = compile(f);
+  if (!e)
+    return 0;
+  return e(args.data());
+}
+
+
+// Run the program `u`, starting with the function named `name`
+// and the given arguments, as native code. Returns the value
+// returned by that function.
+Value
+run_jit(Unit const* u, char const* name, Value_seq const& args, Jit_options const& opts)
+{
+  Function_decl const* f = find_function(u, name);
+  if (!f) {
+    error("no function named '{}'", name);
+    return 0;
+  }
+  Jit j(u, opts);
+  return j.call(f, args);
+}
+
+
+} // namespace beaker
@@ -0,0 +1,88 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_JIT_HPP
+#define BEAKER_JIT_HPP
+
+// This module compiles functions to native code in memory, using
+// the LLVM C++ API, and runs them through the ORC JIT. It is
+// available when the build is configured with BEAKER_LLVM_JIT.
+//
+// Each compiled function is given an entry point that takes its
+// arguments as an array of values, so that functions of any
+// arity can be called from the interpreters. All values are
+// 64-bit integers in compiled code.
+//
+// Global variables are not owned by compiled code. They are
+// stored in an array of values indexed by their slots (see
+// Slot in decl.hpp), which may be shared with a machine.
+//
+// As in the interpreters, division by 0 is diagnosed at runtime,
+// and yields 0.
+
+#include "beaker/prelude.hpp"
+#include "beaker/value.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace beaker
+{
+
+// Options for compilation. The pass pipeline is given in the
+// syntax of LLVM's opt tool (e.g., "default<O3>", or
+// "mem2reg,instcombine"). An empty pipeline disables
+// optimization.
+struct Jit_options
+{
+  Jit_options()
+    : pipeline("default<O2>")
+  { }
+
+  std::string pipeline;
+};
+
+
+struct Jit_state;
+
+
+// The JIT compiles the functions of a unit on request. Each
+// function is compiled with the functions it calls into a
+// single module, so that calls can be inlined.
+//
+// When constructed without an array of globals, the JIT owns
+// its globals, and initializes them by compiling and running
+// their initializers.
+//
+// Functions may be compiled and called concurrently.
+struct Jit
+{
+  using Entry = Value (*)(Value const*);
+
+  explicit Jit(Unit const*, Jit_options const& = {});
+  Jit(Unit const*, Value*, Jit_options const& = {});
+  ~Jit();
+
+  Entry compile(Function_decl const*);
+  Value call(Function_decl const*, Value_seq const&);
+
+  Unit const*                 unit;
+  Jit_options                 options;
+  Value_seq                   store;   // Owned globals, if any
+  Value*                      globals; // The array of globals
+  std::unique_ptr<Jit_state>  state;   // LLVM objects
+  std::mutex                  mutex;   // Guards entries
+  std::unordered_map<Function_decl const*, Entry> entries;
+};
+
+
+Value run_jit(Unit const*, char const*, Value_seq const& = {}, Jit_options const& = {});
+
+
+} // namespace beaker
+
+
+#endif
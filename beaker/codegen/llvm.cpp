@@ -8,6 +8,7 @@
 #include "beaker/decl.hpp"
 #include "beaker/stmt.hpp"
 #include "beaker/unit.hpp"
+#include "beaker/context.hpp"
 
 
 namespace beaker
@@ -98,10 +99,13 @@ llvm_function_def(Printer& p, Function_decl const* d)
 }
 
 
-// Emit a function definition.
+// Emit a function definition. Functions whose deferred bodies
+// failed to parse or check are not defined, and are omitted.
 void
 llvm_global(Printer& p, Function_decl const* d)
 {
+  if (!is_valid_node(d->body()))
+    return;
   print(p, "define ");
   llvm_type(p, d->return_type());
   print(p, "@{}", d->name());
@@ -140,14 +144,23 @@ llvm_global(Printer& p, Decl const* d)
 
 
 void
-to_llvm(std::ostream&, Unit const* u)
+to_llvm(std::ostream& os, Unit const* u)
 {
-  Printer p(std::cout); // FIXME: Use an output file.
+  Printer p(os);
   for (Decl const* d : u->declarations()) {
     llvm_global(p, d);
   }
 }
 
 
+// Translate the unit within the given compilation context.
+void
+to_llvm(Context& cxt, std::ostream& os, Unit const* u)
+{
+  Use_context use(cxt);
+  to_llvm(os, u);
+}
+
+
 
 } // namespace beaker
@@ -17,6 +17,7 @@ namespace beaker
 {
 
 void to_llvm(std::ostream&, Unit const*);
+void to_llvm(Context&, std::ostream&, Unit const*);
 
 
 } // namespace beaker
@@ -3,9 +3,8 @@
 
 #include "beaker/compact.hpp"
 #include "beaker/expr.hpp"
-#include "beaker/less.hpp"
-
-#include <set>
+#include "beaker/hash.hpp"
+#include "beaker/arena.hpp"
 
 
 namespace beaker
@@ -14,100 +13,221 @@ namespace beaker
 namespace
 {
 
-// FIXME: Use a hash set. Of course that means we have
-// to define a hash function.
-using Leaf_set = std::set<Expr const*, Term_less>;
+// -------------------------------------------------------------------------- //
+//                            Hash-consing
+//
+// Compaction rebuilds an expression bottom-up. Because the
+// operands of each node are compacted first, two nodes are
+// equivalent exactly when they have the same kind and attributes
+// and the same operands (by address). This lets each node be
+// hashed and compared in constant time. Types are unique, so
+// they are also compared by address.
+//
+// The structural hash of hash.hpp is not used here because it
+// visits the entire subexpression of each node.
+
+
+// An open-addressed hash table of compacted nodes. Each
+// entry stores the hash of its node so that most failed
+// comparisons are resolved without touching the node.
+struct Node_table
+{
+  struct Entry
+  {
+    std::size_t hash;
+    Expr const* expr;
+  };
+
+  Node_table()
+    : slots_(256, Entry{0, nullptr}), size_(0)
+  { }
+
+  template<typename T, typename Eq>
+  Expr const* intern(T const*, std::size_t, bool, Eq);
+
+  void grow();
+
+  std::vector<Entry> slots_;
+  std::size_t        size_;
+};
+
+
+// Returns the node in the table that is equivalent to `e`,
+// whose hash is `h`. If there is no such node, `e` is added to
+// the table. When `e` is a temporary, a copy is allocated and
+// added instead. The function `eq` compares `e` with another
+// node of type T.
+template<typename T, typename Eq>
+Expr const*
+Node_table::intern(T const* e, std::size_t h, bool temp, Eq eq)
+{
+  std::size_t mask = slots_.size() - 1;
+  std::size_t i = h & mask;
+  while (Expr const* x = slots_[i].expr) {
+    if (slots_[i].hash == h && x->kind() == T::node_kind && eq(e, static_cast<T const*>(x)))
+      return x;
+    i = (i + 1) & mask;
+  }
+  if (temp)
+    e = get_arena().make<T>(*e);
+  slots_[i] = Entry{h, e};
+  if (++size_ * 2 > slots_.size())
+    grow();
+  return e;
+}
+
+
+// Double the capacity of the table.
+void
+Node_table::grow()
+{
+  std::vector<Entry> old(slots_.size() * 2, Entry{0, nullptr});
+  old.swap(slots_);
+  std::size_t mask = slots_.size() - 1;
+  for (Entry const& x : old) {
+    if (x.expr) {
+      std::size_t i = x.hash & mask;
+      while (slots_[i].expr)
+        i = (i + 1) & mask;
+      slots_[i] = x;
+    }
+  }
+}
+
+
+// Distinguishes the hashes of different kinds of nodes.
+enum Node_seed : std::size_t
+{
+  constant_seed = 1,
+  identifier_seed,
+  unary_seed,
+  binary_seed,
+  call_seed,
+};
 
 
-Expr const* compact(Leaf_set&, Expr const*);
+Expr const* compact(Node_table&, Expr const*);
 
 
-// Insert the constant expression into the leaf set.
 Expr const*
-compact(Leaf_set& leaf, Constant_expr const* e)
+compact(Node_table& tab, Constant_expr const* e)
 {
-  return *leaf.insert(e).first;
+  std::size_t h = hash_combine(constant_seed, hash_value(e->type()));
+  h = hash_combine(h, hash_value(e->value()));
+  return tab.intern(e, h, false, [](Constant_expr const* a, Constant_expr const* b) {
+    return a->type() == b->type() && a->value() == b->value();
+  });
 }
 
 
-// Insert the identifier expression into the leaf set.
 Expr const*
-compact(Leaf_set& leaf, Identifier_expr const* e)
+compact(Node_table& tab, Identifier_expr const* e)
 {
-  return *leaf.insert(e).first;
+  std::size_t h = hash_combine(identifier_seed, hash_value(e->decl()));
+  return tab.intern(e, h, false, [](Identifier_expr const* a, Identifier_expr const* b) {
+    return a->decl() == b->decl();
+  });
 }
 
 
-// FIXME: I should be able to explicitly specify the types
-// for these expression constructors. Otherwise, we're going
-// to do a bunch of redundant checking when we compact an
-// expression.
+// Note that compacted nodes have the same types as the
+// originals, so new nodes are built directly rather than
+// being checked again.
 
 
-// Build a new unary expression.
 Expr const*
-compact(Leaf_set& leaf, Unary_expr const* e)
+compact(Node_table& tab, Unary_expr const* e)
 {
-  Expr const* e1 = compact(e->arg());
-  return make_unary_expr(e->op(), e1);
+  auto eq = [](Unary_expr const* a, Unary_expr const* b) {
+    return a->op() == b->op() && a->arg() == b->arg();
+  };
+  Expr const* e1 = compact(tab, e->arg());
+  std::size_t h = hash_combine(unary_seed, hash_value<int>(e->op()));
+  h = hash_combine(h, hash_value(e1));
+  if (e1 == e->arg())
+    return tab.intern(e, h, false, eq);
+  Unary_expr k(e->location(), e->type(), e->op(), e1);
+  return tab.intern(&k, h, true, eq);
 }
 
 
-// Build a new binary expression.
 Expr const*
-compact(Leaf_set& leaf, Binary_expr const* e)
+compact(Node_table& tab, Binary_expr const* e)
 {
-  Expr const* e1 = compact(leaf, e->left());
-  Expr const* e2 = compact(leaf, e->right());
-  return make_binary_expr(e->op(), e1, e2);
+  auto eq = [](Binary_expr const* a, Binary_expr const* b) {
+    return a->op() == b->op() && a->left() == b->left() && a->right() == b->right();
+  };
+  Expr const* e1 = compact(tab, e->left());
+  Expr const* e2 = compact(tab, e->right());
+  std::size_t h = hash_combine(binary_seed, hash_value<int>(e->op()));
+  h = hash_combine(h, hash_value(e1));
+  h = hash_combine(h, hash_value(e2));
+  if (e1 == e->left() && e2 == e->right())
+    return tab.intern(e, h, false, eq);
+  Binary_expr k(e->location(), e->type(), e->op(), e1, e2);
+  return tab.intern(&k, h, true, eq);
 }
 
 
 Expr const*
-compact(Leaf_set& leaf, Call_expr const* e)
+compact(Node_table& tab, Call_expr const* e)
 {
-  Expr const* f = compact(leaf, e->function());
+  auto eq = [](Call_expr const* a, Call_expr const* b) {
+    return a->function() == b->function() && a->arguments() == b->arguments();
+  };
+  Expr const* f = compact(tab, e->function());
+  bool unchanged = f == e->function();
+  std::size_t h = hash_combine(call_seed, hash_value(f));
 
   Expr_seq args;
   args.reserve(e->arguments().size());
-  for (Expr const* ei : e->arguments())
-    args.push_back(compact(leaf, ei));
-
-  return make_call_expr(f, args);
+  for (Expr const* ei : e->arguments()) {
+    args.push_back(compact(tab, ei));
+    unchanged &= args.back() == ei;
+    h = hash_combine(h, hash_value(args.back()));
+  }
+
+  if (unchanged)
+    return tab.intern(e, h, false, eq);
+  Call_expr k(e->location(), e->type(), f, args);
+  return tab.intern(&k, h, true, eq);
 }
 
 
-// Compat an expression.
+// Compact an expression.
 Expr const*
-compact(Leaf_set& leaf, Expr const* e)
+compact(Node_table& tab, Expr const* e)
 {
   struct Fn
   {
-    Fn(Leaf_set& l)
-      : l(l)
+    Fn(Node_table& t)
+      : t(t)
     { }
 
-    Expr const* operator()(Constant_expr const* e) const { return compact(l, e); }
-    Expr const* operator()(Identifier_expr const* e) const { return compact(l, e); }
-    Expr const* operator()(Unary_expr const* e) const { return compact(l, e); }
-    Expr const* operator()(Binary_expr const* e) const { return compact(l, e); }
-    Expr const* operator()(Call_expr const* e) const { return compact(l, e); }
+    Expr const* operator()(Constant_expr const* e) const { return compact(t, e); }
+    Expr const* operator()(Identifier_expr const* e) const { return compact(t, e); }
+    Expr const* operator()(Unary_expr const* e) const { return compact(t, e); }
+    Expr const* operator()(Binary_expr const* e) const { return compact(t, e); }
+    Expr const* operator()(Call_expr const* e) const { return compact(t, e); }
 
-    Leaf_set& l;
+    Node_table& t;
   };
 
-  return apply(e, Fn(leaf));
+  return apply(e, Fn(tab));
 }
 
 
 } // namespace
 
 
+// Returns a maximally shared representation of `e`. No two
+// nodes in the resulting graph are equivalent. Nodes of `e`
+// may be reused in the result.
 Expr const*
 compact(Expr const* e)
 {
-  Leaf_set leaf;
-  return compact(leaf, e);
+  Node_table tab;
+  return compact(tab, e);
 }
 
 } // namespace beaker
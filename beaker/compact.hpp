@@ -6,8 +6,8 @@
 
 // This module defines the compaction of expressions. It takes
 // an abstract syntax tree and produces a directed acyclic graph
-// of that tree such that common terminals are represented by
-// the same expression.
+// of that tree such that common subexpressions are represented
+// by the same expression.
 
 
 #include "beaker/prelude.hpp"
@@ -0,0 +1,50 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/context.hpp"
+
+
+namespace beaker
+{
+
+namespace
+{
+
+// The selected context of each thread, if any.
+thread_local Context* context_ = nullptr;
+
+} // namespace
+
+
+// Returns the context used by threads that have not selected
+// a context.
+Context&
+default_context()
+{
+  static Context cxt;
+  return cxt;
+}
+
+
+// Returns the current context of the calling thread.
+Context&
+current_context()
+{
+  return context_ ? *context_ : default_context();
+}
+
+
+Use_context::Use_context(Context& cxt)
+  : prev(context_)
+{
+  context_ = &cxt;
+}
+
+
+Use_context::~Use_context()
+{
+  context_ = prev;
+}
+
+
+} // namespace beaker
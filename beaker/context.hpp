@@ -0,0 +1,78 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_CONTEXT_HPP
+#define BEAKER_CONTEXT_HPP
+
+// The context module defines the state of a compilation. All
+// of the tables that are updated while lexing, parsing, and
+// translating a program are owned by a context, so programs
+// can be compiled concurrently in separate contexts.
+//
+// Each thread has a current context, which is selected with
+// Use_context. When no context has been selected, a default
+// context is used. The default context is shared by every
+// thread that does not select a context, and must not be used
+// concurrently.
+//
+// Each context also owns its diagnostics. Errors diagnosed in
+// the default context are emitted immediately (and counted by
+// lingo). Errors diagnosed in any other context are saved in
+// its log, so that concurrent compilations do not share the
+// count of errors or interleave their messages. The owner of a
+// context can emit them later, from another context.
+//
+// Note that lingo's symbol table is shared by all contexts (and
+// synchronized by the symbol table of each context). Likewise,
+// types are interned in a global table that is cached by the
+// type table of each context (see type.hpp), so the types of
+// different contexts can be compared, and a unit may outlive
+// the context in which it was compiled.
+
+#include "beaker/prelude.hpp"
+#include "beaker/token.hpp"
+#include "beaker/type.hpp"
+#include "beaker/lookup.hpp"
+#include "beaker/arena.hpp"
+#include "beaker/diagnostic.hpp"
+
+
+namespace beaker
+{
+
+// A compilation context.
+struct Context
+{
+  Context() = default;
+
+  Context(Context const&) = delete;
+  Context& operator=(Context const&) = delete;
+
+  Symbol_table   symbols;     // Symbols seen by the compilation
+  Type_table     types;       // Function and reference types
+  Environment    env;         // Name bindings and scopes
+  Arena          arena;       // Nodes created outside of a unit
+  Diagnostic_log diagnostics; // Saved errors
+  int            errors = 0;  // The number of errors diagnosed
+};
+
+
+Context& default_context();
+Context& current_context();
+
+
+// Within the lifetime of this object, the given context is
+// the current context of the calling thread.
+struct Use_context
+{
+  Use_context(Context&);
+  ~Use_context();
+
+  Context* prev;
+};
+
+
+} // namespace beaker
+
+
+#endif
@@ -7,6 +7,7 @@
 #include "beaker/variable.hpp"
 #include "beaker/function.hpp"
 #include "beaker/less.hpp"
+#include "beaker/arena.hpp"
 
 #include "lingo/symbol.hpp"
 #include "lingo/token.hpp"
@@ -21,7 +22,7 @@ namespace beaker
 
 
 Function_decl::Function_decl(Location loc, String const* n, Type const* t, Decl_seq const& a, Stmt const* b)
-  : Decl(loc, n, t), first(a), second(b)
+  : Decl(node_kind, loc, n, t), first(a), second(b), third(nullptr), fourth(0)
 { 
   lingo_assert(is<Function_type>(t));
 }
@@ -51,7 +52,7 @@ make_variable_decl(Location loc, String const* n, Type const* t, Expr const* e)
   Input_context cxt(loc);
   if (!check_initializer(t, e))
     return make_error_node<Variable_decl>();
-  return new Variable_decl(loc, n, t, e);
+  return get_arena().make<Variable_decl>(loc, n, t, e);
 }
 
 
@@ -60,7 +61,7 @@ make_variable_decl(Location loc, String const* n, Type const* t, Expr const* e)
 Variable_decl* 
 make_variable_decl(Location loc, String const* n, Type const* t)
 {
-  return new Variable_decl(loc, n, t, nullptr);
+  return get_arena().make<Variable_decl>(loc, n, t, nullptr);
 }
 
 
@@ -71,7 +72,7 @@ make_function_decl(Location loc, String const* n, Decl_seq const& p, Type const*
   Input_context cxt(loc);
   if (!check_definition(r, s))
     return make_error_node<Function_decl>();
-  return new Function_decl(loc, n, get_function_type(p, r), p, s);
+  return get_arena().make<Function_decl>(loc, n, get_function_type(p, r), p, s);
 }
 
 
@@ -80,7 +81,7 @@ make_function_decl(Location loc, String const* n, Decl_seq const& p, Type const*
 Function_decl*
 make_function_decl(Location loc, String const* n, Decl_seq const& p, Type const* r)
 {
-  return new Function_decl(loc, n, get_function_type(p, r), p, nullptr);
+  return get_arena().make<Function_decl>(loc, n, get_function_type(p, r), p, nullptr);
 }
 
 
@@ -90,7 +91,7 @@ make_function_decl(Location loc, String const* n, Decl_seq const& p, Type const*
 Parameter_decl*
 make_parameter_decl(Location loc, String const* n, Type const* t)
 {
-  return new Parameter_decl(loc, n, t);
+  return get_arena().make<Parameter_decl>(loc, n, t);
 }
 
 
@@ -18,6 +18,15 @@ namespace beaker
 struct Decl_visitor;
 
 
+// The kinds of declarations.
+enum Decl_kind
+{
+  variable_decl_kind,
+  function_decl_kind,
+  parameter_decl_kind,
+};
+
+
 // The Decl class is the base class of all declarations 
 // in the language. A declaration binds a symbol (identifier)
 // to its type, value, definition, etc.
@@ -30,8 +39,8 @@ struct Decl_visitor;
 // introduced by a keyword (e.g., `var`, or `def`).
 struct Decl
 {
-  Decl(Location l, String const* n, Type const* t)
-    : loc_(l), name_(n), type_(t)
+  Decl(Decl_kind k, Location l, String const* n, Type const* t)
+    : kind_(k), loc_(l), name_(n), type_(t)
   { }
 
   virtual ~Decl() { }
@@ -39,10 +48,12 @@ struct Decl
   // Accept a declaration visitor.
   virtual void accept(Decl_visitor&) const = 0;
   
+  Decl_kind     kind() const      { return kind_; }
   Location      location() const  { return loc_; }
   String const* name() const      { return name_; }
   Type const*   type() const      { return type_; }
 
+  Decl_kind     kind_;  // The kind of declaration
   Location      loc_;   // The token that begins the declaration
   String const* name_;  // The bound identifier
   Type const*   type_;  // The bound type
@@ -58,21 +69,61 @@ struct Decl_visitor
 };
 
 
+// The storage of a variable or parameter in an interpreted
+// program (see interpret.hpp). Global variables are stored in
+// the static store of the program, and local variables and
+// parameters in the frame of their function. The offset of
+// each object is assigned before the program is run, so names
+// are never looked up during execution.
+struct Slot
+{
+  Slot()
+    : global(false), offset(-1)
+  { }
+
+  Slot(bool g, int n)
+    : global(g), offset(n)
+  { }
+
+  bool global; // True if the object has static storage
+  int  offset; // The offset of the object in its store
+};
+
+
 // A variable declration introduces a named binding for a
 // value. Once bound, the name cannot be rebound.
 struct Variable_decl : Decl
 {
+  static constexpr Decl_kind node_kind = variable_decl_kind;
+
   Variable_decl(Location loc, String const* n, Type const* t, Expr const* e)
-    : Decl(loc, n, t), first(e)
+    : Decl(node_kind, loc, n, t), first(e)
   { }
 
   void accept(Decl_visitor& v) const { return v.visit(this); }
 
   Expr const* initializer() const { return first; }
+  Slot        slot() const        { return second; }
   
   void initialize(Expr const* e) { first = e; }
+  void allocate(Slot s)          { second = s; }
 
-  Expr const* first; // Initializer
+  Expr const* first;  // Initializer
+  Slot        second; // Storage
+};
+
+
+// The unparsed body of a function definition: the text of the
+// buffer from the opening brace at `first` up to (but not
+// including) `last`. The buffer must outlive the unit.
+struct Deferred_body
+{
+  Buffer*           buf;
+  int               first;
+  int               last;
+  Unit const*       unit;  // The unit containing the function
+  Decl_index const* index; // The declarations of the unit
+  std::size_t       pos;   // The position of the function in the unit
 };
 
 
@@ -80,32 +131,64 @@ struct Variable_decl : Decl
 // of inputs to an output. The parameters of a function
 // determine the types of inputs. The body of a function is
 // a statement that computes the result.
+//
+// The body of a function may be deferred (see parse.hpp). A
+// deferred body is parsed when it is first requested, which
+// modifies the function; bodies are not parsed concurrently.
 struct Function_decl : Decl
 {
+  static constexpr Decl_kind node_kind = function_decl_kind;
+
   Function_decl(Location, String const*, Type const*, Decl_seq const&, Stmt const*);
 
   void accept(Decl_visitor& v) const { return v.visit(this); }
 
   Decl_seq const&      parameters() const { return first; }
-  Stmt const*          body() const       { return second; }
+  Stmt const*          body() const;
   Function_type const* type() const;
   Type const*          return_type() const;
 
+  bool is_deferred() const { return third; }
+  int  frame_size() const  { return fourth; }
+
   void define(Stmt const* s) { second = s; }
+  void defer(Deferred_body* b) { third = b; }
+  void allocate(int n) { fourth = n; }
 
-  Decl_seq    first;  // Parameters
-  Stmt const* second; // Body
+  Decl_seq       first;  // Parameters
+  Stmt const*    second; // Body
+  Deferred_body* third;  // The unparsed body, if any
+  int            fourth; // The number of slots in a frame
 };
 
 
+Stmt const* parse_body(Function_decl const*);
+
+
+// Returns the body of the function, parsing it if it has
+// been deferred.
+inline Stmt const*
+Function_decl::body() const
+{
+  return third ? parse_body(this) : second;
+}
+
+
 // A parameter declaration.
 struct Parameter_decl : Decl
 {
+  static constexpr Decl_kind node_kind = parameter_decl_kind;
+
   Parameter_decl(Location loc, String const* n, Type const* t)
-    : Decl(loc, n, t)
+    : Decl(node_kind, loc, n, t)
   { }
 
   void accept(Decl_visitor& v) const { return v.visit(this); }
+
+  Slot slot() const     { return first; }
+  void allocate(Slot s) { first = s; }
+
+  Slot first; // Storage
 };
 
 
@@ -162,13 +245,38 @@ struct Generic_decl_visitor : Decl_visitor, Generic_visitor<F, T>
 };
 
 
-// Apply the function f to the statement s.
+// Apply the function f to the declaration d using the virtual
+// visitor. The return type is that of the function object F.
 template<typename F, typename T = typename std::result_of<F(Variable_decl*)>::type>
 inline T
-apply(Decl const* s, F fn)
+apply_visitor(Decl const* d, F fn)
 {
   Generic_decl_visitor<F, T> v(fn);
-  return accept(s, v);
+  return accept(d, v);
+}
+
+
+// Apply the function f to the declaration d. This dispatches on
+// the kind of d, which allows calls to f to be inlined. When
+// BEAKER_VIRTUAL_DISPATCH is defined, this uses the virtual
+// visitor instead.
+template<typename F, typename T = typename std::result_of<F(Variable_decl*)>::type>
+inline T
+apply(Decl const* d, F fn)
+{
+#ifdef BEAKER_VIRTUAL_DISPATCH
+  return apply_visitor<F, T>(d, fn);
+#else
+  switch (d->kind()) {
+  case variable_decl_kind:
+    return fn(static_cast<Variable_decl const*>(d));
+  case function_decl_kind:
+    return fn(static_cast<Function_decl const*>(d));
+  case parameter_decl_kind:
+    return fn(static_cast<Parameter_decl const*>(d));
+  }
+  lingo_unreachable();
+#endif
 }
 
 
@@ -0,0 +1,78 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/diagnostic.hpp"
+#include "beaker/context.hpp"
+
+
+namespace beaker
+{
+
+namespace
+{
+
+// The selected log of each thread, if any.
+thread_local Diagnostic_log* log_ = nullptr;
+
+} // namespace
+
+
+// Save an error diagnosed at `loc`.
+void
+Diagnostic_log::save(Location loc, std::string const& msg)
+{
+  entries.push_back(Entry{loc, msg});
+}
+
+
+// Report the saved errors in the current context, in the order
+// they were diagnosed. Note that a context's own log must be
+// emitted from another context.
+void
+Diagnostic_log::emit() const
+{
+  for (Entry const& e : entries)
+    report(e.loc, e.msg);
+}
+
+
+// Returns the log selected for the calling thread, or nullptr
+// if no log has been selected.
+Diagnostic_log*
+current_log()
+{
+  return log_;
+}
+
+
+// Report an error in the current context. In the default
+// context, the error is emitted. Otherwise, it is saved in the
+// context's log.
+void
+report(Location loc, std::string const& msg)
+{
+  Context& cxt = current_context();
+  ++cxt.errors;
+  if (&cxt != &default_context())
+    cxt.diagnostics.save(loc, msg);
+  else if (loc)
+    error(loc, "{}", msg);
+  else
+    error("{}", msg);
+}
+
+
+Use_diagnostic_log::Use_diagnostic_log(Diagnostic_log& log)
+  : prev(log_)
+{
+  log_ = &log;
+}
+
+
+Use_diagnostic_log::~Use_diagnostic_log()
+{
+  log_ = prev;
+}
+
+
+} // namespace beaker
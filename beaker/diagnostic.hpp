@@ -0,0 +1,86 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_DIAGNOSTIC_HPP
+#define BEAKER_DIAGNOSTIC_HPP
+
+// The diagnostic module supports the deferral of diagnostics.
+// The front end reports errors through diagnose(). When a log
+// has been selected for the calling thread, the error is saved
+// in that log, and it can be emitted later in a deterministic
+// order. This is used by checks that run concurrently (e.g., the
+// checking of function definitions). Otherwise, the error is
+// reported in the current context (see context.hpp).
+
+#include "beaker/prelude.hpp"
+
+#include <string>
+#include <vector>
+
+
+namespace beaker
+{
+
+// A diagnostic log records the errors diagnosed by a task.
+struct Diagnostic_log
+{
+  // A saved error. An error with no location was diagnosed
+  // without one.
+  struct Entry
+  {
+    Location    loc;
+    std::string msg;
+  };
+
+  bool empty() const { return entries.empty(); }
+
+  void save(Location, std::string const&);
+  void emit() const;
+
+  std::vector<Entry> entries;
+};
+
+
+Diagnostic_log* current_log();
+void            report(Location, std::string const&);
+
+
+// Within the lifetime of this object, diagnostics from the
+// calling thread are saved in the given log.
+struct Use_diagnostic_log
+{
+  Use_diagnostic_log(Diagnostic_log&);
+  ~Use_diagnostic_log();
+
+  Diagnostic_log* prev;
+};
+
+
+// Diagnose an error at the given location.
+template<typename... Args>
+inline void
+diagnose(Location loc, char const* msg, Args const&... args)
+{
+  if (Diagnostic_log* log = current_log())
+    log->save(loc, format(msg, args...));
+  else
+    report(loc, format(msg, args...));
+}
+
+
+// Diagnose an error with no location.
+template<typename... Args>
+inline void
+diagnose(char const* msg, Args const&... args)
+{
+  if (Diagnostic_log* log = current_log())
+    log->save(Location(), format(msg, args...));
+  else
+    report(Location(), format(msg, args...));
+}
+
+
+} // namespace beaker
+
+
+#endif
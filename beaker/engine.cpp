@@ -0,0 +1,94 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/engine.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+
+
+namespace beaker
+{
+
+// Note that the JIT shares the globals of the machine, which
+// have been initialized.
+Engine::Engine(Unit const* u, Tier_options const& opts)
+  : unit(u),
+    options(opts),
+    prog(to_bytecode(u)),
+    machine(prog),
+    jit(u, machine.globals.data(), opts.jit),
+    compiled(0),
+    pool(1)
+{
+  machine.profile(options.threshold, [this](Procedure const& p) {
+    promote(p);
+  });
+}
+
+
+// Wait for compilations to finish before the machine and the
+// JIT are destroyed.
+Engine::~Engine()
+{
+  pool.wait();
+}
+
+
+// Compile the procedure `p` and install its native code in the
+// machine. Note that compilation runs concurrently with the
+// machine, which continues to run `p` until the code is ready.
+void
+Engine::promote(Procedure const& p)
+{
+  auto task = [this, &p]() {
+    if (Jit::Entry e = jit.compile(p.decl)) {
+      machine.install(p, e);
+      ++compiled;
+    }
+  };
+  if (options.background)
+    pool.submit(task);
+  else
+    task();
+}
+
+
+// Wait for pending compilations to finish.
+void
+Engine::wait()
+{
+  pool.wait();
+}
+
+
+// Call the function `f` with the given arguments.
+Value
+Engine::call(Function_decl const* f, Value_seq const& args)
+{
+  Procedure const* p = prog.find(f);
+  if (!p) {
+    error(f->location(), "'{}' is not defined", f->name());
+    return 0;
+  }
+  return machine.call(*p, args);
+}
+
+
+// Run the program `u` with tiered execution, starting with the
+// function named `name` and the given arguments. Returns the
+// value returned by that function.
+Value
+run_tiered(Unit const* u, char const* name, Value_seq const& args, Tier_options const& opts)
+{
+  Function_decl const* f = find_function(u, name);
+  if (!f) {
+    error("no function named '{}'", name);
+    return 0;
+  }
+  Engine e(u, opts);
+  return e.call(f, args);
+}
+
+
+} // namespace beaker
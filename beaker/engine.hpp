@@ -0,0 +1,85 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_ENGINE_HPP
+#define BEAKER_ENGINE_HPP
+
+// This module provides tiered execution of programs. Programs
+// start running on the bytecode machine (see machine.hpp), which
+// starts quickly. Functions that become hot are compiled to
+// native code by the JIT (see codegen/jit.hpp), and subsequent
+// calls to them run that code.
+//
+// Both tiers diagnose runtime errors (e.g., division by 0) in
+// the same way, so the errors of a program do not depend on
+// when its functions are compiled.
+//
+// Note that a function is not replaced while it is running. A
+// long-running loop benefits from compilation only when its
+// function is called again.
+//
+// This module is available when the build is configured with
+// BEAKER_LLVM_JIT.
+
+#include "beaker/prelude.hpp"
+#include "beaker/value.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+#include "beaker/thread.hpp"
+#include "beaker/codegen/jit.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace beaker
+{
+
+// Options for tiered execution. A function is compiled when the
+// number of calls to it, and of backward branches taken in it,
+// reaches the threshold. When background compilation is
+// disabled, the machine waits for each function to compile.
+struct Tier_options
+{
+  Tier_options()
+    : threshold(1000), background(true)
+  { }
+
+  std::uint32_t threshold;  // The heat of a hot function
+  bool          background; // Compile on another thread
+  Jit_options   jit;        // Compilation options
+};
+
+
+// The engine runs a unit with tiered execution. Constructing
+// the engine translates the unit into bytecode and initializes
+// its global variables, which are shared by both tiers. Any
+// deferred bodies of the unit are parsed then, on the thread
+// constructing the engine, and before any function is compiled
+// in the background.
+struct Engine
+{
+  explicit Engine(Unit const*, Tier_options const& = {});
+  ~Engine();
+
+  Value call(Function_decl const*, Value_seq const&);
+  void  promote(Procedure const&);
+  void  wait();
+
+  Unit const*      unit;
+  Tier_options     options;
+  Program          prog;
+  Machine          machine;
+  Jit              jit;
+  std::atomic<int> compiled; // The number of compiled functions
+  Thread_pool      pool;     // Compiles in the background
+};
+
+
+Value run_tiered(Unit const*, char const*, Value_seq const& = {}, Tier_options const& = {});
+
+
+} // namespace beaker
+
+
+#endif
@@ -3,6 +3,9 @@
 
 #include "beaker/evaluate.hpp"
 #include "beaker/expr.hpp"
+#include "beaker/diagnostic.hpp"
+
+#include <vector>
 
 
 namespace beaker
@@ -12,58 +15,21 @@ namespace beaker
 // -------------------------------------------------------------------------- //
 //                         Evaluation of expressions
 
-
-Value 
-evaluate(Expr const* e)
-{
-  struct Evaluate_fn
-  {
-    Value operator()(Constant_expr const* e) const { return evaluate(e); }
-    Value operator()(Identifier_expr const* e) const { return evaluate(e); }
-    Value operator()(Unary_expr const* e) const { return evaluate(e); }
-    Value operator()(Binary_expr const* e) const { return evaluate(e); }
-    Value operator()(Call_expr const* e) const { return evaluate(e); }
-  };
-  return apply(e, Evaluate_fn());
-}
-
-
-// The value of a constant expression is that value.
-Value
-evaluate(Constant_expr const* e)
-{
-  return e->value();
-}
-
-
-// The value of an identifier is determined by its
-// initializer.
-//
-// TODO: This can be defined for constant declarations or
-// generalized constant expressions.
-Value
-evaluate(Identifier_expr const* e)
-{
-  error(e->location(), "not a constant expression");
-  return 0;
-}
-
-
-// The value of a unary expression depends on the operator.
-// Note that there are no overflow conditions to worry
-// about with these operations.
+// Returns the value of the unary operator `op` applied to
+// the value `v`. Note that there are no overflow conditions 
+// to worry about with these operations.
 Value
-evaluate(Unary_expr const* e)
+evaluate(Unary_op op, Value v)
 {
-  switch (e->op()) {
+  switch (op) {
     case num_neg_op:
-      return -evaluate(e->arg());
+      return -v;
     case num_pos_op:
-      return evaluate(e->arg());
+      return v;
     case bit_not_op:
-      return ~evaluate(e->arg());
+      return ~v;
     case log_not_op:
-      return !evaluate(e->arg());
+      return !v;
     default:
       break;
   }
@@ -71,7 +37,8 @@ evaluate(Unary_expr const* e)
 }
 
 
-// The value of a binary expression depends on the operator.
+// Returns the value of the binary operator `op` applied to
+// the values `v1` and `v2`.
 //
 // TODO: Implement checks for undefined behavior:
 //
@@ -80,45 +47,45 @@ evaluate(Unary_expr const* e)
 //    - shift by negative numbers
 //    - shift by an amount greater than the LHS width
 Value
-evaluate(Binary_expr const* e)
+evaluate(Binary_op op, Value v1, Value v2)
 {
-  switch (e->op()) {
+  switch (op) {
     case num_add_op:
-      return evaluate(e->left()) + evaluate(e->right());
+      return v1 + v2;
     case num_sub_op:
-      return evaluate(e->left()) - evaluate(e->right());
+      return v1 - v2;
     case num_mul_op:
-      return evaluate(e->left()) * evaluate(e->right());
+      return v1 * v2;
     case num_div_op:
-      return evaluate(e->left()) / evaluate(e->right());
+      return v1 / v2;
     case num_mod_op:
-      return evaluate(e->left()) % evaluate(e->right());
+      return v1 % v2;
     case bit_and_op:
-      return evaluate(e->left()) & evaluate(e->right());
+      return v1 & v2;
     case bit_or_op:
-      return evaluate(e->left()) | evaluate(e->right());
+      return v1 | v2;
     case bit_xor_op:
-      return evaluate(e->left()) ^ evaluate(e->right());
+      return v1 ^ v2;
     case bit_lsh_op:
-      return evaluate(e->left()) << evaluate(e->right());
+      return v1 << v2;
     case bit_rsh_op:
-      return evaluate(e->left()) >> evaluate(e->right());
+      return v1 >> v2;
     case rel_eq_op:
-      return evaluate(e->left()) == evaluate(e->right());
+      return v1 == v2;
     case rel_ne_op:
-      return evaluate(e->left()) != evaluate(e->right());
+      return v1 != v2;
     case rel_lt_op:
-      return evaluate(e->left()) < evaluate(e->right());
+      return v1 < v2;
     case rel_gt_op:
-      return evaluate(e->left()) > evaluate(e->right());
+      return v1 > v2;
     case rel_le_op:
-      return evaluate(e->left()) <= evaluate(e->right());
+      return v1 <= v2;
     case rel_ge_op:
-      return evaluate(e->left()) >= evaluate(e->right());
+      return v1 >= v2;
     case log_and_op:
-      return evaluate(e->left()) && evaluate(e->right());
+      return v1 && v2;
     case log_or_op:
-      return evaluate(e->left()) || evaluate(e->right());
+      return v1 || v2;
     default:
       break;
   }
@@ -126,6 +93,135 @@ evaluate(Binary_expr const* e)
 }
 
 
+namespace
+{
+
+// Returns true if the value of the binary operator `op` is
+// determined by the value `v` of its left operand. In that 
+// case, the right operand is not evaluated, and the value
+// of the expression is `v != 0`.
+inline bool
+short_circuits(Binary_op op, Value v)
+{
+  return (op == log_and_op && !v) || (op == log_or_op && v);
+}
+
+
+} // namespace
+
+
+// Evaluate the expression `e`.
+//
+// Operands are evaluated by a post-order traversal using an
+// explicit stack, so the depth of `e` is limited only by
+// available memory. The state of each frame is the number of
+// operands evaluated so far, whose values are on the top of
+// the value stack.
+Value 
+evaluate(Expr const* e)
+{
+  struct Frame
+  {
+    Expr const* expr;
+    int         state;
+  };
+  std::vector<Frame> work {{e, 0}};
+  std::vector<Value> values;
+  while (!work.empty()) {
+    Frame& f = work.back();
+    switch (f.expr->kind()) {
+      case constant_expr_kind:
+        values.push_back(evaluate(cast<Constant_expr>(f.expr)));
+        break;
+
+      case identifier_expr_kind:
+        values.push_back(evaluate(cast<Identifier_expr>(f.expr)));
+        break;
+
+      case unary_expr_kind: {
+        Unary_expr const* u = cast<Unary_expr>(f.expr);
+        if (f.state++ == 0) {
+          work.push_back({u->arg(), 0});
+          continue;
+        }
+        values.back() = evaluate(u->op(), values.back());
+        break;
+      }
+
+      case binary_expr_kind: {
+        Binary_expr const* b = cast<Binary_expr>(f.expr);
+        if (f.state == 0) {
+          f.state = 1;
+          work.push_back({b->left(), 0});
+          continue;
+        }
+        if (f.state == 1) {
+          if (short_circuits(b->op(), values.back())) {
+            values.back() = values.back() != 0;
+            break;
+          }
+          f.state = 2;
+          work.push_back({b->right(), 0});
+          continue;
+        }
+        Value v2 = values.back();
+        values.pop_back();
+        values.back() = evaluate(b->op(), values.back(), v2);
+        break;
+      }
+
+      case call_expr_kind:
+        values.push_back(evaluate(cast<Call_expr>(f.expr)));
+        break;
+    }
+    work.pop_back();
+  }
+  return values.back();
+}
+
+
+// The value of a constant expression is that value.
+Value
+evaluate(Constant_expr const* e)
+{
+  return e->value();
+}
+
+
+// The value of an identifier is determined by its
+// initializer.
+//
+// TODO: This can be defined for constant declarations or
+// generalized constant expressions.
+Value
+evaluate(Identifier_expr const* e)
+{
+  diagnose(e->location(), "not a constant expression");
+  return 0;
+}
+
+
+// The value of a unary expression depends on the operator.
+Value
+evaluate(Unary_expr const* e)
+{
+  return evaluate(e->op(), evaluate(e->arg()));
+}
+
+
+// The value of a binary expression depends on the operator.
+// The right operand of a logical operator is evaluated only
+// when the left does not determine the result.
+Value
+evaluate(Binary_expr const* e)
+{
+  Value v1 = evaluate(e->left());
+  if (short_circuits(e->op(), v1))
+    return v1 != 0;
+  return evaluate(e->op(), v1, evaluate(e->right()));
+}
+
+
 // The value of a call expression is computed by the function's
 // definition.
 //
@@ -134,7 +230,7 @@ evaluate(Binary_expr const* e)
 Value
 evaluate(Call_expr const* e)
 {
-  error(e->location(), "'{}' is not a constant expression");
+  diagnose(e->location(), "'{}' is not a constant expression");
   return 0;
 }
 
@@ -151,19 +247,104 @@ is_reduced(Expr const* e)
 }
 
 
+namespace
+{
+
+// Rebuild the unary expression `e` with the reduced operand
+// `e1`. If the operand is reduced, then fold this operation.
+Expr const*
+reduce_expr(Unary_expr const* e, Expr const* e1)
+{
+  Expr const* r = make_unary_expr(e->location(), e->op(), e1);
+  if (is_reduced(e1)) {
+    Value v = evaluate(e->op(), cast<Constant_expr>(e1)->value());
+    return make_constant_expr(r->location(), r->type(), v);
+  }
+  else
+    return r;
+}
+
+
+// Rebuild the binary expression `e` with the reduced operands
+// `e1` and `e2`. If the expression can be folded, fold it.
+Expr const*
+reduce_expr(Binary_expr const* e, Expr const* e1, Expr const* e2)
+{
+  Expr const* r = make_binary_expr(e->location(), e->op(), e1, e2);
+  if (is_reduced(e1) && is_reduced(e2)) {
+    Value v1 = cast<Constant_expr>(e1)->value();
+    Value v2 = cast<Constant_expr>(e2)->value();
+    return make_constant_expr(r->location(), r->type(), evaluate(e->op(), v1, v2));
+  }
+  else
+    return r;
+}
+
+
+} // namespace
+
+
 // Reduce the given expression.
+//
+// Like evaluation, reduction is a post-order traversal using
+// an explicit stack. The reduced operands of each frame are on
+// the top of the result stack.
 Expr const* 
 reduce(Expr const* e)
 {
-  struct Reduce_fn
+  struct Frame
   {
-    Expr const* operator()(Constant_expr const* e) const { return reduce(e); }
-    Expr const* operator()(Identifier_expr const* e) const { return reduce(e); }
-    Expr const* operator()(Unary_expr const* e) const { return reduce(e); }
-    Expr const* operator()(Binary_expr const* e) const { return reduce(e); }
-    Expr const* operator()(Call_expr const* e) const { return reduce(e); }
+    Expr const* expr;
+    int         state;
   };
-  return apply(e, Reduce_fn());
+  std::vector<Frame> work {{e, 0}};
+  std::vector<Expr const*> results;
+  while (!work.empty()) {
+    Frame& f = work.back();
+    switch (f.expr->kind()) {
+      case constant_expr_kind:
+        results.push_back(reduce(cast<Constant_expr>(f.expr)));
+        break;
+
+      case identifier_expr_kind:
+        results.push_back(reduce(cast<Identifier_expr>(f.expr)));
+        break;
+
+      case unary_expr_kind: {
+        Unary_expr const* u = cast<Unary_expr>(f.expr);
+        if (f.state++ == 0) {
+          work.push_back({u->arg(), 0});
+          continue;
+        }
+        results.back() = reduce_expr(u, results.back());
+        break;
+      }
+
+      case binary_expr_kind: {
+        Binary_expr const* b = cast<Binary_expr>(f.expr);
+        if (f.state == 0) {
+          f.state = 1;
+          work.push_back({b->left(), 0});
+          continue;
+        }
+        if (f.state == 1) {
+          f.state = 2;
+          work.push_back({b->right(), 0});
+          continue;
+        }
+        Expr const* e2 = results.back();
+        results.pop_back();
+        results.back() = reduce_expr(b, results.back(), e2);
+        break;
+      }
+
+      case call_expr_kind:
+        results.push_back(reduce(cast<Call_expr>(f.expr)));
+        break;
+    }
+    work.pop_back();
+  }
+  return results.back();
 }
 
 
@@ -192,14 +373,7 @@ reduce(Identifier_expr const* e)
 Expr const*
 reduce(Unary_expr const* e)
 {
-  Expr const* e1 = reduce(e->arg());
-  Expr const* r = make_unary_expr(e->location(), e->op(), e1);
-
-  // If the operand is reduced, then fold this operation.
-  if (is_reduced(e1))
-    return make_constant_expr(r->location(), r->type(), evaluate(r));
-  else
-    return r;
+  return reduce_expr(e, reduce(e->arg()));
 }
 
 
@@ -210,13 +384,7 @@ reduce(Binary_expr const* e)
 {
   Expr const* e1 = reduce(e->left());
   Expr const* e2 = reduce(e->right());
-  Expr const* r = make_binary_expr(e->location(), e->op(), e1, e2);
-
-  // If the expression can be folded, fold it.
-  if (is_reduced(e1) && is_reduced(e2))
-    return make_constant_expr(r->location(), r->type(), evaluate(r));
-  else
-    return r;
+  return reduce_expr(e, e1, e2);
 }
 
 
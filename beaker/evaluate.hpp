@@ -15,6 +15,7 @@
 
 #include "beaker/prelude.hpp"
 #include "beaker/value.hpp"
+#include "beaker/operator.hpp"
 
 
 namespace beaker
@@ -27,6 +28,9 @@ Value evaluate(Unary_expr const*);
 Value evaluate(Binary_expr const*);
 Value evaluate(Call_expr const*);
 
+Value evaluate(Unary_op, Value);
+Value evaluate(Binary_op, Value, Value);
+
 Expr const* reduce(Expr const*);
 Expr const* reduce(Constant_expr const*);
 Expr const* reduce(Identifier_expr const*);
@@ -6,6 +6,8 @@
 #include "beaker/decl.hpp"
 #include "beaker/same.hpp"
 #include "beaker/function.hpp"
+#include "beaker/arena.hpp"
+#include "beaker/diagnostic.hpp"
 
 namespace beaker
 {
@@ -18,7 +20,7 @@ Expr::node_name() const
 
 
 Identifier_expr::Identifier_expr(Location loc, Decl const* decl)
-  : Expr(loc, get_reference_type(decl->type())), decl_(decl)
+  : Expr(node_kind, loc, get_reference_type(decl->type())), decl_(decl)
 { }
 
 
@@ -33,7 +35,7 @@ Identifier_expr::name() const
 Constant_expr*
 make_bool_expr(Location loc, bool b)
 {
-  return new Constant_expr(loc, get_bool_type(), b);
+  return get_arena().make<Constant_expr>(loc, get_bool_type(), b);
 }
 
 
@@ -41,7 +43,7 @@ make_bool_expr(Location loc, bool b)
 Constant_expr*
 make_int_expr(Location loc, std::intmax_t n)
 {
-  return new Constant_expr(loc, get_int_type(), n);
+  return get_arena().make<Constant_expr>(loc, get_int_type(), n);
 }
 
 
@@ -49,7 +51,7 @@ make_int_expr(Location loc, std::intmax_t n)
 Constant_expr*
 make_constant_expr(Location loc, Type const* t, Value n)
 {
-  return new Constant_expr(loc, t, n);
+  return get_arena().make<Constant_expr>(loc, t, n);
 }
 
 
@@ -57,7 +59,7 @@ make_constant_expr(Location loc, Type const* t, Value n)
 Identifier_expr*
 make_identifier_expr(Location loc, Decl const* d)
 {
-  return new Identifier_expr(loc, d);
+  return get_arena().make<Identifier_expr>(loc, d);
 }
 
 
@@ -66,7 +68,7 @@ Unary_expr*
 make_unary_expr(Location loc, Unary_op op, Expr const* e)
 {
   Type const* t = get_type(op, e);
-  return new Unary_expr(loc, t, op, e);
+  return get_arena().make<Unary_expr>(loc, t, op, e);
 }
 
 
@@ -75,27 +77,35 @@ Binary_expr*
 make_binary_expr(Location loc, Binary_op op, Expr const* e1, Expr const* e2)
 {
   Type const* t = get_type(op, e1, e2);
-  return new Binary_expr(loc, t, op,  e1, e2);
+  return get_arena().make<Binary_expr>(loc, t, op,  e1, e2);
 }
 
 
 // Create a new call expression.
 Call_expr*
 make_call_expr(Location loc, Expr const* f, Expr_seq const& args)
+{
+  return make_call_expr(loc, f, Expr_seq(args));
+}
+
+
+// Create a new call expression, taking the arguments.
+Call_expr*
+make_call_expr(Location loc, Expr const* f, Expr_seq&& args)
 {
   Input_context cxt(loc);
 
   // Get the type of the function target.
   Function_type const* t = as<Function_type>(get_expr_type(f));
   if (!t) {
-    error(loc, "'{}' is not callable");
+    diagnose(loc, "'{}' is not callable");
     return make_error_node<Call_expr>();
   }
 
   if (!check_arguments(t, args))
     return make_error_node<Call_expr>();
 
-  return new Call_expr(loc, t->return_type(), f, args);
+  return get_arena().make<Call_expr>(loc, t->return_type(), f, std::move(args));
 }
 
 
@@ -20,6 +20,17 @@ struct Expr_visitor;
 // -------------------------------------------------------------------------- //
 //                                Expressions
 
+// The kinds of expressions.
+enum Expr_kind
+{
+  constant_expr_kind,
+  identifier_expr_kind,
+  unary_expr_kind,
+  binary_expr_kind,
+  call_expr_kind,
+};
+
+
 // The Expr class represents the set of all expressions
 // in the language.
 //
@@ -32,8 +43,8 @@ struct Expr_visitor;
 // can be determined programmatically.
 struct Expr
 {
-  Expr(Location l, Type const* t)
-    : loc_(l), type_(t)
+  Expr(Expr_kind k, Location l, Type const* t)
+    : kind_(k), loc_(l), type_(t)
   { }
 
   virtual ~Expr() { }
@@ -41,9 +52,11 @@ struct Expr
   virtual void accept(Expr_visitor&) const = 0;
 
   String      node_name() const;
+  Expr_kind   kind() const      { return kind_; }
   Location    location() const  { return loc_; }
   Type const* type() const      { return type_; }
 
+  Expr_kind   kind_;
   Location    loc_;
   Type const* type_;
 };
@@ -65,8 +78,10 @@ struct Expr_visitor
 // system.
 struct Constant_expr : Expr
 {
+  static constexpr Expr_kind node_kind = constant_expr_kind;
+
   Constant_expr(Location loc, Type const* t, Value n)
-    : Expr(loc, t), value_(n)
+    : Expr(node_kind, loc, t), value_(n)
   { }
 
   void accept(Expr_visitor& v) const { v.visit(this); }
@@ -80,6 +95,8 @@ struct Constant_expr : Expr
 // An id-expression refers to a declaration.
 struct Identifier_expr : Expr
 {
+  static constexpr Expr_kind node_kind = identifier_expr_kind;
+
   Identifier_expr(Location, Decl const*);
 
   void accept(Expr_visitor& v) const { v.visit(this); }
@@ -97,8 +114,10 @@ struct Identifier_expr : Expr
 // operator.
 struct Unary_expr : Expr
 {
+  static constexpr Expr_kind node_kind = unary_expr_kind;
+
   Unary_expr(Location loc, Type const* t, Unary_op op, Expr const* e)
-    : Expr(loc, t), first(op), second(e)
+    : Expr(node_kind, loc, t), first(op), second(e)
   { }
 
   void accept(Expr_visitor& v) const { v.visit(this); }
@@ -118,8 +137,10 @@ struct Unary_expr : Expr
 // location of its operator.
 struct Binary_expr : Expr
 {
+  static constexpr Expr_kind node_kind = binary_expr_kind;
+
   Binary_expr(Location loc, Type const* t, Binary_op op, Expr const* l, Expr const* r)
-    : Expr(loc, t), first(op), second(l), third(r)
+    : Expr(node_kind, loc, t), first(op), second(l), third(r)
   { }
 
   void accept(Expr_visitor& v) const { v.visit(this); }
@@ -142,8 +163,14 @@ struct Binary_expr : Expr
 // refer to a function (declaration or parameter).
 struct Call_expr : Expr
 {
+  static constexpr Expr_kind node_kind = call_expr_kind;
+
   Call_expr(Location loc, Type const* t, Expr const* f, Expr_seq const& a)
-    : Expr(loc, t), first(f), second(a)
+    : Expr(node_kind, loc, t), first(f), second(a)
+  { }
+
+  Call_expr(Location loc, Type const* t, Expr const* f, Expr_seq&& a)
+    : Expr(node_kind, loc, t), first(f), second(std::move(a))
   { }
 
   void accept(Expr_visitor& v) const { v.visit(this); }
@@ -172,6 +199,7 @@ Identifier_expr*  make_identifier_expr(Location, Decl const*);
 Unary_expr*       make_unary_expr(Location, Unary_op, Expr const*);
 Binary_expr*      make_binary_expr(Location, Binary_op, Expr const*, Expr const*);
 Call_expr*        make_call_expr(Location, Expr const*, Expr_seq const&);
+Call_expr*        make_call_expr(Location, Expr const*, Expr_seq&&);
 
 
 // Returns the boolean literal `true`.
@@ -450,16 +478,45 @@ struct Generic_expr_visitor : Expr_visitor, Generic_visitor<F, T>
 };
 
 
-// Apply the function f to the expression e.
+// Apply the function f to the expression e using the virtual
+// visitor. The return type is that of the function object F.
 template<typename F, typename T = typename std::result_of<F(Constant_expr*)>::type>
 inline T
-apply(Expr const* e, F fn)
+apply_visitor(Expr const* e, F fn)
 {
   Generic_expr_visitor<F, T> v(fn);
   return accept(e, v);
 }
 
 
+// Apply the function f to the expression e. This dispatches on
+// the kind of e, which allows calls to f to be inlined. When
+// BEAKER_VIRTUAL_DISPATCH is defined, this uses the virtual
+// visitor instead.
+template<typename F, typename T = typename std::result_of<F(Constant_expr*)>::type>
+inline T
+apply(Expr const* e, F fn)
+{
+#ifdef BEAKER_VIRTUAL_DISPATCH
+  return apply_visitor<F, T>(e, fn);
+#else
+  switch (e->kind()) {
+  case constant_expr_kind:
+    return fn(static_cast<Constant_expr const*>(e));
+  case identifier_expr_kind:
+    return fn(static_cast<Identifier_expr const*>(e));
+  case unary_expr_kind:
+    return fn(static_cast<Unary_expr const*>(e));
+  case binary_expr_kind:
+    return fn(static_cast<Binary_expr const*>(e));
+  case call_expr_kind:
+    return fn(static_cast<Call_expr const*>(e));
+  }
+  lingo_unreachable();
+#endif
+}
+
+
 } // namespace beaker
 
 #endif
@@ -0,0 +1,98 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/file.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace beaker
+{
+
+namespace
+{
+
+// Read the remaining contents of the file descriptor `fd` into
+// the string `s`. This is used for inputs that cannot be mapped,
+// like pipes and terminals, whose size is not known in advance.
+bool
+read_all(int fd, String& s)
+{
+  char buf[1 << 16];
+  while (true) {
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n == 0)
+      return true;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    s.append(buf, n);
+  }
+}
+
+
+} // namespace
+
+
+// Acquire the text of the file named by `path`. Regular files
+// are mapped and the kernel is advised that the mapping will
+// be read sequentially, which lets it read ahead aggressively
+// and drop pages behind the lexer. Everything else is read.
+File_mapping::File_mapping(char const* path)
+  : first_(nullptr), size_(0), mapped_(false)
+{
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    error("cannot open '{}': {}", path, std::strerror(errno));
+    return;
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+      first_ = static_cast<char const*>(p);
+      size_ = st.st_size;
+      mapped_ = true;
+    }
+  }
+
+  // Fall back to reading the input.
+  if (!mapped_) {
+    if (!read_all(fd, copy_))
+      error("cannot read '{}': {}", path, std::strerror(errno));
+    first_ = copy_.data();
+    size_ = copy_.size();
+  }
+
+  ::close(fd);
+}
+
+
+File_mapping::~File_mapping()
+{
+  if (mapped_)
+    ::munmap(const_cast<char*>(first_), size_);
+}
+
+
+Mapped_file::Mapped_file(char const* path)
+  : File_mapping(path), Buffer(text_begin(), text_end()), path_(path)
+{ }
+
+
+Mapped_file::Mapped_file(String const& path)
+  : Mapped_file(path.c_str())
+{ }
+
+
+} // namespace beaker
@@ -0,0 +1,69 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_FILE_HPP
+#define BEAKER_FILE_HPP
+
+// The file module provides zero-copy access to source files.
+// Regular files are mapped directly into memory so that the
+// lexer (and the locations of the tokens it produces) refer
+// to the mapped pages rather than to a heap copy of the file.
+// Inputs that cannot be mapped (pipes, terminals, etc.) are
+// read into memory instead.
+
+#include "beaker/prelude.hpp"
+
+#include "lingo/buffer.hpp"
+
+#include <cstddef>
+
+
+namespace beaker
+{
+
+// A file mapping owns the storage for the text of a source
+// file. The text is either a read-only, private mapping of
+// the file or, when the file cannot be mapped, a copy of its
+// contents.
+//
+// This class is never used directly. It is used only as a
+// base of the mapped file class below, which guarantees that
+// the storage is acquired before the buffer is initialized.
+struct File_mapping
+{
+  File_mapping(char const*);
+  ~File_mapping();
+
+  File_mapping(File_mapping const&) = delete;
+  File_mapping& operator=(File_mapping const&) = delete;
+
+  char const* text_begin() const { return first_; }
+  char const* text_end() const   { return first_ + size_; }
+
+  char const* first_;  // The start of the text
+  std::size_t size_;   // The size of the text
+  bool        mapped_; // True if the text is mapped
+  String      copy_;   // Storage for unmappable inputs
+};
+
+
+// A mapped file is a buffer whose text is the (possibly)
+// memory mapped contents of a source file. The mapping is
+// released when the file is destroyed, so tokens lexed from
+// the file must not outlive it.
+struct Mapped_file : private File_mapping, Buffer
+{
+  Mapped_file(char const*);
+  Mapped_file(String const&);
+
+  String const& path() const      { return path_; }
+  bool          is_mapped() const { return mapped_; }
+
+  String path_;
+};
+
+
+} // namespace beaker
+
+
+#endif
@@ -7,6 +7,12 @@
 #include "beaker/decl.hpp"
 #include "beaker/stmt.hpp"
 #include "beaker/same.hpp"
+#include "beaker/context.hpp"
+#include "beaker/diagnostic.hpp"
+#include "beaker/thread.hpp"
+
+#include <atomic>
+#include <vector>
 
 
 namespace beaker
@@ -18,15 +24,14 @@ namespace beaker
 namespace
 {
 
-Type const* check_return(Type const*, Stmt const*);
-
-
+// Returns the result of checking a block statement whose
+// statements have the results in [first, last).
 Type const*
-check_return(Type const* t, Block_stmt const* s)
+check_block_return(Type const* const* first, Type const* const* last)
 {
   Type const* r = nullptr;
-  for (Stmt const* s1 : s->statements()) {
-    Optional<Type> t1 = check_return(t, s1);
+  for (; first != last; ++first) {
+    Optional<Type> t1 = *first;
 
     // Only update the return value if we find a definite
     // return type. Otherwise, it stays null. Also, don't
@@ -40,47 +45,25 @@ check_return(Type const* t, Block_stmt const* s)
 }
 
 
+// Returns the result of checking an if-else statement whose
+// branches have the results `t1` and `t2`.
 Type const*
-check_return(Type const* t, If_then_stmt const* s)
+check_if_else_return(Type const* t, Optional<Type> t1, Optional<Type> t2)
 {
-  return check_return(t, s->branch());
-}
-
-
-Type const*
-check_return(Type const* t, If_else_stmt const* s)
-{
-  Optional<Type> t1 = check_return(t, s->true_branch());
-  Optional<Type> t2 = check_return(t, s->false_branch());
-  
   // Return t iff either branch has a return statement.
   if (t1 && t2)
-    return (*t1 || *t1) ? t : nullptr;
+    return (*t1 || *t2) ? t : nullptr;
   else
     return make_error_node<Type>();
 }
 
 
-Type const*
-check_return(Type const* t, While_stmt const* s)
-{
-  return check_return(t, s->body());
-}
-
-
-Type const*
-check_return(Type const* t, Do_stmt const* s)
-{
-  return check_return(t, s->body());
-}
-
-
 // For an exit statmeent, the result type must be `void`.
 Type const*
 check_return(Type const* t, Exit_stmt const* s)
 {
   if (!is_void_type(t)) {
-    error(s->location(), "no return value in non-void function");
+    diagnose(s->location(), "no return value in non-void function");
     return make_error_node<Type>();
   }
   return t;
@@ -88,14 +71,14 @@ check_return(Type const* t, Exit_stmt const* s)
 
 
 // Check that the type of the result type is the same
-// as `t`.
+// as `t`. The value of a variable may be returned.
 //
 // TODO: Support implicit conversion to the return type.
 Type const*
 check_return(Type const* t, Return_stmt const* s)
 {
   Expr const* e = s->result();
-  Type const* r = e->type();
+  Type const* r = get_expr_type(e);
 
   // The type of the return statement shall match the
   // declared type of the function
@@ -103,9 +86,9 @@ check_return(Type const* t, Return_stmt const* s)
     // Generate different error messages depending on
     // the mismatched types.
     if (is_void_type(t))
-      error(e->location(), "returning a value from a 'void' function");
+      diagnose(e->location(), "returning a value from a 'void' function");
     else
-      error(e->location(), "returning a value of type '{}'", r);
+      diagnose(e->location(), "returning a value of type '{}'", r);
     return make_error_node<Type>();
   }
   
@@ -113,44 +96,96 @@ check_return(Type const* t, Return_stmt const* s)
 }
 
 
-// Dispatch to an approp
-struct Check_return_fn
-{
-  Check_return_fn(Type const* t)
-    : t(t)
-  { }
-
-  // These do not return, so they are trivially satisfied.
-  //
-  // TODO: Use a concept to declare these to be non-compound.
-  Type const* operator()(Empty_stmt const* s) const { return t; }
-  Type const* operator()(Declaration_stmt const* s) const { return t; }
-  Type const* operator()(Expression_stmt const* s) const { return t; }
-  Type const* operator()(Assignment_stmt const* s) const { return t; }
-
-  // Recursively check compound statements.
-  Type const* operator()(If_then_stmt const* s) const { return check_return(t, s); }
-  Type const* operator()(If_else_stmt const* s) const { return check_return(t, s); }
-  Type const* operator()(While_stmt const* s) const { return check_return(t, s); }
-  Type const* operator()(Do_stmt const* s) const { return check_return(t, s); }
-  Type const* operator()(Block_stmt const* s) const { return check_return(t, s); }
-  
-  // The main event...
-  Type const* operator()(Exit_stmt const* s) const { return check_return(t, s); }
-  Type const* operator()(Return_stmt const* s) const { return check_return(t, s); }
-
-  Type const* t;
-};
-
-
 // Check the return type of a statement. This returns `t` if
 // the statement has a return type and nullptr if it does not.
 // An error node is returned if an error was diagnosed during
 // processing.
+//
+// Compound statements are checked by a post-order traversal
+// using an explicit stack, so the depth of `s` is limited only
+// by available memory. The state of each frame is the number
+// of its substatements that have been checked, whose results
+// are on the top of the result stack.
 Type const*
 check_return(Type const* t, Stmt const* s)
 {
-  return apply(s, Check_return_fn(t));
+  struct Frame
+  {
+    Stmt const* stmt;
+    std::size_t state;
+  };
+  std::vector<Frame> work {{s, 0}};
+  std::vector<Type const*> results;
+  while (!work.empty()) {
+    Stmt const* s1 = work.back().stmt;
+    std::size_t n = work.back().state++;
+    switch (s1->kind()) {
+      // The result of these is the result of their substatement.
+      case if_then_stmt_kind:
+        if (n == 0) {
+          work.push_back({cast<If_then_stmt>(s1)->branch(), 0});
+          continue;
+        }
+        break;
+
+      case while_stmt_kind:
+        if (n == 0) {
+          work.push_back({cast<While_stmt>(s1)->body(), 0});
+          continue;
+        }
+        break;
+
+      case do_stmt_kind:
+        if (n == 0) {
+          work.push_back({cast<Do_stmt>(s1)->body(), 0});
+          continue;
+        }
+        break;
+
+      case if_else_stmt_kind: {
+        If_else_stmt const* s2 = cast<If_else_stmt>(s1);
+        if (n < 2) {
+          work.push_back({n ? s2->false_branch() : s2->true_branch(), 0});
+          continue;
+        }
+        Type const* t2 = results.back();
+        results.pop_back();
+        results.back() = check_if_else_return(t, results.back(), t2);
+        break;
+      }
+
+      case block_stmt_kind: {
+        Stmt_seq const& ss = cast<Block_stmt>(s1)->statements();
+        if (n < ss.size()) {
+          work.push_back({ss[n], 0});
+          continue;
+        }
+        Type const* const* last = results.data() + results.size();
+        Type const* r = check_block_return(last - ss.size(), last);
+        results.resize(results.size() - ss.size());
+        results.push_back(r);
+        break;
+      }
+
+      // The main event...
+      case exit_stmt_kind:
+        results.push_back(check_return(t, cast<Exit_stmt>(s1)));
+        break;
+
+      case return_stmt_kind:
+        results.push_back(check_return(t, cast<Return_stmt>(s1)));
+        break;
+
+      // These do not return, so they are trivially satisfied.
+      //
+      // TODO: Use a concept to declare these to be non-compound.
+      default:
+        results.push_back(t);
+        break;
+    }
+    work.pop_back();
+  }
+  return results.back();
 }
 
 
@@ -172,7 +207,7 @@ check_definition(Type const* t, Stmt const* s)
   if (!r)
     return false;
   if (!*r && t != get_void_type()) {
-    error("no return value in non-void function");
+    diagnose("no return value in non-void function");
     return false;
   }
   return true;
@@ -188,8 +223,46 @@ check_definition(Function_decl const* f, Stmt const* s)
 }
 
 
+// Check the deferred function definitions `defs`, dividing the
+// work among the threads of `pool`. Each definition is checked
+// exactly once, and its result is stored in the definition.
+//
+// The definitions are claimed one at a time from a shared
+// cursor by the workers and the calling thread, so no thread
+// sits idle while definitions remain unchecked, however their
+// sizes vary. The errors diagnosed for each definition are
+// saved and emitted after all checks have finished, in the
+// order of the definitions. Diagnostics are therefore the
+// same for any number of threads.
+//
+// Checks are run in the current context of the calling thread.
+// They read, but do not create, the nodes of the program.
+void
+check_definitions(Definition_seq& defs, Thread_pool& pool)
+{
+  Context& cxt = current_context();
+  std::vector<Diagnostic_log> logs(defs.size());
+  std::atomic<std::size_t> next(0);
+  auto work = [&]() {
+    Use_context use(cxt);
+    for (std::size_t n = next++; n < defs.size(); n = next++) {
+      Use_diagnostic_log log(logs[n]);
+      defs[n].valid = check_definition(defs[n].decl, defs[n].body);
+    }
+  };
+  for (int i = 0; i < pool.size(); ++i)
+    pool.submit(work);
+  work();
+  pool.wait();
+
+  for (Diagnostic_log const& log : logs)
+    log.emit();
+}
+
+
 // Check that the types of function arguments match those
-// of the declared parameters.
+// of the declared parameters. Arguments are passed by value,
+// so a variable may be passed as an argument.
 bool
 check_arguments(Function_type const* t, Expr_seq const& args)
 {
@@ -200,9 +273,9 @@ check_arguments(Function_type const* t, Expr_seq const& args)
   int nargs = args.size();
   if (nparms != nargs) {
     if (nparms < nargs)
-      error("too many arguments (expected {} but got {})", nparms, nargs);
+      diagnose("too many arguments (expected {} but got {})", nparms, nargs);
     else if (nparms > nargs)
-      error("too few arguments (expected {} but got {})", nparms, nargs);
+      diagnose("too few arguments (expected {} but got {})", nparms, nargs);
     return false;
   }
 
@@ -211,11 +284,11 @@ check_arguments(Function_type const* t, Expr_seq const& args)
   for (int i = 0; i < nargs; ++i) {
 
     Type const* p = parms[i];
-    Type const* a = args[i]->type();
+    Type const* a = get_expr_type(args[i]);
 
     if (!same(p, a)) {
       Expr const* e = args[i];
-      error(e->location(), "type mismatch in argument {} "
+      diagnose(e->location(), "type mismatch in argument {} "
                            "(expected '{}' but got '{}')", i + 1, p, a);
       ++nerr;
     }
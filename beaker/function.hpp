@@ -9,11 +9,31 @@
 
 #include "beaker/prelude.hpp"
 
+#include <vector>
+
 namespace beaker
 {
 
+struct Thread_pool;
+
+
+// A function definition whose checking has been deferred
+// until the end of the translation unit. The result of the
+// check is stored in `valid`.
+struct Definition
+{
+  Function_decl const* decl;
+  Stmt const*          body;
+  bool                 valid;
+};
+
+
+using Definition_seq = std::vector<Definition>;
+
+
 bool check_definition(Type const*, Stmt const*);
 bool check_definition(Function_decl const*, Stmt const*);
+void check_definitions(Definition_seq&, Thread_pool&);
 
 bool check_arguments(Function_type const*, Expr_seq const&);
 
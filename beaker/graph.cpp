@@ -8,6 +8,8 @@
 #include "beaker/stmt.hpp"
 #include "beaker/unit.hpp"
 
+#include <vector>
+
 
 namespace beaker
 {
@@ -120,94 +122,50 @@ list_node_common(Printer& p, Id_map& id, T const* e)
 }
 
 
-void list_nodes(Printer&, Id_map&, Expr const*);
-
-
-void
-list_nodes(Printer& p, Id_map& id, Constant_expr const* e)
-{
-  list_node_common(p, id, e);
-}
-
-
-void
-list_nodes(Printer& p, Id_map& id, Identifier_expr const* e)
-{
-  list_node_common(p, id, e);
-}
-
-
-void
-list_nodes(Printer& p, Id_map& id, Unary_expr const* e)
-{
-  list_node_common(p, id, e);
-  list_nodes(p, id, e->arg());
-}
-
-
-void
-list_nodes(Printer& p, Id_map& id, Binary_expr const* e)
-{
-  list_node_common(p, id, e);
-  list_nodes(p, id, e->left());
-  list_nodes(p, id, e->right());
-}
-
-
-void
-list_nodes(Printer& p, Id_map& id, Call_expr const* e)
-{
-  list_node_common(p, id, e);
-  for (Expr const* ei : e->arguments())
-    list_nodes(p, id, ei);
-}
-
-
+// List the nodes of `e` in pre-order, using an explicit stack
+// so the depth of `e` is limited only by available memory.
 void 
 list_nodes(Printer& p, Id_map& id, Expr const* e)
 {
-  struct Fn
-  {
-    Fn(Printer& p, Id_map& m)
-      : p(p), id(m)
-    { }
-
-    void operator()(Constant_expr const* e) const { list_nodes(p, id, e); }
-    void operator()(Identifier_expr const* e) const { list_nodes(p, id, e); }
-    void operator()(Unary_expr const* e) const { list_nodes(p, id, e); }
-    void operator()(Binary_expr const* e) const { list_nodes(p, id, e); }
-    void operator()(Call_expr const* e) const { list_nodes(p, id, e); }
-
-    Printer& p;
-    Id_map& id;
-  };
-
-  return apply(e, Fn(p, id));
+  std::vector<Expr const*> work {e};
+  while (!work.empty()) {
+    Expr const* e1 = work.back();
+    work.pop_back();
+    list_node_common(p, id, e1);
+
+    // Push operands in reverse order so that they are
+    // listed from left to right.
+    switch (e1->kind()) {
+      case unary_expr_kind:
+        work.push_back(cast<Unary_expr>(e1)->arg());
+        break;
+
+      case binary_expr_kind:
+        work.push_back(cast<Binary_expr>(e1)->right());
+        work.push_back(cast<Binary_expr>(e1)->left());
+        break;
+
+      case call_expr_kind: {
+        Expr_seq const& args = cast<Call_expr>(e1)->arguments();
+        for (std::size_t i = args.size(); i != 0; --i)
+          work.push_back(args[i - 1]);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
 }
 
 // -------------------------------------------------------------------------- //
-//                            List nodes
-
-void list_arrows(Printer&, Id_map&, Expr const*);
-
-
-void 
-list_arrows(Printer& p, Id_map& id, Constant_expr const* e)
-{
-}
-
-
-void 
-list_arrows(Printer& p, Id_map& id, Identifier_expr const* e)
-{
-}
+//                            List arrows
 
+// List the arrows from a node to its operands. 
 
 void 
 list_arrows(Printer& p, Id_map& id, Unary_expr const* e)
 {
-  list_arrows(p, id, e->arg());
-
   print(p, "{} -> {};", node_name(id, e), node_name(id, e->arg()));
   print_newline(p);
 }
@@ -216,9 +174,6 @@ list_arrows(Printer& p, Id_map& id, Unary_expr const* e)
 void 
 list_arrows(Printer& p, Id_map& id, Binary_expr const* e)
 {
-  list_arrows(p, id, e->left());
-  list_arrows(p, id, e->right());
-
   String src = node_name(id, e);
   print(p, "{} -> {};", src, node_name(id, e->left()));
   print_newline(p);
@@ -230,11 +185,6 @@ list_arrows(Printer& p, Id_map& id, Binary_expr const* e)
 void 
 list_arrows(Printer& p, Id_map& id, Call_expr const* e)
 {
-  put_node(id, e);
-  for (Expr const* ei : e->arguments())
-    list_arrows(p, id, ei);
-
-
   String src = node_name(id, e);
   for (Expr const* ei : e->arguments()) {
     print(p, "{} -> {};", src, node_name(id, ei));
@@ -243,26 +193,59 @@ list_arrows(Printer& p, Id_map& id, Call_expr const* e)
 }
 
 
+// List the arrows of `e` in post-order: the arrows of each
+// operand precede those of the node itself. The state of each 
+// frame is the number of its operands that have been listed.
 void 
 list_arrows(Printer& p, Id_map& id, Expr const* e)
 {
-  struct Fn
+  struct Frame
   {
-    Fn(Printer& p, Id_map& m)
-      : p(p), id(m)
-    { }
-
-    void operator()(Constant_expr const* e) const { list_arrows(p, id, e); }
-    void operator()(Identifier_expr const* e) const { list_arrows(p, id, e); }
-    void operator()(Unary_expr const* e) const { list_arrows(p, id, e); }
-    void operator()(Binary_expr const* e) const { list_arrows(p, id, e); }
-    void operator()(Call_expr const* e) const { list_arrows(p, id, e); }
-
-    Printer& p;
-    Id_map& id;
+    Expr const* expr;
+    std::size_t state;
   };
-
-  return apply(e, Fn(p, id));
+  std::vector<Frame> work {{e, 0}};
+  while (!work.empty()) {
+    Expr const* e1 = work.back().expr;
+    std::size_t n = work.back().state++;
+    switch (e1->kind()) {
+      case unary_expr_kind: {
+        Unary_expr const* u = cast<Unary_expr>(e1);
+        if (n == 0) {
+          work.push_back({u->arg(), 0});
+          continue;
+        }
+        list_arrows(p, id, u);
+        break;
+      }
+
+      case binary_expr_kind: {
+        Binary_expr const* b = cast<Binary_expr>(e1);
+        if (n < 2) {
+          work.push_back({n ? b->right() : b->left(), 0});
+          continue;
+        }
+        list_arrows(p, id, b);
+        break;
+      }
+
+      case call_expr_kind: {
+        Call_expr const* c = cast<Call_expr>(e1);
+        if (n == 0)
+          put_node(id, c);
+        if (n < c->arguments().size()) {
+          work.push_back({c->arguments()[n], 0});
+          continue;
+        }
+        list_arrows(p, id, c);
+        break;
+      }
+
+      default:
+        break;
+    }
+    work.pop_back();
+  }
 }
 
 
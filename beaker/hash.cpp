@@ -0,0 +1,118 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/hash.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+
+
+namespace beaker
+{
+
+namespace
+{
+
+// Returns the hash of the kind of a node.
+template<typename T>
+inline std::size_t
+hash_kind(T const* x)
+{
+  return hash_value(static_cast<int>(x->kind()));
+}
+
+
+// Returns the hash of a sequence of terms.
+template<typename T, std::size_t N>
+inline std::size_t
+hash(std::size_t seed, Small_vector<T const*, N> const& seq)
+{
+  for (T const* x : seq)
+    seed = hash_combine(seed, hash(x));
+  return seed;
+}
+
+
+} // namespace
+
+
+// Returns the hash of a type.
+std::size_t
+hash(Type const* t)
+{
+  struct Fn
+  {
+    std::size_t operator()(Void_type const* t) const
+    {
+      return hash_kind(t);
+    }
+
+    std::size_t operator()(Boolean_type const* t) const
+    {
+      return hash_kind(t);
+    }
+
+    std::size_t operator()(Integer_type const* t) const
+    {
+      return hash_combine(hash_kind(t), hash_value(t->precision()));
+    }
+
+    std::size_t operator()(Function_type const* t) const
+    {
+      std::size_t h = hash(hash_kind(t), t->parameter_types());
+      return hash_combine(h, hash(t->return_type()));
+    }
+
+    std::size_t operator()(Reference_type const* t) const
+    {
+      return hash_combine(hash_kind(t), hash(t->type()));
+    }
+  };
+
+  return apply(t, Fn());
+}
+
+
+// Returns the hash of an expression. Declarations are
+// hashed by identity.
+std::size_t
+hash(Expr const* e)
+{
+  struct Fn
+  {
+    std::size_t operator()(Constant_expr const* e) const
+    {
+      std::size_t h = hash_combine(hash_kind(e), hash(e->type()));
+      return hash_combine(h, hash_value(e->value()));
+    }
+
+    std::size_t operator()(Identifier_expr const* e) const
+    {
+      return hash_combine(hash_kind(e), hash_value(e->decl()));
+    }
+
+    std::size_t operator()(Unary_expr const* e) const
+    {
+      std::size_t h = hash_combine(hash_kind(e), hash_value<int>(e->op()));
+      return hash_combine(h, hash(e->arg()));
+    }
+
+    std::size_t operator()(Binary_expr const* e) const
+    {
+      std::size_t h = hash_combine(hash_kind(e), hash_value<int>(e->op()));
+      h = hash_combine(h, hash(e->left()));
+      return hash_combine(h, hash(e->right()));
+    }
+
+    std::size_t operator()(Call_expr const* e) const
+    {
+      std::size_t h = hash_combine(hash_kind(e), hash(e->function()));
+      return hash(h, e->arguments());
+    }
+  };
+
+  return apply(e, Fn());
+}
+
+
+} // namespace beaker
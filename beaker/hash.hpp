@@ -0,0 +1,53 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_HASH_HPP
+#define BEAKER_HASH_HPP
+
+// This module defines the structural hashing of terms. Two
+// terms that are the same (see same.hpp) have the same hash.
+
+#include "beaker/prelude.hpp"
+
+#include <functional>
+
+
+namespace beaker
+{
+
+// Combine the hash value `h` into `seed`.
+inline std::size_t
+hash_combine(std::size_t seed, std::size_t h)
+{
+  return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+
+// Returns the hash of an object of type T.
+template<typename T>
+inline std::size_t
+hash_value(T const& x)
+{
+  return std::hash<T>()(x);
+}
+
+
+std::size_t hash(Type const*);
+std::size_t hash(Expr const*);
+
+
+// A hash function for terms.
+struct Term_hash
+{
+  template<typename T>
+  std::size_t operator()(T const& x) const
+  {
+    return hash(x);
+  }
+};
+
+
+} // namespace beaker
+
+
+#endif
@@ -0,0 +1,824 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/interpret.hpp"
+#include "beaker/evaluate.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace beaker
+{
+
+// -------------------------------------------------------------------------- //
+//                            Slot allocation
+
+namespace
+{
+
+// Maps each parameter and local variable to its function.
+using Owner_map = std::unordered_map<Decl const*, Function_decl const*>;
+
+
+// Assigns slots to the local variables of a function. Variables
+// are assigned consecutive slots above the parameters. Leaving
+// a block releases the slots of its variables, so the slots of
+// variables in disjoint blocks overlap. The size of the frame
+// is the largest number of slots in use at any point.
+//
+// Statements and expressions are traversed using explicit
+// stacks, so the depth of the body is limited only by available
+// memory. Functions declared in the body are added to `fns`,
+// and laid out in turn.
+struct Frame_layout
+{
+  Frame_layout(Function_decl const* f, Owner_map& o, std::vector<Function_decl const*>& fs)
+    : fn(f), owners(o), fns(fs), top(f->parameters().size()), size(top), valid(true)
+  { }
+
+  void layout(Stmt const*);
+  void check(Expr const*);
+
+  Function_decl const*               fn;     // The function
+  Owner_map&                         owners; // The functions of locals
+  std::vector<Function_decl const*>& fns;    // Functions to lay out
+  std::vector<Expr const*>           exprs;  // Expressions to check
+  int                                top;    // The next free slot
+  int                                size;   // The size of the frame
+  bool                               valid;  // False if a reference was diagnosed
+};
+
+
+// Assign slots to the variables declared in `s`. The state of
+// each frame is the number of its substatements that have been
+// laid out, and its mark is the next free slot when it was
+// entered.
+void
+Frame_layout::layout(Stmt const* s)
+{
+  struct Frame
+  {
+    Stmt const* stmt;
+    int         mark;
+    std::size_t state;
+  };
+  std::vector<Frame> work {{s, top, 0}};
+  while (!work.empty()) {
+    Stmt const* s1 = work.back().stmt;
+    std::size_t n = work.back().state++;
+    switch (s1->kind()) {
+      case declaration_stmt_kind: {
+        // The slot remains in use until the enclosing block
+        // is left.
+        Decl const* d = cast<Declaration_stmt>(s1)->decl();
+        if (Variable_decl const* v = as<Variable_decl>(d)) {
+          if (v->initializer())
+            check(v->initializer());
+          modify(v)->allocate(Slot(false, top++));
+          owners[v] = fn;
+          size = std::max(size, top);
+        } else if (Function_decl const* f = as<Function_decl>(d)) {
+          fns.push_back(f);
+        }
+        work.pop_back();
+        continue;
+      }
+
+      case expression_stmt_kind:
+        check(cast<Expression_stmt>(s1)->expr());
+        break;
+
+      case assignment_stmt_kind:
+        check(cast<Assignment_stmt>(s1)->lhs());
+        check(cast<Assignment_stmt>(s1)->rhs());
+        break;
+
+      case return_stmt_kind:
+        check(cast<Return_stmt>(s1)->result());
+        break;
+
+      case if_then_stmt_kind:
+        if (n == 0) {
+          check(cast<If_then_stmt>(s1)->condition());
+          work.push_back({cast<If_then_stmt>(s1)->branch(), top, 0});
+          continue;
+        }
+        break;
+
+      case if_else_stmt_kind: {
+        If_else_stmt const* s2 = cast<If_else_stmt>(s1);
+        if (n == 0) {
+          check(s2->condition());
+          work.push_back({s2->true_branch(), top, 0});
+          continue;
+        }
+        if (n == 1) {
+          top = work.back().mark;
+          work.push_back({s2->false_branch(), top, 0});
+          continue;
+        }
+        break;
+      }
+
+      case while_stmt_kind:
+        if (n == 0) {
+          check(cast<While_stmt>(s1)->condition());
+          work.push_back({cast<While_stmt>(s1)->body(), top, 0});
+          continue;
+        }
+        break;
+
+      case do_stmt_kind:
+        if (n == 0) {
+          check(cast<Do_stmt>(s1)->condition());
+          work.push_back({cast<Do_stmt>(s1)->body(), top, 0});
+          continue;
+        }
+        break;
+
+      case block_stmt_kind: {
+        Stmt_seq const& ss = cast<Block_stmt>(s1)->statements();
+        if (n < ss.size()) {
+          work.push_back({ss[n], top, 0});
+          continue;
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+    top = work.back().mark;
+    work.pop_back();
+  }
+}
+
+
+// Diagnose each reference in `e` to a local variable or
+// parameter of an enclosing function, which is not in the
+// frame of this function.
+void
+Frame_layout::check(Expr const* e)
+{
+  exprs.push_back(e);
+  while (!exprs.empty()) {
+    Expr const* e1 = exprs.back();
+    exprs.pop_back();
+    switch (e1->kind()) {
+      case identifier_expr_kind: {
+        Decl const* d = cast<Identifier_expr>(e1)->decl();
+        auto iter = owners.find(d);
+        if (iter != owners.end() && iter->second != fn) {
+          error(e1->location(), "'{}' is local to an enclosing function", d->name());
+          valid = false;
+        }
+        break;
+      }
+
+      case unary_expr_kind:
+        exprs.push_back(cast<Unary_expr>(e1)->arg());
+        break;
+
+      case binary_expr_kind:
+        exprs.push_back(cast<Binary_expr>(e1)->right());
+        exprs.push_back(cast<Binary_expr>(e1)->left());
+        break;
+
+      case call_expr_kind: {
+        Call_expr const* c = cast<Call_expr>(e1);
+        for (Expr const* a : c->arguments())
+          exprs.push_back(a);
+        exprs.push_back(c->function());
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+
+// Assign the slots of the parameters and local variables of
+// the function `f`, and the size of its frame. The body of `f`
+// must have been parsed if it was deferred.
+//
+// If the body refers to the locals of an enclosing function,
+// `f` cannot be run, and its body is replaced by an error node.
+void
+allocate_slots(Function_decl const* f, Owner_map& owners, std::vector<Function_decl const*>& fns)
+{
+  Decl_seq const& parms = f->parameters();
+  for (std::size_t i = 0; i < parms.size(); ++i) {
+    modify(cast<Parameter_decl>(parms[i]))->allocate(Slot(false, i));
+    owners[parms[i]] = f;
+  }
+
+  Frame_layout frame(f, owners, fns);
+  lingo_assert(!f->is_deferred());
+  Stmt const* s = f->body();
+  if (is_valid_node(s))
+    frame.layout(s);
+  if (!frame.valid)
+    modify(f)->define(make_error_node<Stmt>());
+  modify(f)->allocate(frame.size);
+}
+
+
+} // namespace
+
+
+// Assign the slots of all variables and parameters in the
+// unit `u`, including those of nested functions.
+//
+// This first parses all deferred bodies of `u`. Every back end
+// allocates slots before it runs or compiles any function, so
+// no body is parsed while functions are compiled concurrently
+// (see engine.hpp).
+void
+allocate_slots(Unit const* u)
+{
+  parse_bodies(u);
+  std::vector<Function_decl const*> fns;
+  int n = 0;
+  for (Decl const* d : u->declarations()) {
+    if (Variable_decl const* v = as<Variable_decl>(d))
+      modify(v)->allocate(Slot(true, n++));
+    else if (Function_decl const* f = as<Function_decl>(d))
+      fns.push_back(f);
+  }
+
+  Owner_map owners;
+  for (std::size_t i = 0; i < fns.size(); ++i)
+    allocate_slots(fns[i], owners, fns);
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Interpreter
+
+namespace
+{
+
+// The greatest depth of an expression whose value is computed
+// directly, by recursion, rather than by steps.
+constexpr int direct_depth = 16;
+
+} // namespace
+
+
+Interpreter::Interpreter(Unit const* u)
+  : unit(u), frame(0)
+{
+  allocate_slots(u);
+  for (Decl const* d : u->declarations()) {
+    if (Variable_decl const* v = as<Variable_decl>(d)) {
+      store.push_back(0);
+      Value x = 0;
+      if (v->initializer())
+        x = run(Step{v->initializer(), nullptr, nullptr, 0, 0});
+      store[v->slot().offset] = x;
+    }
+  }
+}
+
+
+// Returns the object declared by `d`, which is a variable
+// or parameter.
+Value&
+Interpreter::object(Decl const* d)
+{
+  Slot s = d->kind() == variable_decl_kind
+         ? static_cast<Variable_decl const*>(d)->slot()
+         : static_cast<Parameter_decl const*>(d)->slot();
+  return s.global ? store[s.offset] : stack[frame + s.offset];
+}
+
+
+// Call the function `f` with the given arguments.
+Value
+Interpreter::call(Function_decl const* f, Value_seq const& args)
+{
+  if (args.size() != f->parameters().size()) {
+    error(f->location(), "'{}' expects {} arguments but got {}",
+          f->name(), f->parameters().size(), args.size());
+    return 0;
+  }
+  stack.insert(stack.end(), args.begin(), args.end());
+  return run(Step{nullptr, nullptr, f, 0, 0});
+}
+
+
+// Compute the value `v` of the expression `e` directly, if it
+// has no calls and its depth is at most `n`. Otherwise, returns
+// false, and `e` must be evaluated by steps. Since `e` has no
+// side effects, evaluating part of it has no effect. Runtime
+// errors are left to be diagnosed by those steps.
+bool
+Interpreter::value(Expr const* e, int n, Value& v)
+{
+  switch (e->kind()) {
+    case constant_expr_kind:
+      v = static_cast<Constant_expr const*>(e)->value();
+      return true;
+
+    case identifier_expr_kind: {
+      Decl const* d = static_cast<Identifier_expr const*>(e)->decl();
+      if (d->kind() == function_decl_kind)
+        return false;
+      v = object(d);
+      return true;
+    }
+
+    case unary_expr_kind: {
+      Unary_expr const* u = static_cast<Unary_expr const*>(e);
+      if (n == 0 || !value(u->arg(), n - 1, v))
+        return false;
+      v = evaluate(u->op(), v);
+      return true;
+    }
+
+    case binary_expr_kind: {
+      Binary_expr const* b = static_cast<Binary_expr const*>(e);
+      Value v1, v2;
+      if (n == 0 || !value(b->left(), n - 1, v1))
+        return false;
+      if ((b->op() == log_and_op && !v1) || (b->op() == log_or_op && v1)) {
+        v = v1 != 0;
+        return true;
+      }
+      if (!value(b->right(), n - 1, v2))
+        return false;
+      if ((b->op() == num_div_op || b->op() == num_mod_op) && v2 == 0)
+        return false;
+      v = evaluate(b->op(), v1, v2);
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+
+// Push the value of the expression `e`, if it can be computed
+// directly, and return true. Otherwise, push a step evaluating
+// `e`, and return false.
+inline bool
+Interpreter::push(Expr const* e)
+{
+  Value v;
+  if (value(e, direct_depth, v)) {
+    values.push_back(v);
+    return true;
+  }
+  work.push_back(Step{e, nullptr, nullptr, 0, 0});
+  return false;
+}
+
+
+// Execute the statement `s` directly, if it is a declaration,
+// expression statement, or assignment whose value can be
+// computed directly, and return true. Otherwise, push a step
+// executing `s`, and return false.
+//
+// When the condition of an if statement can be computed
+// directly, the chosen branch replaces the statement. A return
+// statement whose value can be computed directly finishes the
+// enclosing call, and false is returned.
+inline bool
+Interpreter::push(Stmt const* s)
+{
+  Value v;
+  while (true) {
+    switch (s->kind()) {
+      case empty_stmt_kind:
+        return true;
+
+      case declaration_stmt_kind: {
+        Decl const* d = static_cast<Declaration_stmt const*>(s)->decl();
+        if (d->kind() != variable_decl_kind)
+          return true;
+        Variable_decl const* var = static_cast<Variable_decl const*>(d);
+        if (!var->initializer()) {
+          object(var) = 0;
+          return true;
+        }
+        if (value(var->initializer(), direct_depth, v)) {
+          object(var) = v;
+          return true;
+        }
+        break;
+      }
+
+      case expression_stmt_kind:
+        if (value(static_cast<Expression_stmt const*>(s)->expr(), direct_depth, v))
+          return true;
+        break;
+
+      case assignment_stmt_kind: {
+        Assignment_stmt const* a = static_cast<Assignment_stmt const*>(s);
+        if (value(a->rhs(), direct_depth, v)) {
+          object(cast<Identifier_expr>(a->lhs())->decl()) = v;
+          return true;
+        }
+        break;
+      }
+
+      case if_then_stmt_kind: {
+        If_then_stmt const* s1 = static_cast<If_then_stmt const*>(s);
+        if (value(s1->condition(), direct_depth, v)) {
+          if (!v)
+            return true;
+          s = s1->branch();
+          continue;
+        }
+        break;
+      }
+
+      case if_else_stmt_kind: {
+        If_else_stmt const* s1 = static_cast<If_else_stmt const*>(s);
+        if (value(s1->condition(), direct_depth, v)) {
+          s = v ? s1->true_branch() : s1->false_branch();
+          continue;
+        }
+        break;
+      }
+
+      case exit_stmt_kind:
+        ret(0);
+        return false;
+
+      case return_stmt_kind:
+        if (value(static_cast<Return_stmt const*>(s)->result(), direct_depth, v)) {
+          ret(v);
+          return false;
+        }
+        break;
+
+      default:
+        break;
+    }
+    work.push_back(Step{nullptr, s, nullptr, 0, 0});
+    return false;
+  }
+}
+
+
+// Pop the value of the most recently evaluated expression.
+inline Value
+Interpreter::pop()
+{
+  Value v = values.back();
+  values.pop_back();
+  return v;
+}
+
+
+// Run the step `s` and the steps that it starts, returning
+// the value of its expression or call.
+Value
+Interpreter::run(Step s)
+{
+  work.push_back(s);
+  while (!work.empty()) {
+    Step& s1 = work.back();
+    bool done = s1.expr ? eval(s1) : s1.stmt ? exec(s1) : invoke(s1);
+    if (done)
+      work.pop_back();
+  }
+  return pop();
+}
+
+
+// Advance the evaluation of an expression. Returns true when
+// its value is on the top of the value stack.
+//
+// The state of the step is set before each operand is pushed,
+// since pushing a step invalidates `s`. When the value of an
+// operand is pushed directly, evaluation continues with the
+// next state.
+//
+// Note that references to objects have no separate value, so
+// the value of an identifier is the value of its object.
+bool
+Interpreter::eval(Step& s)
+{
+  Expr const* e = s.expr;
+  switch (e->kind()) {
+    case constant_expr_kind:
+      values.push_back(static_cast<Constant_expr const*>(e)->value());
+      return true;
+
+    case identifier_expr_kind: {
+      Decl const* d = static_cast<Identifier_expr const*>(e)->decl();
+      if (d->kind() == function_decl_kind) {
+        error(e->location(), "'{}' is not an object", d->name());
+        values.push_back(0);
+        return true;
+      }
+      values.push_back(object(d));
+      return true;
+    }
+
+    case unary_expr_kind: {
+      Unary_expr const* u = static_cast<Unary_expr const*>(e);
+      if (s.state++ == 0 && !push(u->arg()))
+        return false;
+      values.back() = evaluate(u->op(), values.back());
+      return true;
+    }
+
+    case binary_expr_kind: {
+      Binary_expr const* b = static_cast<Binary_expr const*>(e);
+      switch (s.state) {
+        case 0:
+          s.state = 1;
+          if (!push(b->left()))
+            return false;
+          // Fall through.
+
+        // The right operand of a logical operator is evaluated
+        // only when the left does not determine the result.
+        case 1: {
+          Value v1 = values.back();
+          if ((b->op() == log_and_op && !v1) || (b->op() == log_or_op && v1)) {
+            values.back() = v1 != 0;
+            return true;
+          }
+          s.state = 2;
+          if (!push(b->right()))
+            return false;
+          // Fall through.
+        }
+
+        default: {
+          Value v2 = pop();
+          if ((b->op() == num_div_op || b->op() == num_mod_op) && v2 == 0) {
+            error(b->location(), "division by zero");
+            values.back() = 0;
+            return true;
+          }
+          values.back() = evaluate(b->op(), values.back(), v2);
+          return true;
+        }
+      }
+    }
+
+    case call_expr_kind: {
+      Call_expr const* c = static_cast<Call_expr const*>(e);
+      Function_decl const* f = nullptr;
+      if (Identifier_expr const* id = as<Identifier_expr>(c->function()))
+        f = as<Function_decl>(id->decl());
+      if (!f) {
+        error(c->location(), "indirect calls are not supported");
+        values.push_back(0);
+        return true;
+      }
+
+      // Push the arguments, forming the parameters of the
+      // callee's frame. Note that evaluating an argument may
+      // push and pop frames above these.
+      Expr_seq const& args = c->arguments();
+      if (s.state > 0)
+        stack.push_back(pop());
+      while (s.state < args.size()) {
+        if (!push(args[s.state++]))
+          return false;
+        stack.push_back(pop());
+      }
+
+      // The call replaces this step.
+      s = Step{nullptr, nullptr, f, 0, 0};
+      return false;
+    }
+  }
+  lingo_unreachable();
+}
+
+
+// Advance the execution of a statement. Returns true when
+// the statement is finished. A return statement finishes the
+// call of the enclosing function instead (see ret).
+//
+// As with expressions, the state of the step is set before
+// each part is pushed, and execution continues when a part is
+// finished directly.
+//
+// Note that the value of an object is computed before the
+// object is referenced. Computing a value may grow the stack,
+// invalidating references into it.
+bool
+Interpreter::exec(Step& s)
+{
+  Stmt const* s1 = s.stmt;
+  switch (s1->kind()) {
+    case empty_stmt_kind:
+      return true;
+
+    case declaration_stmt_kind: {
+      Decl const* d = static_cast<Declaration_stmt const*>(s1)->decl();
+      if (d->kind() == variable_decl_kind) {
+        Variable_decl const* v = static_cast<Variable_decl const*>(d);
+        Value x = 0;
+        if (v->initializer()) {
+          if (s.state++ == 0 && !push(v->initializer()))
+            return false;
+          x = pop();
+        }
+        object(v) = x;
+      }
+      return true;
+    }
+
+    case expression_stmt_kind:
+      if (s.state++ == 0 && !push(static_cast<Expression_stmt const*>(s1)->expr()))
+        return false;
+      pop();
+      return true;
+
+    case assignment_stmt_kind: {
+      Assignment_stmt const* a = static_cast<Assignment_stmt const*>(s1);
+      if (s.state++ == 0 && !push(a->rhs()))
+        return false;
+      Value x = pop();
+      object(cast<Identifier_expr>(a->lhs())->decl()) = x;
+      return true;
+    }
+
+    case if_then_stmt_kind: {
+      If_then_stmt const* s2 = static_cast<If_then_stmt const*>(s1);
+      if (s.state == 0) {
+        s.state = 1;
+        if (!push(s2->condition()))
+          return false;
+      }
+      if (s.state == 1) {
+        s.state = 2;
+        if (pop() && !push(s2->branch()))
+          return false;
+      }
+      return true;
+    }
+
+    case if_else_stmt_kind: {
+      If_else_stmt const* s2 = static_cast<If_else_stmt const*>(s1);
+      if (s.state == 0) {
+        s.state = 1;
+        if (!push(s2->condition()))
+          return false;
+      }
+      if (s.state == 1) {
+        s.state = 2;
+        if (!push(pop() ? s2->true_branch() : s2->false_branch()))
+          return false;
+      }
+      return true;
+    }
+
+    // The condition is evaluated in state 0, and tested in
+    // state 1.
+    case while_stmt_kind: {
+      While_stmt const* s2 = static_cast<While_stmt const*>(s1);
+      while (true) {
+        if (s.state == 0) {
+          s.state = 1;
+          if (!push(s2->condition()))
+            return false;
+        }
+        if (!pop())
+          return true;
+        s.state = 0;
+        if (!push(s2->body()))
+          return false;
+      }
+    }
+
+    // The body is executed in state 0, the condition is
+    // evaluated in state 1, and tested in state 2.
+    case do_stmt_kind: {
+      Do_stmt const* s2 = static_cast<Do_stmt const*>(s1);
+      while (true) {
+        if (s.state == 0) {
+          s.state = 1;
+          if (!push(s2->body()))
+            return false;
+        }
+        if (s.state == 1) {
+          s.state = 2;
+          if (!push(s2->condition()))
+            return false;
+        }
+        if (!pop())
+          return true;
+        s.state = 0;
+      }
+    }
+
+    case exit_stmt_kind:
+      ret(0);
+      return false;
+
+    case return_stmt_kind:
+      if (s.state++ == 0 && !push(static_cast<Return_stmt const*>(s1)->result()))
+        return false;
+      ret(pop());
+      return false;
+
+    case block_stmt_kind: {
+      Stmt_seq const& ss = static_cast<Block_stmt const*>(s1)->statements();
+      while (s.state < ss.size())
+        if (!push(ss[s.state++]))
+          return false;
+      return true;
+    }
+  }
+  lingo_unreachable();
+}
+
+
+// Advance the call of a function. The arguments of the call
+// have been pushed on the stack, and they are the initial values
+// of the parameters. Returns true if the function is not
+// defined.
+bool
+Interpreter::invoke(Step& s)
+{
+  Function_decl const* f = s.fn;
+  if (s.state++ == 0) {
+    std::size_t base = stack.size() - f->parameters().size();
+    Stmt const* body = f->body();
+    if (!is_valid_node(body)) {
+      error(f->location(), "'{}' is not defined", f->name());
+      stack.resize(base);
+      values.push_back(0);
+      return true;
+    }
+    s.frame = frame;
+    frame = base;
+    stack.resize(base + f->frame_size());
+    if (!push(body))
+      return false;
+  }
+
+  // The body finished without returning a value.
+  ret(0);
+  return false;
+}
+
+
+// Return the value `v` from the innermost call, abandoning the
+// statements in progress in the body of the function, and
+// restoring the frame of the caller.
+void
+Interpreter::ret(Value v)
+{
+  while (work.back().stmt)
+    work.pop_back();
+  stack.resize(frame);
+  frame = work.back().frame;
+  work.pop_back();
+  values.push_back(v);
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Entry points
+
+// Returns the function named `name` in the unit `u`, or
+// nullptr if there is no such function.
+Function_decl const*
+find_function(Unit const* u, char const* name)
+{
+  for (Decl const* d : u->declarations())
+    if (Function_decl const* f = as<Function_decl>(d))
+      if (*f->name() == name)
+        return f;
+  return nullptr;
+}
+
+
+// Run the program `u`, starting with the function named `name`
+// and the given arguments. Returns the value returned by that
+// function.
+Value
+interpret(Unit const* u, char const* name, Value_seq const& args)
+{
+  Function_decl const* f = find_function(u, name);
+  if (!f) {
+    error("no function named '{}'", name);
+    return 0;
+  }
+  Interpreter interp(u);
+  return interp.call(f, args);
+}
+
+
+} // namespace beaker
@@ -0,0 +1,96 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_INTERPRET_HPP
+#define BEAKER_INTERPRET_HPP
+
+// This module provides an interpreter for Beaker programs.
+// The interpreter executes the statements of functions by
+// walking their syntax trees.
+//
+// Before a program is run, each variable and parameter is
+// assigned a slot (see Slot in decl.hpp). Global variables
+// are stored in the static store of the interpreter, and local
+// variables and parameters in the frame of their function.
+// Frames are allocated on a single stack of values. Slots of
+// variables declared in disjoint blocks may be shared.
+//
+// A nested function has no access to the frames of its
+// enclosing functions. A reference to a local variable or
+// parameter of an enclosing function is diagnosed when slots
+// are assigned, and the function is left undefined.
+
+#include "beaker/prelude.hpp"
+#include "beaker/value.hpp"
+
+#include <vector>
+
+
+namespace beaker
+{
+
+// The interpreter holds the state of an executing program.
+// Constructing an interpreter assigns the slots of the unit's
+// declarations and initializes its global variables, in order
+// of declaration.
+//
+// Expressions, statements, and calls are run using an explicit
+// stack of steps, so neither the depth of the syntax trees nor
+// the depth of calls is limited by the call stack. The values
+// of evaluated expressions are kept on a separate stack. Small
+// expressions without calls, and the statements that use them,
+// are run directly rather than by steps.
+//
+// Runtime errors (e.g., division by 0) are diagnosed, and
+// execution continues with the value 0.
+struct Interpreter
+{
+  // A step is the evaluation of an expression, the execution
+  // of a statement, or a call of a function. The state of a
+  // step is the number of times it has been advanced.
+  struct Step
+  {
+    Expr const*          expr;  // The evaluated expression, or
+    Stmt const*          stmt;  // the executed statement, or
+    Function_decl const* fn;    // the called function
+    std::size_t          state; // The progress of the step
+    std::size_t          frame; // The frame of the caller
+  };
+
+  explicit Interpreter(Unit const*);
+
+  Value call(Function_decl const*, Value_seq const&);
+
+  Value run(Step);
+  bool  eval(Step&);
+  bool  exec(Step&);
+  bool  invoke(Step&);
+  void  ret(Value);
+
+  bool  value(Expr const*, int, Value&);
+  bool  push(Expr const*);
+  bool  push(Stmt const*);
+  Value pop();
+
+  Value& object(Decl const*);
+
+  Unit const*       unit;   // The program
+  Value_seq         store;  // Global variables
+  Value_seq         stack;  // Frames of active calls
+  std::size_t       frame;  // The base of the current frame
+  std::vector<Step> work;   // Steps in progress
+  Value_seq         values; // Values of evaluated expressions
+};
+
+
+void allocate_slots(Unit const*);
+
+Function_decl const* find_function(Unit const*, char const*);
+
+Value interpret(Unit const*, char const*, Value_seq const& = {});
+
+
+} // namespace beaker
+
+
+#endif
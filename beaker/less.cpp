@@ -5,116 +5,70 @@
 #include "beaker/type.hpp"
 #include "beaker/expr.hpp"
 
-#include <typeindex>
-
 
 namespace beaker
 {
 
-// Dispatch to an appropriate function.
-struct Type_less_fn
-{
-  Type_less_fn(Type const* t)
-    : t2(t)
-  { }
-
-  bool operator()(Void_type const* t1) const
-  { 
-    return less(t1, cast<Void_type>(t2)); 
-  }
-  
-  bool operator()(Boolean_type const* t1) const
-  { 
-    return less(t1, cast<Boolean_type>(t2)); 
-  }
-  
-  bool operator()(Integer_type const* t1) const
-  { 
-    return less(t1, cast<Integer_type>(t2)); 
-  }
-  
-  bool operator()(Function_type const* t1) const
-  { 
-    return less(t1, cast<Function_type>(t2)); 
-  }
-
-  bool operator()(Reference_type const* t1) const
-  { 
-    return less(t1, cast<Reference_type>(t2)); 
-  }
-
-  Type const* t2;
-};
-
-
-// Returns true if one type is less than another.
+// Returns true if one type is less than another. Types
+// are ordered first by kind and then by structure.
 bool 
 less(Type const* a, Type const* b)
 {
-  // Abritrarily order types by their type information.
-  std::type_index t1 = typeid(*a);
-  std::type_index t2 = typeid(*b);
-  if (t1 < t2)
-    return true;
-  if (t2 < t1)
+  if (a == b)
     return false;
-
-  // If two types are equivalent, then dispatch to
-  // an appropriate function.
-  return apply(a, Type_less_fn(b));
+  if (a->kind() != b->kind())
+    return a->kind() < b->kind();
+
+  switch (a->kind()) {
+  case void_type_kind:
+    return less(static_cast<Void_type const*>(a),
+                static_cast<Void_type const*>(b));
+  case boolean_type_kind:
+    return less(static_cast<Boolean_type const*>(a),
+                static_cast<Boolean_type const*>(b));
+  case integer_type_kind:
+    return less(static_cast<Integer_type const*>(a),
+                static_cast<Integer_type const*>(b));
+  case function_type_kind:
+    return less(static_cast<Function_type const*>(a),
+                static_cast<Function_type const*>(b));
+  case reference_type_kind:
+    return less(static_cast<Reference_type const*>(a),
+                static_cast<Reference_type const*>(b));
+  }
+  lingo_unreachable();
 }
 
 
-// Returns true if one type is less than another.
+// Returns true if one expression is less than another.
+// Expressions are ordered first by kind and then by
+// structure.
 bool 
 less(Expr const* a, Expr const* b)
 {
-  // Abritrarily order types by their type information.
-  std::type_index t1 = typeid(*a);
-  std::type_index t2 = typeid(*b);
-  if (t1 < t2)
-    return true;
-  if (t2 < t1)
+  if (a == b)
     return false;
-
-  struct Fn
-  {
-    Fn(Expr const* b)
-      : b(b)
-    { }
-
-    bool operator()(Constant_expr const* a) const 
-    { 
-      return less(a, cast<Constant_expr>(b)); 
-    }
-
-    bool operator()(Identifier_expr const* a) const 
-    { 
-      return less(a, cast<Identifier_expr>(b)); 
-    }
-
-    bool operator()(Unary_expr const* a) const 
-    { 
-      return less(a, cast<Unary_expr>(b)); 
-    }
-
-    bool operator()(Binary_expr const* a) const 
-    { 
-      return less(a, cast<Binary_expr>(b)); 
-    }
-
-    bool operator()(Call_expr const* a) const 
-    { 
-      return less(a, cast<Call_expr>(b)); 
-    }
-
-    Expr const* b;
-  };
-
-
-  // If two types are equivalent, then dispatch to
-  // an appropriate function.
-  return apply(a, Fn(b));
+  if (a->kind() != b->kind())
+    return a->kind() < b->kind();
+
+  switch (a->kind()) {
+  case constant_expr_kind:
+    return less(static_cast<Constant_expr const*>(a),
+                static_cast<Constant_expr const*>(b));
+  case identifier_expr_kind:
+    return less(static_cast<Identifier_expr const*>(a),
+                static_cast<Identifier_expr const*>(b));
+  case unary_expr_kind:
+    return less(static_cast<Unary_expr const*>(a),
+                static_cast<Unary_expr const*>(b));
+  case binary_expr_kind:
+    return less(static_cast<Binary_expr const*>(a),
+                static_cast<Binary_expr const*>(b));
+  case call_expr_kind:
+    return less(static_cast<Call_expr const*>(a),
+                static_cast<Call_expr const*>(b));
+  }
+  lingo_unreachable();
 }
 
 
@@ -72,9 +72,9 @@ less(T const* a, T const* b)
 
 
 // Lexicographically compares sequences of terms.
-template<typename T>
+template<typename T, std::size_t N>
 inline bool
-less(std::vector<T const*> const& a, std::vector<T const*> const& b)
+less(Small_vector<T const*, N> const& a, Small_vector<T const*, N> const& b)
 {
   auto cmp = [](T const* a, T const* b) { return less(a, b); };
   return std::lexicographical_compare(a.begin(), a.end(), 
@@ -2,14 +2,24 @@
 // All rights reserved
 
 #include "beaker/lexer.hpp"
+#include "beaker/scan.hpp"
+#include "beaker/thread.hpp"
+#include "beaker/context.hpp"
+#include "beaker/diagnostic.hpp"
 
 #include "lingo/lexing.hpp"
 #include "lingo/symbol.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <cassert>
 #include <cctype>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 
 using namespace lingo;
@@ -20,20 +30,84 @@ namespace beaker
 namespace
 {
 
+// The lexical analysis functions are parameterized over the
+// lexer, which supplies the actions taken for each token. See
+// the Lexer class for the required interface.
+
+
 // Consume until the end of line.
+template<typename Lexer>
 void
-comment(Lexer& lex, Character_stream& cs, Location loc)
+comment(Lexer& lex, Source_stream& cs, Location loc)
 {
   char const* init = cs.begin();
-  while (next_element_is_not(cs, '\n'))
-    cs.get();
+  cs.advance(find_newline(init, cs.end()));
   lex.on_comment(loc, init, cs.begin());
 }
 
 
+// Lex an identifier. The first character is known to be
+// an identifier-start character.
+template<typename Lexer>
+Token
+identifier(Lexer& lex, Source_stream& cs, Location loc)
+{
+  char const* first = cs.begin();
+  cs.advance(skip_identifier(first + 1, cs.end()));
+  return lex.on_identifier(loc, first, cs.begin());
+}
+
+
+inline bool
+is_hexadecimal_digit(char c)
+{
+  return is_decimal_digit(c) || ('a' <= (c | 0x20) && (c | 0x20) <= 'f');
+}
+
+
+inline bool
+is_binary_digit(char c)
+{
+  return c == '0' || c == '1';
+}
+
+
+// Lex an integer. The first character is known to be a
+// decimal digit. Hexadecimal integers have the prefix 0x
+// and binary integers have the prefix 0b. The prefix must
+// be followed by at least one digit.
+template<typename Lexer>
+Token
+integer(Lexer& lex, Source_stream& cs, Location loc)
+{
+  char const* first = cs.begin();
+  char const* last = cs.end();
+  if (*first == '0' && last - first > 2) {
+    char c = first[1] | 0x20;
+    if (c == 'x' && is_hexadecimal_digit(first[2])) {
+      char const* p = first + 3;
+      while (p != last && is_hexadecimal_digit(*p))
+        ++p;
+      cs.advance(p);
+      return lex.on_integer(loc, first, p, 16);
+    }
+    if (c == 'b' && is_binary_digit(first[2])) {
+      char const* p = first + 3;
+      while (p != last && is_binary_digit(*p))
+        ++p;
+      cs.advance(p);
+      return lex.on_integer(loc, first, p, 2);
+    }
+  }
+  cs.advance(skip_digits(first + 1, last));
+  return lex.on_integer(loc, first, cs.begin(), 10);
+}
+
+
 // Lexically analyze a single token.
+template<typename Lexer>
 Token
-token(Lexer& lex, Character_stream& cs)
+token(Lexer& lex, Source_stream& cs)
 {
   while (!cs.eof()) {
     Location loc = cs.location();
@@ -42,7 +116,7 @@ token(Lexer& lex, Character_stream& cs)
     case '\t':
     case '\n':
       // Consume the WS and continue lexing.
-      cs.get();
+      cs.advance(skip_space(cs.begin(), cs.end()));
       break;
 
     case '{': return lex.on_lexeme(loc, &cs.get(), 1);
@@ -119,13 +193,12 @@ token(Lexer& lex, Character_stream& cs)
     
     default:
       if (is_identifier_start(cs.peek()))
-        return lex_identifier(lex, cs, loc);
+        return identifier(lex, cs, loc);
       
       if (is_decimal_digit(cs.peek()))
-        return lex_decimal_integer(lex, cs, loc);
+        return integer(lex, cs, loc);
       
-      error(loc, "unrecognized character '{}'", cs.peek());
-      cs.get();
+      lex.on_error(loc, cs.get());
     }
   }
 
@@ -133,30 +206,154 @@ token(Lexer& lex, Character_stream& cs)
 }
 
 
+// -------------------------------------------------------------------------- //
+//                            Parallel lexing
+//
+// Because no token spans a newline, the buffer can be divided
+// into line-aligned chunks that are lexed independently. Each
+// chunk is lexed over the entire buffer so token locations do
+// not need to be adjusted.
+//
+// The symbol table of the context is not synchronized, so chunk
+// lexers share a lock that guards interning. To avoid contention,
+// each chunk caches the symbols it has seen and takes the lock
+// only for spellings that are new to the chunk. Diagnostics are
+// saved and emitted, in order, after all chunks have been lexed.
+
+
+// The lexical actions for a single chunk.
+struct Chunk_lexer
+{
+  Chunk_lexer(Context& c, std::mutex& m)
+    : cxt_(c), mutex_(m)
+  { }
+
+  Token on_lexeme(Location, char const*, int);
+  Token on_identifier(Location, char const*, char const*);
+  Token on_integer(Location, char const*, char const*, int);
+
+  void on_comment(Location, char const*, char const*) { }
+  void on_error(Location loc, char c) { errs_.push_back({loc, c}); }
+
+  Token intern(Location, char const*, char const*, int);
+
+  using Cache = std::unordered_map<Spelling, Symbol const*, Spelling_hash>;
+  using Error = std::pair<Location, char>;
+
+  Context&           cxt_;   // The compilation
+  std::mutex&        mutex_; // Guards the symbol table
+  Cache              cache_; // Symbols seen in this chunk
+  std::vector<Error> errs_;  // Unrecognized characters
+  Token_list         toks_;  // Tokens in this chunk
+};
+
+
+// Returns a token for the spelling [first, last). Tokens are
+// constructed exactly as the lexer would, but the symbol table
+// is accessed only on the first occurrence of a spelling.
+Token
+Chunk_lexer::intern(Location loc, char const* first, char const* last, int k)
+{
+  Spelling s {first, std::size_t(last - first)};
+  auto iter = cache_.find(s);
+  if (iter == cache_.end()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Symbol_table& syms = cxt_.symbols;
+    iter = cache_.insert({s, &syms.symbol(syms.intern(first, last, k))}).first;
+  }
+  Symbol const& sym = *iter->second;
+  return Token(loc, sym.token, sym);
+}
+
+
+Token
+Chunk_lexer::on_lexeme(Location loc, char const* str, int n)
+{
+  return intern(loc, str, str + n, -1);
+}
+
+
+Token
+Chunk_lexer::on_identifier(Location loc, char const* first, char const* last)
+{
+  if (Symbol const* sym = get_keyword(first, last))
+    return Token(loc, sym->token, *sym);
+  return intern(loc, first, last, identifier_tok);
+}
+
+
+Token
+Chunk_lexer::on_integer(Location loc, char const* first, char const* last, int)
+{
+  return intern(loc, first, last, integer_tok);
+}
+
+
+// Returns the chunks of the text of `buf`, each having at
+// least `n` characters (except possibly the last) and ending
+// just after a newline or at the end of the buffer.
+std::vector<Spelling>
+split_lines(Buffer const& buf, std::size_t n)
+{
+  std::vector<Spelling> chunks;
+  char const* first = buf.begin();
+  char const* last = buf.end();
+  while (first != last) {
+    char const* p = std::size_t(last - first) > n ? first + n : last;
+    p = find_newline(p, last);
+    if (p != last)
+      ++p;
+    chunks.push_back({first, std::size_t(p - first)});
+    first = p;
+  }
+  return chunks;
+}
+
+
 } // namespace
 
 
+// Returns a token for the spelling [first, last), recording
+// the id of its symbol.
+Token
+Lexer::intern(Location loc, char const* first, char const* last, int k)
+{
+  Symbol_table& syms = current_context().symbols;
+  id = syms.intern(first, last, k);
+  Symbol const& sym = syms.symbol(id);
+  return Token(loc, sym.token, sym);
+}
+
+
 Token
 Lexer::on_lexeme(Location loc, char const* str, int n)
 {
-  return Token(loc, str, n);
+  return intern(loc, str, str + n, -1);
 }
 
 
+// The value of the integer is computed here, from the source
+// text, so that the parser never needs to convert the literal.
+// The base is determined by the prefix of the spelling.
 Token
 Lexer::on_integer(Location loc, char const* first, char const* last, int)
 {
-  // The integer base is currently ignored.
-  return Token(loc, integer_tok, first, last);
+  value = to_integer(first, last);
+  return intern(loc, first, last, integer_tok);
 }
 
 
 Token
 Lexer::on_identifier(Location loc, char const* first, char const* last)
 {
-  // If [first, last) is a keyword, the resulting token will
-  // be that keyword and not the identifier.
-  return Token(loc, identifier_tok, first, last);
+  // Keywords are classified without interning the spelling.
+  int k = get_keyword_id(first, last);
+  if (k >= 0) {
+    id = k;
+    Symbol const& sym = get_symbol_by_id(id);
+    return Token(loc, sym.token, sym);
+  }
+  return intern(loc, first, last, identifier_tok);
 }
 
 
@@ -167,18 +364,311 @@ Lexer::on_comment(Location, char const*, char const*)
 }
 
 
+void
+Lexer::on_error(Location loc, char c)
+{
+  diagnose(loc, "unrecognized character '{}'", c);
+}
+
+
+// Lex tokens until there are at least n + 1 unconsumed tokens
+// in the stream. Returns false if the input is exhausted first.
+bool
+Token_stream::fill(std::size_t n)
+{
+  while (buf_.size() - pos_ <= n) {
+    if (done_)
+      return false;
+    if (Token tok = token(lex_, cs_))
+      buf_.push_back(tok, lex_.id, lex_.value);
+    else
+      done_ = true;
+  }
+  return true;
+}
+
+
+// Discard all consumed tokens. Any pointers or references to
+// those tokens are invalidated.
+void
+Token_stream::release()
+{
+  buf_.erase(pos_);
+  toks_.clear();
+  pos_ = 0;
+  int_ = 0;
+}
+
+
 // Lex all tokens in the character stream.
 Token_list 
 lex(Buffer& buf)
 {
   Input_context cxt(buf);
-  Character_stream cs(buf);
-  Lexer lexer;
+  Token_stream ts(buf);
   Token_list toks;
-  while (Token tok = token(lexer, cs))
-    toks.push_back(tok);
+  while (!ts.eof()) {
+    toks.push_back(ts.get());
+    ts.release();
+  }
   return toks;
 }
 
 
+// Lex all tokens in the character stream within the given
+// compilation context.
+Token_list
+lex(Context& cxt, Buffer& buf)
+{
+  Use_context use(cxt);
+  return lex(buf);
+}
+
+
+// Lex all tokens in the character stream, dividing the work
+// among the threads of `pool`. The buffer is divided into
+// chunks of approximately `n` characters. The resulting tokens
+// and diagnostics are the same as for lex(buf).
+//
+// Chunks are claimed from a shared cursor by the workers and the
+// calling thread, so lexing completes even when the pool has no
+// workers.
+Token_list
+lex(Buffer& buf, Thread_pool& pool, std::size_t n)
+{
+  Input_context cxt(buf);
+  std::vector<Spelling> chunks = split_lines(buf, n);
+  if (chunks.size() < 2)
+    return lex(buf);
+
+  std::mutex mutex;
+  std::vector<Chunk_lexer> lexers(chunks.size(), Chunk_lexer(current_context(), mutex));
+  std::atomic<std::size_t> next(0);
+  auto work = [&]() {
+    for (std::size_t i = next++; i < chunks.size(); i = next++) {
+      Chunk_lexer& lex = lexers[i];
+      Source_stream cs(buf, chunks[i].first, chunks[i].first + chunks[i].size);
+      while (Token tok = token(lex, cs))
+        lex.toks_.push_back(tok);
+    }
+  };
+  std::size_t m = std::min<std::size_t>(pool.size(), chunks.size() - 1);
+  for (std::size_t i = 0; i < m; ++i)
+    pool.submit(work);
+  work();
+  pool.wait();
+
+  // Report errors and join the chunks.
+  Lexer lex;
+  std::size_t size = 0;
+  for (Chunk_lexer const& c : lexers) {
+    for (Chunk_lexer::Error const& e : c.errs_)
+      lex.on_error(e.first, e.second);
+    size += c.toks_.size();
+  }
+  Token_list toks;
+  toks.reserve(size);
+  for (Chunk_lexer const& c : lexers)
+    toks.insert(toks.end(), c.toks_.begin(), c.toks_.end());
+  return toks;
+}
+
+
+// -------------------------------------------------------------------------- //
+//                            Incremental lexing
+
+namespace
+{
+
+// The number of tokens in a block of an edit list.
+constexpr std::size_t block_size = 256;
+
+
+// Returns the offset just past the token `t` in a block starting
+// at `start`.
+inline std::size_t
+end_offset(std::size_t start, Edit_list::Entry const& t)
+{
+  return start + t.offset + t.sym->str.size();
+}
+
+
+} // namespace
+
+
+// Lex all tokens in the text of `buf`.
+Edit_list::Edit_list(Buffer& buf)
+  : buf_(&buf), count_(0)
+{
+  std::vector<Entry> toks;
+  for (Token const& tok : lex(buf))
+    toks.push_back({std::size_t(tok.location().offset()), tok.kind(), &tok.symbol()});
+  splice(0, 0, toks);
+  count_ = toks.size();
+}
+
+
+// Returns the list of all tokens.
+Token_list
+Edit_list::tokens() const
+{
+  Token_list toks;
+  toks.reserve(count_);
+  for (Block const& b : blocks_) {
+    for (Entry const& e : b.toks)
+      toks.push_back(Token(Location(buf_, b.start + e.offset), e.kind, *e.sym));
+  }
+  return toks;
+}
+
+
+// Replace the blocks [first, last) with blocks holding the
+// tokens `toks`, whose offsets are absolute.
+void
+Edit_list::splice(std::size_t first, std::size_t last, std::vector<Entry> const& toks)
+{
+  std::vector<Block> blocks;
+  std::size_t n = toks.size() <= 2 * block_size ? toks.size() : block_size;
+  for (std::size_t i = 0; i < toks.size(); i += n) {
+    std::size_t k = std::min(i + n, toks.size());
+    Block b {toks[i].offset, {}};
+    b.toks.reserve(k - i);
+    for (std::size_t j = i; j < k; ++j)
+      b.toks.push_back({toks[j].offset - b.start, toks[j].kind, toks[j].sym});
+    blocks.push_back(std::move(b));
+  }
+  blocks_.erase(blocks_.begin() + first, blocks_.begin() + last);
+  blocks_.insert(blocks_.begin() + first,
+                 std::make_move_iterator(blocks.begin()),
+                 std::make_move_iterator(blocks.end()));
+}
+
+
+// Update the tokens so that they are the tokens of `buf`,
+// which is the text of the previous buffer after applying the
+// edit `e`. Returns the range of tokens that were lexed from
+// the edited text; all other tokens are the original tokens,
+// which now refer to `buf`.
+//
+// Lexing restarts at the start of the last token that ends
+// before the edit, and that token is lexed again. The lexer looks
+// up to two characters past the start of a token (e.g., for the
+// prefix "0x"), so a token that ends before the edit can still
+// change when the character after it is part of a prefix. The
+// token before it cannot, since its lookahead ends within the
+// unchanged text. Lexing stops once a token starts at
+// the (adjusted) offset of an original token past the edit. Since
+// the lexer carries no state between tokens, and the text beyond
+// the edit is unchanged, every remaining token is the same.
+Token_range
+Edit_list::relex(Buffer& buf, Text_edit const& e)
+{
+  Input_context cxt(buf);
+  std::ptrdiff_t delta = std::ptrdiff_t(e.inserted) - std::ptrdiff_t(e.removed);
+
+  // Find the first token that ends at or after the edit, and
+  // back up to the token preceding it. That token is at index
+  // `i` of the block `b`.
+  auto block_before = [](Block const& b, std::size_t n) {
+    return end_offset(b.start, b.toks.back()) < n;
+  };
+  auto block = std::lower_bound(blocks_.begin(), blocks_.end(), e.offset, block_before);
+  std::size_t b = block - blocks_.begin();
+  std::size_t i = 0;
+  if (block != blocks_.end()) {
+    std::size_t start = block->start;
+    auto token_before = [start](Entry const& t, std::size_t n) {
+      return end_offset(start, t) < n;
+    };
+    auto tok = std::lower_bound(block->toks.begin(), block->toks.end(), e.offset, token_before);
+    i = tok - block->toks.begin();
+  }
+  if (i != 0)
+    --i;
+  else if (b != 0)
+    i = blocks_[--b].toks.size() - 1;
+
+  // Lexing starts at the end of the token preceding it.
+  std::size_t start = 0;
+  if (i != 0)
+    start = end_offset(blocks_[b].start, blocks_[b].toks[i - 1]);
+  else if (b != 0)
+    start = end_offset(blocks_[b - 1].start, blocks_[b - 1].toks.back());
+
+  // Re-lex until we reach an original token past the edit. The
+  // original tokens are visited by the cursor (sb, si). Note that
+  // the cursor skips original tokens that started in the removed
+  // text.
+  std::size_t sb = b;
+  std::size_t si = i;
+  auto original = [&]() {
+    return blocks_[sb].start + blocks_[sb].toks[si].offset;
+  };
+  auto advance = [&]() {
+    if (++si == blocks_[sb].toks.size()) {
+      ++sb;
+      si = 0;
+    }
+  };
+  std::size_t old_end = e.offset + e.removed;
+  std::size_t new_end = e.offset + e.inserted;
+  std::vector<Entry> lexed;
+  Source_stream cs(buf, buf.begin() + start, buf.end());
+  Lexer lex;
+  bool synced = false;
+  while (Token tok = token(lex, cs)) {
+    std::size_t n = tok.location().offset();
+    if (n >= new_end) {
+      while (sb != blocks_.size() && original() < old_end)
+        advance();
+      while (sb != blocks_.size() && original() + delta < n)
+        advance();
+      if (sb != blocks_.size() && original() + delta == n) {
+        synced = true;
+        break;
+      }
+    }
+    lexed.push_back({n, tok.kind(), &tok.symbol()});
+  }
+  if (!synced) {
+    sb = blocks_.size();
+    si = 0;
+  }
+
+  // Collect the tokens of the affected blocks: those preceding the
+  // relexed tokens in the first block, the relexed tokens, and
+  // those following the replaced tokens in the last block.
+  std::size_t first = 0;
+  for (std::size_t n = 0; n < b; ++n)
+    first += blocks_[n].toks.size();
+  std::size_t last = std::min(sb + 1, blocks_.size());
+  std::size_t removed = 0;
+  for (std::size_t n = b; n < last; ++n)
+    removed += blocks_[n].toks.size();
+
+  std::vector<Entry> toks;
+  if (b != blocks_.size()) {
+    Block const& blk = blocks_[b];
+    for (std::size_t n = 0; n < i; ++n)
+      toks.push_back({blk.start + blk.toks[n].offset, blk.toks[n].kind, blk.toks[n].sym});
+  }
+  toks.insert(toks.end(), lexed.begin(), lexed.end());
+  if (sb != blocks_.size()) {
+    Block const& blk = blocks_[sb];
+    for (std::size_t n = si; n < blk.toks.size(); ++n)
+      toks.push_back({blk.start + blk.toks[n].offset + delta, blk.toks[n].kind, blk.toks[n].sym});
+  }
+  count_ = count_ - removed + toks.size();
+
+  // Replace the affected blocks, and shift those that follow.
+  std::size_t k = blocks_.size() - last;
+  splice(b, last, toks);
+  for (std::size_t n = blocks_.size() - k; n < blocks_.size(); ++n)
+    blocks_[n].start += delta;
+
+  buf_ = &buf;
+  return {first + i, first + i + lexed.size()};
+}
+
+
 } // namespace beaker
@@ -10,29 +10,297 @@
 #include "beaker/prelude.hpp"
 #include "beaker/token.hpp"
 
-#include "lingo/character.hpp"
+#include "lingo/buffer.hpp"
+
+#include <deque>
 
 
 namespace beaker
 {
 
+// A source stream is a character stream over the text of a
+// buffer. Unlike a general character stream, it allows runs
+// of characters to be consumed in a single step, which lets
+// the lexer skip whitespace, comments, and the characters of
+// identifiers and integers with the vectorized scanners.
+//
+// The location of each character is its offset within the
+// buffer.
+struct Source_stream
+{
+  Source_stream(Buffer& b)
+    : buf_(&b), first_(b.begin()), last_(b.end())
+  { }
+
+  Source_stream(Buffer& b, char const* first, char const* last)
+    : buf_(&b), first_(first), last_(last)
+  { }
+
+  bool        eof() const   { return first_ == last_; }
+  char        peek() const  { return *first_; }
+  char const& get()         { return *first_++; }
+  char const* begin() const { return first_; }
+  char const* end() const   { return last_; }
+
+  // Consume all characters up to (but not including) `p`.
+  void advance(char const* p) { first_ = p; }
+
+  Location location() const { return Location(buf_, first_ - buf_->begin()); }
+
+  Buffer*     buf_;
+  char const* first_;
+  char const* last_;
+};
+
+
 // The Lexer class defines the actions taken whenever
 // a sequence of characters as a particular kind of token.
+//
+// The value of an integer literal is computed when it is
+// lexed, and is held by the lexer until the next integer
+// literal is lexed. Likewise, the lexer holds the id of the
+// symbol of the last token, which is assigned when the
+// symbol is interned.
 struct Lexer
 {
   using argument_type = char;
   using result_type = Token;
 
+  Lexer()
+    : id(0), value(0)
+  { }
+
   // Semantic actions.
   Token on_lexeme(Location, char const*, int);
   Token on_identifier(Location, char const*, char const*);
   Token on_integer(Location, char const*, char const*, int);
 
   void on_comment(Location, char const*, char const*);
+  void on_error(Location, char);
+
+  Token intern(Location, char const*, char const*, int);
+
+  std::uint32_t id;    // The symbol id of the last token
+  Value         value; // The value of the last integer literal
+};
+
+
+// A token stream is a lazily lexed sequence of tokens over the
+// text of a buffer. Tokens are lexed only when the parser asks
+// for them, so parsing begins as soon as the first token is
+// available and the input is never lexed ahead of the parser
+// by more than the requested lookahead.
+//
+// Lexed tokens are kept in a compact token buffer. Inspecting
+// the kind of an upcoming token reads a single byte. A Token
+// object is materialized only when the parser consumes it or
+// needs to examine it (e.g., for a diagnostic).
+//
+// Tokens that have been consumed remain valid until the stream
+// is released. This is because the parser holds pointers to the
+// tokens of a term until the semantic action for that term has
+// been invoked. The parser releases the stream after each
+// top-level declaration, so the number of live tokens is bounded
+// by the size of the largest declaration, not the input.
+//
+// Note that this shadows the lingo token stream within this
+// namespace.
+struct Token_stream
+{
+  Token_stream(Buffer& b)
+    : cs_(b), buf_(b), pos_(0), int_(0), done_(false)
+  { }
+
+  Token_stream(Buffer& b, char const* first, char const* last)
+    : cs_(b, first, last), buf_(b), pos_(0), int_(0), done_(false)
+  { }
+
+  bool         eof();
+  int          kind();
+  Value        value();
+  Token        peek();
+  Token        peek(int);
+  Token const& get();
+  Location     location();
+  Buffer&      buffer() { return *cs_.buf_; }
+
+  void skip();
+  void release();
+
+  bool fill(std::size_t);
+
+  Source_stream     cs_;   // The source text
+  Lexer             lex_;  // Lexical actions
+  Token_buffer      buf_;  // Lexed tokens
+  std::size_t       pos_;  // The next token in buf_
+  std::size_t       int_;  // The next integer value in buf_
+  bool              done_; // True when the input is exhausted
+  std::deque<Token> toks_; // Consumed tokens
+};
+
+
+// Returns true when there are no more tokens in the stream.
+inline bool
+Token_stream::eof()
+{
+  return !fill(0);
+}
+
+
+// Returns the kind of the next token, or -1 if the stream
+// is exhausted.
+inline int
+Token_stream::kind()
+{
+  return fill(0) ? buf_.kind(pos_) : -1;
+}
+
+
+// Returns the value of the next token, which must be an
+// integer literal.
+inline Value
+Token_stream::value()
+{
+  lingo_assert(kind() == integer_tok);
+  return buf_.integer(int_);
+}
+
+
+// Returns the next token in the stream or an invalid token
+// when the stream is exhausted. The token is materialized
+// from the token buffer and returned by value.
+inline Token
+Token_stream::peek()
+{
+  return fill(0) ? buf_.token(pos_) : Token();
+}
+
+
+// Returns the nth token past the next, or an invalid token
+// if there is no such token.
+inline Token
+Token_stream::peek(int n)
+{
+  return fill(n) ? buf_.token(pos_ + n) : Token();
+}
+
+
+// Consume and return the next token. Behavior is undefined
+// if the stream is exhausted.
+inline Token const&
+Token_stream::get()
+{
+  fill(0);
+  int_ += buf_.kind(pos_) == integer_tok;
+  toks_.push_back(buf_.token(pos_++));
+  return toks_.back();
+}
+
+
+// Consume the next token without materializing it. Behavior
+// is undefined if the stream is exhausted.
+inline void
+Token_stream::skip()
+{
+  fill(0);
+  int_ += buf_.kind(pos_) == integer_tok;
+  ++pos_;
+}
+
+
+// Returns the location of the next token.
+inline Location
+Token_stream::location()
+{
+  return fill(0) ? buf_.location(pos_) : Location();
+}
+
+
+// Returns the kind of the next token in the stream. This
+// is found by lingo's parsing algorithms via argument
+// dependent lookup, and is preferred to the general
+// version, which would materialize the token.
+inline int
+next_token_kind(Token_stream& ts)
+{
+  return ts.kind();
+}
+
+
+struct Thread_pool;
+
+
+// -------------------------------------------------------------------------- //
+//                            Incremental lexing
+
+// A text edit describes the replacement of `removed` characters
+// at `offset` in the original text with `inserted` characters.
+struct Text_edit
+{
+  std::size_t offset;
+  std::size_t removed;
+  std::size_t inserted;
+};
+
+
+// A token range is a half-open range of indexes in a token
+// list.
+struct Token_range
+{
+  std::size_t first;
+  std::size_t last;
+};
+
+
+// An edit list is the sequence of tokens of a buffer that is
+// edited in place (e.g., by an editor). The tokens are updated
+// incrementally after each edit (see relex()).
+//
+// Tokens are stored in blocks of a few hundred tokens, and the
+// offset of each token is relative to the start of its block.
+// An edit replaces the blocks containing the relexed tokens and
+// shifts the start of each following block, so its cost is
+// proportional to the size of a block and the number of blocks,
+// not the number of tokens.
+//
+// Tokens refer to the buffer of the most recent edit and are
+// materialized as needed.
+struct Edit_list
+{
+  Edit_list(Buffer&);
+
+  std::size_t size() const { return count_; }
+
+  Token_list tokens() const;
+
+  Token_range relex(Buffer&, Text_edit const&);
+
+  // A lexed token, without its buffer.
+  struct Entry
+  {
+    std::size_t   offset;
+    int           kind;
+    Symbol const* sym;
+  };
+
+  // A block of tokens. Blocks are never empty.
+  struct Block
+  {
+    std::size_t        start;
+    std::vector<Entry> toks;
+  };
+
+  void splice(std::size_t, std::size_t, std::vector<Entry> const&);
+
+  Buffer*            buf_;    // The current text
+  std::size_t        count_;  // The number of tokens
+  std::vector<Block> blocks_; // The blocks of tokens
 };
 
 
 Token_list lex(Buffer&);
+Token_list lex(Context&, Buffer&);
+Token_list lex(Buffer&, Thread_pool&, std::size_t = 1 << 20);
 
 
 } // namespace beaker
@@ -3,12 +3,9 @@
 
 #include "beaker/lookup.hpp"
 #include "beaker/decl.hpp"
-
-#include "lingo/symbol.hpp"
-
-#include <forward_list>
-#include <unordered_map>
-#include <iostream>
+#include "beaker/token.hpp"
+#include "beaker/context.hpp"
+#include "beaker/diagnostic.hpp"
 
 
 namespace beaker
@@ -18,18 +15,78 @@ namespace
 {
 
 // -------------------------------------------------------------------------- //
-//                          Lexical environment
+//                              Name ids
+
+// Returns the hash of the address of a name.
+inline std::size_t
+hash_name(String const* n)
+{
+  std::uintptr_t h = reinterpret_cast<std::uintptr_t>(n);
+  h ^= h >> 17;
+  h *= 0x9e3779b97f4a7c15ull;
+  return h ^ (h >> 29);
+}
+
+
+} // namespace
+
+
+// Returns the id of the name `n`, assigning a new id if `n`
+// has not been seen before.
+std::uint32_t
+Name_table::get(String const* n)
+{
+  std::size_t mask = slots_.size() - 1;
+  std::size_t i = hash_name(n) & mask;
+  while (slots_[i].name) {
+    if (slots_[i].name == n)
+      return slots_[i].id;
+    i = (i + 1) & mask;
+  }
+  std::uint32_t id = size_;
+  slots_[i] = Entry{n, id};
+  if (++size_ * 2 > slots_.size())
+    grow();
+  return id;
+}
 
-// The (name) environment provides a global mapping of 
-// names to declarations.
-struct Environment : std::unordered_map<String const*, Scope::Binding*>
+
+// Returns the id of the name `n`, or none if `n` has not
+// been seen before.
+std::uint32_t
+Name_table::find(String const* n) const
 {
-  Decl const* push(String const*, Scope*, Decl const*);
-  void        pop(String const*);
+  std::size_t mask = slots_.size() - 1;
+  std::size_t i = hash_name(n) & mask;
+  while (slots_[i].name) {
+    if (slots_[i].name == n)
+      return slots_[i].id;
+    i = (i + 1) & mask;
+  }
+  return none;
+}
+
+
+// Double the capacity of the table.
+void
+Name_table::grow()
+{
+  std::vector<Entry> old(slots_.size() * 2, Entry{nullptr, none});
+  old.swap(slots_);
+  std::size_t mask = slots_.size() - 1;
+  for (Entry const& x : old) {
+    if (x.name) {
+      std::size_t i = hash_name(x.name) & mask;
+      while (slots_[i].name)
+        i = (i + 1) & mask;
+      slots_[i] = x;
+    }
+  }
+}
 
-  Scope::Binding* binding(String const*) const;
-};
 
+// -------------------------------------------------------------------------- //
+//                          Lexical environment
 
 // Push a new name binding into the context. Because we don't
 // support overloading, it must be the case that insertion
@@ -37,85 +94,96 @@ struct Environment : std::unordered_map<String const*, Scope::Binding*>
 Decl const*
 Environment::push(String const* n, Scope* s, Decl const* d)
 {
-  auto ins = insert({n, nullptr});
-
-  // Get an alias to the binding. Note that we update
-  // this below.
-  Scope::Binding*& b = ins.first->second;
+  std::uint32_t id = names.get(n);
+  if (id >= top.size())
+    top.resize(2 * id + 1, 0);
+  std::uint32_t prev = top[id];
 
   // Ensure that we aren't creating multiple declarations
   // in the same scope.
-  lingo_assert(!ins.second ? b->scope != s : true);
+  lingo_assert(prev ? bindings[prev - 1].scope != s : true);
 
   // Chain the new binding to the previous and update.
-  b = new Scope::Binding{d, s, b};
+  bindings.push_back(Scope::Binding{d, s, id, prev});
+  top[id] = bindings.size();
   
   return d;
 }
 
 
-// Pop the innermost binding for this name. If this we pop
-// all bindings, then remove the entry altogether. Note
-// that `n` shall have a binding.
+// Pop all bindings above the height `n` of the binding stack,
+// restoring the bindings that they hide.
 void
-Environment::pop(String const* n)
+Environment::pop(std::size_t n)
 {
-  // Guarantee that we have a binding for `n`.
-  auto iter = find(n);
-  lingo_assert(iter != end());
-  
-  // If we've found the last binding erase the entry so
-  // we don't have "partially" bound identifiers.
-  Scope::Binding* e = iter->second;
-  if (e->prev)
-    iter->second = e->prev;
-  else
-    erase(iter);
-  
-  delete e;
+  lingo_assert(n <= bindings.size());
+  while (bindings.size() > n) {
+    Scope::Binding const& b = bindings.back();
+    top[b.name] = b.prev;
+    bindings.pop_back();
+  }
 }
 
 
 // Returns the binding for the name `n`. If `n` has no current
 // binding, returns nullptr.
 Scope::Binding*
-Environment::binding(String const* n) const
+Environment::binding(String const* n)
 {
-  auto iter = find(n);
-  if (iter != end())
-    return iter->second;
-  else
+  std::uint32_t id = names.find(n);
+  if (id == Name_table::none || id >= top.size() || !top[id])
     return nullptr;
+  return &bindings[top[id] - 1];
 }
 
-// The global naming environment.
-Environment env_;
-
 
-// -------------------------------------------------------------------------- //
-//                              Scope stack
+// Add the declaration `d` at position `n` of its unit to
+// the index.
+void
+Decl_index::insert(Decl const* d, std::size_t n)
+{
+  decls.emplace(d->name(), Entry{d, n});
+}
 
 
-// The scope stack is a stack of scopes.
-struct Stack : std::forward_list<Scope*>
+// Returns the declaration of `n` if it is among the first
+// `limit` declarations of the index. Otherwise, returns
+// nullptr.
+Decl const*
+Decl_index::find(String const* n, std::size_t limit) const
 {
-  Scope*       top()       { return front(); }
-  Scope const* top() const { return front(); }
-};
+  auto iter = decls.find(n);
+  if (iter != decls.end() && iter->second.pos < limit)
+    return iter->second.decl;
+  return nullptr;
+}
 
 
-// The global scope stack.
-Stack       stack_;
+// Make the first `n` declarations of `idx` visible.
+Use_decl_index::Use_decl_index(Decl_index const& idx, std::size_t n)
+{
+  Environment& env = current_context().env;
+  prev_index = env.index;
+  prev_limit = env.limit;
+  env.index = &idx;
+  env.limit = n;
+}
 
 
-} // namespace
+// Restore the previous index.
+Use_decl_index::~Use_decl_index()
+{
+  Environment& env = current_context().env;
+  env.index = prev_index;
+  env.limit = prev_limit;
+}
 
 
 // When constructing a scope, place it on the scope stack.
 Scope::Scope(Scope_kind k)
-  : kind_(k)
+  : kind_(k), mark_(current_context().env.bindings.size())
 {
-  stack_.push_front(this);
+  current_context().env.scopes.push_back(this);
 }
 
 
@@ -123,9 +191,9 @@ Scope::Scope(Scope_kind k)
 // a scope is destroyed.
 Scope::~Scope()
 {
-  for (String const* s : *this)
-    env_.pop(s);
-  stack_.pop_front();
+  Environment& env = current_context().env;
+  env.pop(mark_);
+  env.scopes.pop_back();
 }
 
 
@@ -133,12 +201,12 @@ Scope::~Scope()
 //
 // Note that `n` shall not have been previously declared
 // in this scope. This should be enforced by the `declare()`
-// function.
+// function. Only the current scope can be extended.
 Decl const*
 Scope::bind(String const* n, Decl const* d)
 {
-  push_back(n);
-  return env_.push(n, this, d);
+  lingo_assert(this == current_scope());
+  return current_context().env.push(n, this, d);
 }
 
 
@@ -147,7 +215,7 @@ Scope::bind(String const* n, Decl const* d)
 Decl const*
 Scope::lookup(String const* s) const
 {
-  if (Scope::Binding* b = env_.binding(s))
+  if (Scope::Binding* b = current_context().env.binding(s))
     return b->decl;
   else
     return nullptr;
@@ -162,7 +230,7 @@ Scope::lookup(String const* s) const
 Scope*
 current_scope()
 {
-  return stack_.top();
+  return current_context().env.scopes.back();
 }
 
 
@@ -179,10 +247,10 @@ bool
 check_redeclaration(String const* n, Decl const* decl)
 {
   Scope* s = current_scope();
-  if (Scope::Binding* b = env_.binding(n))
+  if (Scope::Binding* b = current_context().env.binding(n))
     if (b->scope == s) {
       Decl const* prev = b->decl;
-      error(decl->location(), "'{}' is already declared", n);
+      diagnose(decl->location(), "'{}' is already declared", n);
 
       // This isn't meaningful if there's no source location.
       // TODO: If the previous declaration is in a different
@@ -230,11 +298,17 @@ declare(Decl const* d)
 //                             Name lookup
 
 // Returns the declaration bound `name` or nullptr if
-// no such declaration exists.
+// no such declaration exists. Names that are not bound in
+// any scope are found in the declaration index, if any.
 Decl const*
 lookup(String const* name)
 {
-  return current_scope()->lookup(name);
+  if (Decl const* d = current_scope()->lookup(name))
+    return d;
+  Environment& env = current_context().env;
+  if (env.index)
+    return env.index->find(name, env.limit);
+  return nullptr;
 }
 
 
@@ -243,7 +317,7 @@ lookup(String const* name)
 Decl const*
 lookup(char const* name)
 {
-  return lookup(get_string(name));
+  return lookup(get_identifier(name));
 }
 
 
@@ -9,6 +9,10 @@
 
 #include "beaker/prelude.hpp"
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 
 namespace beaker
 {
@@ -41,19 +45,28 @@ enum Scope_kind
 // A (lexical) scope is a set of declartions that are visible
 // within the same region of source, starting from their
 // respective point of declarations.
-struct Scope : std::vector<String const*>
+//
+// Scopes are strictly nested, so the bindings of all scopes
+// are kept on a single stack. A scope records the height of
+// that stack when it is entered, and its bindings are those
+// above that mark.
+struct Scope
 {
   struct Binding;
 
   Scope(Scope_kind k);
   ~Scope();
 
+  Scope(Scope const&) = delete;
+  Scope& operator=(Scope const&) = delete;
+
   Scope_kind kind() const { return kind_; }
   
   Decl const* bind(String const*, Decl const*);
   Decl const* lookup(String const*) const;
 
-  Scope_kind kind_;
+  Scope_kind  kind_;
+  std::size_t mark_; // The height of the binding stack on entry
 };
 
 
@@ -89,11 +102,114 @@ struct Function_scope : Scope
 // with an identifier. This includes the bound declration,
 // it's scope, and a reference to the previous bound entry 
 // for the identifier.
+//
+// Bindings refer to names and to previous bindings by index
+// so that the binding stack can grow without invalidating
+// them.
 struct Scope::Binding
 {
-  Decl const* decl;  // The bound declaration
-  Scope*      scope; // The scope of the declaration
-  Binding*    prev;  // A previous binding for the name
+  Decl const*   decl;  // The bound declaration
+  Scope*        scope; // The scope of the declaration
+  std::uint32_t name;  // The id of the bound name
+  std::uint32_t prev;  // 1 + the index of the previous binding, or 0
+};
+
+
+// ---------------------------------------------------------------------------//
+//                            Environments
+
+// The name table assigns a dense id to each name (an interned
+// string) the first time it is seen by the environment. Names
+// are found by address in an open-addressed table.
+struct Name_table
+{
+  static constexpr std::uint32_t none = -1;
+
+  struct Entry
+  {
+    String const* name;
+    std::uint32_t id;
+  };
+
+  Name_table()
+    : slots_(1024, Entry{nullptr, none}), size_(0)
+  { }
+
+  std::uint32_t get(String const*);
+  std::uint32_t find(String const*) const;
+
+  void grow();
+
+  std::vector<Entry> slots_;
+  std::size_t        size_;
+};
+
+
+// A declaration index maps the names of the declarations of
+// a unit to those declarations and their positions within the
+// unit. Deferred bodies are parsed with the declarations of
+// their unit visible through its index (see parse.cpp), so
+// that those declarations need not be declared again.
+struct Decl_index
+{
+  struct Entry
+  {
+    Decl const* decl;
+    std::size_t pos;
+  };
+
+  void        insert(Decl const*, std::size_t);
+  Decl const* find(String const*, std::size_t) const;
+
+  std::unordered_map<String const*, Entry> decls;
+};
+
+
+// The (name) environment provides a mapping of names to
+// declarations. Each compilation has its own environment
+// (see context.hpp).
+//
+// The bindings of all scopes are kept on a single stack, which
+// retains its storage as scopes are entered and left. The
+// innermost binding of each name is found through a flat array
+// indexed by the id of the name.
+//
+// Names that are not bound in any scope are found in the
+// declaration index, if any. Only the first `limit` declarations
+// of the index are visible.
+struct Environment
+{
+  Environment()
+    : index(nullptr), limit(0)
+  { }
+
+  Decl const* push(String const*, Scope*, Decl const*);
+  void        pop(std::size_t);
+
+  Scope::Binding* binding(String const*);
+
+  Name_table                  names;
+  std::vector<std::uint32_t>  top;      // Innermost bindings by name id
+  std::vector<Scope::Binding> bindings; // The binding stack
+  std::vector<Scope*>         scopes;   // The scope stack
+  Decl_index const*           index;    // Declarations outside all scopes
+  std::size_t                 limit;    // The number of visible declarations
+};
+
+
+// Within the lifetime of this object, the first `n`
+// declarations of an index are visible in the current
+// environment.
+struct Use_decl_index
+{
+  Use_decl_index(Decl_index const&, std::size_t);
+  ~Use_decl_index();
+
+  Use_decl_index(Use_decl_index const&) = delete;
+  Use_decl_index& operator=(Use_decl_index const&) = delete;
+
+  Decl_index const* prev_index;
+  std::size_t       prev_limit;
 };
 
 
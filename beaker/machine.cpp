@@ -0,0 +1,419 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/machine.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+
+#include <algorithm>
+
+
+namespace beaker
+{
+
+Machine::Machine(Program const& p)
+  : prog(p), globals(p.globals), counting(false), steps(0),
+    threshold(0), native(new std::atomic<Native>[p.procs.size()])
+{
+  for (std::size_t n = 0; n < prog.procs.size(); ++n)
+    native[n] = nullptr;
+  run(prog.procs[prog.init], 0);
+  stack.clear();
+}
+
+
+// Enable profiling. The handler `h` is called when the heat of
+// a procedure reaches the threshold `n`.
+void
+Machine::profile(std::uint32_t n, Hot_handler h)
+{
+  threshold = n;
+  heats.assign(prog.procs.size(), 0);
+  hot = h;
+}
+
+
+// Install native code for the procedure `p`. Subsequent calls
+// to `p` will run that code, when profiling is enabled.
+void
+Machine::install(Procedure const& p, Native f)
+{
+  native[&p - prog.procs.data()].store(f, std::memory_order_release);
+}
+
+
+// Increase the heat of the procedure `n`.
+void
+Machine::heat(int n)
+{
+  if (++heats[n] == threshold && prog.procs[n].decl)
+    hot(prog.procs[n]);
+}
+
+
+// Call the procedure `p` with the given arguments.
+Value
+Machine::call(Procedure const& p, Value_seq const& args)
+{
+  if (args.size() != std::size_t(p.params)) {
+    error("procedure expects {} arguments but got {}", p.params, args.size());
+    return 0;
+  }
+  if (threshold) {
+    int n = &p - prog.procs.data();
+    if (Native f = native[n].load(std::memory_order_acquire))
+      return f(args.data());
+    heat(n);
+  }
+  std::size_t base = stack.size();
+  stack.insert(stack.end(), args.begin(), args.end());
+  Value v = run(p, base);
+  stack.resize(base);
+  return v;
+}
+
+
+namespace
+{
+
+// -------------------------------------------------------------------------- //
+//                              Dispatch
+//
+// When BEAKER_THREADED_DISPATCH is defined, each instruction
+// jumps directly to the code for the next through a table of
+// labels (a GCC and Clang extension). Otherwise, instructions
+// are dispatched by a switch in a loop. Threaded dispatch gives
+// each instruction its own indirect branch, which is predicted
+// far better than the single branch of the switch.
+//
+// Each instruction begins with on(op) and ends with next. A
+// branch to the instruction n is go(n). When profiling, backward
+// branches heat the current procedure.
+
+#ifdef BEAKER_THREADED_DISPATCH
+#  define dispatch  next;
+#  define on(op)    op##_label:
+#  define next      do { if (Count) ++m.steps; i = pc++; goto *labels[i->op]; } while (0)
+#  define finish
+#else
+#  define dispatch  while (true) { if (Count) ++m.steps; i = pc++; switch (i->op) {
+#  define on(op)    case op:
+#  define next      break
+#  define finish    } }
+#endif
+
+#define go(n) \
+  do { \
+    Instr const* t = code + (n); \
+    if (Profile && t < pc) \
+      m.heat(proc - m.prog.procs.data()); \
+    pc = t; \
+  } while (0)
+
+
+// Run the procedure `p` with a frame at `base`, returning the
+// value it returns. The arguments have been stored in the first
+// registers of the frame. When `Count` is true, the number of
+// instructions executed is added to the steps of `m`. When
+// `Profile` is true, the heat of procedures is measured, and
+// calls run native code when available.
+//
+// Note that the stack may be reallocated by a call, which
+// invalidates the pointer to the registers of the frame.
+template<bool Count, bool Profile>
+Value
+run_machine(Machine& m, Procedure const& p, std::size_t base)
+{
+#ifdef BEAKER_THREADED_DISPATCH
+  static void* labels[] {
+    &&const_ins_label,
+    &&move_ins_label,
+    &&load_ins_label,
+    &&store_ins_label,
+    &&neg_ins_label,
+    &&pos_ins_label,
+    &&compl_ins_label,
+    &&not_ins_label,
+    &&add_ins_label,
+    &&sub_ins_label,
+    &&mul_ins_label,
+    &&div_ins_label,
+    &&mod_ins_label,
+    &&and_ins_label,
+    &&or_ins_label,
+    &&xor_ins_label,
+    &&lsh_ins_label,
+    &&rsh_ins_label,
+    &&eq_ins_label,
+    &&ne_ins_label,
+    &&lt_ins_label,
+    &&gt_ins_label,
+    &&le_ins_label,
+    &&ge_ins_label,
+    &&add_imm_ins_label,
+    &&jump_ins_label,
+    &&jump_if_ins_label,
+    &&jump_not_ins_label,
+    &&jump_eq_ins_label,
+    &&jump_ne_ins_label,
+    &&jump_lt_ins_label,
+    &&jump_gt_ins_label,
+    &&jump_le_ins_label,
+    &&jump_ge_ins_label,
+    &&jump_eq_imm_ins_label,
+    &&jump_ne_imm_ins_label,
+    &&jump_lt_imm_ins_label,
+    &&jump_gt_imm_ins_label,
+    &&jump_le_imm_ins_label,
+    &&jump_ge_imm_ins_label,
+    &&call_ins_label,
+    &&ret_ins_label,
+  };
+  static_assert(sizeof(labels) / sizeof(void*) == ret_ins + 1, "missing labels");
+#endif
+
+  std::size_t bottom = m.calls.size();
+  Procedure const* proc = &p;
+  std::size_t frame = base;
+  if (m.stack.size() < frame + proc->registers)
+    m.stack.resize(frame + proc->registers);
+
+  Value* r = m.stack.data() + frame;
+  Value* g = m.globals.data();
+  Instr const* code = proc->code.data();
+  Instr const* pc = code;
+  Instr const* i;
+  dispatch
+
+  on(const_ins)
+    r[i->a] = proc->constants[i->b];
+    next;
+  on(move_ins)
+    r[i->a] = r[i->b];
+    next;
+  on(load_ins)
+    r[i->a] = g[i->b];
+    next;
+  on(store_ins)
+    g[i->a] = r[i->b];
+    next;
+
+  on(neg_ins)
+    r[i->a] = -r[i->b];
+    next;
+  on(pos_ins)
+    r[i->a] = r[i->b];
+    next;
+  on(compl_ins)
+    r[i->a] = ~r[i->b];
+    next;
+  on(not_ins)
+    r[i->a] = !r[i->b];
+    next;
+
+  on(add_ins)
+    r[i->a] = r[i->b] + r[i->c];
+    next;
+  on(sub_ins)
+    r[i->a] = r[i->b] - r[i->c];
+    next;
+  on(mul_ins)
+    r[i->a] = r[i->b] * r[i->c];
+    next;
+  on(div_ins)
+    if (r[i->c] == 0) {
+      error("division by zero");
+      r[i->a] = 0;
+    } else {
+      r[i->a] = r[i->b] / r[i->c];
+    }
+    next;
+  on(mod_ins)
+    if (r[i->c] == 0) {
+      error("division by zero");
+      r[i->a] = 0;
+    } else {
+      r[i->a] = r[i->b] % r[i->c];
+    }
+    next;
+  on(and_ins)
+    r[i->a] = r[i->b] & r[i->c];
+    next;
+  on(or_ins)
+    r[i->a] = r[i->b] | r[i->c];
+    next;
+  on(xor_ins)
+    r[i->a] = r[i->b] ^ r[i->c];
+    next;
+  on(lsh_ins)
+    r[i->a] = r[i->b] << r[i->c];
+    next;
+  on(rsh_ins)
+    r[i->a] = r[i->b] >> r[i->c];
+    next;
+  on(eq_ins)
+    r[i->a] = r[i->b] == r[i->c];
+    next;
+  on(ne_ins)
+    r[i->a] = r[i->b] != r[i->c];
+    next;
+  on(lt_ins)
+    r[i->a] = r[i->b] < r[i->c];
+    next;
+  on(gt_ins)
+    r[i->a] = r[i->b] > r[i->c];
+    next;
+  on(le_ins)
+    r[i->a] = r[i->b] <= r[i->c];
+    next;
+  on(ge_ins)
+    r[i->a] = r[i->b] >= r[i->c];
+    next;
+  on(add_imm_ins)
+    r[i->a] = r[i->b] + i->c;
+    next;
+
+  on(jump_ins)
+    go(i->c);
+    next;
+  on(jump_if_ins)
+    if (r[i->a])
+      go(i->c);
+    next;
+  on(jump_not_ins)
+    if (!r[i->a])
+      go(i->c);
+    next;
+  on(jump_eq_ins)
+    if (r[i->a] == r[i->b])
+      go(i->c);
+    next;
+  on(jump_ne_ins)
+    if (r[i->a] != r[i->b])
+      go(i->c);
+    next;
+  on(jump_lt_ins)
+    if (r[i->a] < r[i->b])
+      go(i->c);
+    next;
+  on(jump_gt_ins)
+    if (r[i->a] > r[i->b])
+      go(i->c);
+    next;
+  on(jump_le_ins)
+    if (r[i->a] <= r[i->b])
+      go(i->c);
+    next;
+  on(jump_ge_ins)
+    if (r[i->a] >= r[i->b])
+      go(i->c);
+    next;
+  on(jump_eq_imm_ins)
+    if (r[i->a] == i->b)
+      go(i->c);
+    next;
+  on(jump_ne_imm_ins)
+    if (r[i->a] != i->b)
+      go(i->c);
+    next;
+  on(jump_lt_imm_ins)
+    if (r[i->a] < i->b)
+      go(i->c);
+    next;
+  on(jump_gt_imm_ins)
+    if (r[i->a] > i->b)
+      go(i->c);
+    next;
+  on(jump_le_imm_ins)
+    if (r[i->a] <= i->b)
+      go(i->c);
+    next;
+  on(jump_ge_imm_ins)
+    if (r[i->a] >= i->b)
+      go(i->c);
+    next;
+
+  on(call_ins) {
+    if (Profile) {
+      int n = i->b;
+      if (Native f = m.native[n].load(std::memory_order_acquire)) {
+        r[i->a] = f(r + i->c);
+        next;
+      }
+      m.heat(n);
+    }
+    m.calls.push_back(Machine::Activation{proc, pc, frame, i->a});
+    proc = &m.prog.procs[i->b];
+    frame += i->c;
+    std::size_t n = frame + proc->registers;
+    if (m.stack.size() < n)
+      m.stack.resize(std::max(n, 2 * m.stack.size()));
+    r = m.stack.data() + frame;
+    code = pc = proc->code.data();
+  }
+  next;
+
+  on(ret_ins) {
+    Value v = r[i->a];
+    if (m.calls.size() == bottom)
+      return v;
+    Machine::Activation const& a = m.calls.back();
+    proc = a.proc;
+    code = proc->code.data();
+    pc = a.pc;
+    frame = a.frame;
+    r = m.stack.data() + frame;
+    r[a.dst] = v;
+    m.calls.pop_back();
+  }
+  next;
+
+  finish
+  lingo_unreachable();
+}
+
+
+#undef dispatch
+#undef on
+#undef next
+#undef finish
+#undef go
+
+
+} // namespace
+
+
+// Run the procedure `p` with a frame at `base`, returning the
+// value it returns. The arguments have been stored in the first
+// registers of the frame.
+Value
+Machine::run(Procedure const& p, std::size_t base)
+{
+  if (counting)
+    return threshold ? run_machine<true, true>(*this, p, base)
+                     : run_machine<true, false>(*this, p, base);
+  else
+    return threshold ? run_machine<false, true>(*this, p, base)
+                     : run_machine<false, false>(*this, p, base);
+}
+
+
+// Run the program `u`, starting with the function named `name`
+// and the given arguments. Returns the value returned by that
+// function.
+Value
+execute(Unit const* u, char const* name, Value_seq const& args)
+{
+  Function_decl const* f = find_function(u, name);
+  if (!f) {
+    error("no function named '{}'", name);
+    return 0;
+  }
+  Program prog = to_bytecode(u);
+  Machine m(prog);
+  return m.call(*prog.find(f), args);
+}
+
+
+} // namespace beaker
@@ -0,0 +1,94 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_MACHINE_HPP
+#define BEAKER_MACHINE_HPP
+
+// This module provides a virtual machine that runs the bytecode
+// of a program (see bytecode.hpp).
+//
+// The registers of all active procedures are allocated on a
+// single stack of values. The frame of a callee begins at the
+// registers holding the caller's arguments, so arguments are
+// never copied. Calls do not recurse on the C++ stack.
+
+#include "beaker/prelude.hpp"
+#include "beaker/value.hpp"
+#include "beaker/bytecode.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+
+namespace beaker
+{
+
+// The native code of a procedure (see Jit in codegen/jit.hpp),
+// which takes the arguments of a call as an array.
+using Native = Value (*)(Value const*);
+
+
+// The machine holds the state of an executing program.
+// Constructing a machine initializes the program's global
+// variables.
+//
+// Runtime errors (e.g., division by 0) are diagnosed, and
+// execution continues with the value 0.
+//
+// When counting is enabled, the machine counts the number of
+// instructions it executes. Counting is selected once for each
+// run, so it costs nothing when disabled.
+//
+// When profiling is enabled, the machine measures the heat of
+// each procedure: the number of calls to it, and of backward
+// branches taken within it. When the heat of a procedure reaches
+// the threshold, the machine calls its hot handler, once. Calls
+// to a procedure that has native code run that code instead of
+// the procedure's bytecode. Native code may be installed at any
+// time, from any thread.
+struct Machine
+{
+  // The state of a caller, saved during a call.
+  struct Activation
+  {
+    Procedure const* proc;  // The calling procedure
+    Instr const*     pc;    // The next instruction
+    std::size_t      frame; // The base of the caller's frame
+    int              dst;   // The register of the result
+  };
+
+  using Hot_handler = std::function<void(Procedure const&)>;
+
+  explicit Machine(Program const&);
+
+  void profile(std::uint32_t, Hot_handler);
+  void install(Procedure const&, Native);
+  void heat(int);
+
+  Value call(Procedure const&, Value_seq const&);
+  Value run(Procedure const&, std::size_t);
+
+  Program const&          prog;
+  Value_seq               globals;  // Global variables
+  Value_seq               stack;    // Frames of active procedures
+  std::vector<Activation> calls;    // Saved callers
+  bool                    counting; // Count instructions
+  std::uint64_t           steps;    // Instructions executed
+
+  // Profiling
+  std::uint32_t              threshold; // The heat of hot procedures
+  std::vector<std::uint32_t> heats;     // The heat of each procedure
+  Hot_handler                hot;       // Called when a procedure is hot
+  std::unique_ptr<std::atomic<Native>[]> native; // Native code, if any
+};
+
+
+Value execute(Unit const*, char const*, Value_seq const& = {});
+
+
+} // namespace beaker
+
+
+#endif
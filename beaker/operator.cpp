@@ -5,6 +5,7 @@
 #include "beaker/type.hpp"
 #include "beaker/expr.hpp"
 #include "beaker/same.hpp"
+#include "beaker/diagnostic.hpp"
 
 
 namespace beaker
@@ -20,7 +21,7 @@ expect_type(Expr const* e, Type const* expect, Type const* result)
 {
   if (same(get_expr_type(e), expect))
     return result;
-  error(e->location(), "invalid operand of type '{}'", e->type());
+  diagnose(e->location(), "invalid operand of type '{}'", e->type());
   return make_error_node<Type>();
 }
 
@@ -33,9 +34,9 @@ expect_type(Expr const* e1, Expr const* e2, Type const* expect, Type const* resu
   if (b1 && b2)
     return result;
   if (!b1)
-    error(e1->location(), "invalid operand of type '{}'", e1->type());
+    diagnose(e1->location(), "invalid operand of type '{}'", e1->type());
   if (!b2)
-    error(e2->location(), "invalid operand of type '{}'", e2->type());
+    diagnose(e2->location(), "invalid operand of type '{}'", e2->type());
   return make_error_node<Type>();
 }
 
@@ -159,11 +159,35 @@ parse_function_def(Parser& p, Token_stream& ts)
   if (match_token(ts, eq_tok))
     return parse_stmt(p, ts);
   
-  error(ts.location(), "expected function-definition, but got '{}'", ts.peek());
+  diagnose(ts.location(), "expected function-definition, but got '{}'", ts.peek());
   return make_error_node<Stmt>();
 }
 
 
+// Skip a block, matching braces, and return the location of
+// its closing brace. Returns an invalid location if the block
+// is not closed.
+Location
+skip_block(Token_stream& ts)
+{
+  Location first = ts.location();
+  Location last;
+  int depth = 0;
+  do {
+    switch (next_token_kind(ts)) {
+    case lbrace_tok: ++depth; break;
+    case rbrace_tok: --depth; break;
+    case -1:
+      diagnose(first, "unmatched '{'");
+      return Location();
+    }
+    last = ts.location();
+    ts.skip();
+  } while (depth);
+  return last;
+}
+
+
 // Parse a function declaration.
 //
 //    function-decl ::= 'def' identifier parameter-clause '->' type stmt
@@ -211,12 +235,18 @@ parse_function_decl(Parser& p, Token_stream& ts)
   if (!fn)
     return make_error_node<Decl>();
 
-  // Parse the function definition.
-  Required<Stmt> body = parse_expected(p, ts, parse_function_def);
-  if (!body)
+  // When deferring bodies, skip a block body without
+  // parsing it.
+  if (p.bodies && next_token_is(ts, lbrace_tok)) {
+    Location first = ts.location();
+    if (Location last = skip_block(ts))
+      return p.on_function_defer(*fn, ts.buffer(), first, last);
     return make_error_node<Decl>();
+  }
 
-  return p.on_function_finish(*fn, *body);
+  // Parse the function definition.
+  Stmt const* body = parse_expected(p, ts, parse_function_def);
+  return p.on_function_finish(*fn, body);
 }
 
 
@@ -13,29 +13,10 @@ Expr const* parse_expr(Parser&, Token_stream&);
 namespace
 {
 
-Expr const* parse_primary_expr(Parser&, Token_stream&);
-Expr const* parse_postfix_expr(Parser&, Token_stream&);
-Expr const* parse_prefix_expr(Parser&, Token_stream&);
-Expr const* parse_binary_expr(Parser&, Token_stream&);
-
-
 // -------------------------------------------------------------------------- //
 //                            Primary expressions
 
 
-// Parse a nested sub-expression.
-//
-//    nested-expression ::= '(' expression ')'
-Expr const*
-parse_nested_expr(Parser& p, Token_stream& ts)
-{
-  // TODO: Improve diagnostics.
-  if (Required<Enclosed_term<Expr>> e = parse_paren_enclosed(p, ts, parse_expr))
-    return e->term();
-  return make_error_node<Expr>();
-}
-
-
 // Parse a primary expression.
 //
 //    primary-expression ::= literal 
@@ -43,6 +24,11 @@ parse_nested_expr(Parser& p, Token_stream& ts)
 //                         | nested-expression
 //
 //    literal ::= boolean-literal | integer-literal
+//
+//    nested-expression ::= '(' expression ')'
+//
+// Nested expressions are opened by parse_prefix() and closed
+// by parse_expr() (see below). This matches the remaining forms.
 Expr const*
 parse_primary_expr(Parser& p, Token_stream& ts)
 {
@@ -50,125 +36,47 @@ parse_primary_expr(Parser& p, Token_stream& ts)
     case boolean_tok:
       return p.on_boolean_lit(get_token(ts));
     
-    case integer_tok: 
-      return p.on_integer_lit(get_token(ts));
+    case integer_tok: {
+      Value n = ts.value();
+      return p.on_integer_lit(get_token(ts), n);
+    }
     
     case identifier_tok:
       return p.on_identifier_expr(get_token(ts));
     
-    case lparen_tok:
-      return parse_nested_expr(p, ts);
-
     default:
       break;
   }
 
-  // Don't report an error. Let a lower-precedence parse
-  // report the problem instead of the highest.
+  // Don't report an error. Let the enclosing parse report
+  // the problem.
   return nullptr;
 }
 
 
 // -------------------------------------------------------------------------- //
 //                            Postfix expressions
-
-
-// Parse a function argument.
 //
-//    function-argument ::= expression
+//    postfix-expression ::= call-expression
+//                         | primary-expression
 //
-// This is a placeholder that would allow us to accept
-// non-expression arguments in the future.
-inline Expr const*
-parse_argument(Parser& p, Token_stream& ts)
-{
-  return parse_expr(p, ts);
-}
-
-
-// Parse an argument list.
+//    call-expression ::= postfix-expression '(' argument-list ')'
 //
 //    function-argument-list ::= <empty> | argument [',' argument]*
-inline Sequence_term<Expr> const*
-parse_argument_list(Parser& p, Token_stream& ts)
-{
-  return parse_comma_list(p, ts, parse_argument);
-}
-
-
-// Parse a call expression.
-//
-//    call-expression ::= postfix-expression '(' argument-list ')'
-Expr const*
-parse_call_expr(Parser& p, Token_stream& ts, Expr const* expr) 
-{
-  using Args = Enclosed_term<Sequence_term<Expr>>;
-  if (Required<Args> args = parse_paren_enclosed(p, ts, parse_argument_list)) {
-    if (args->term())
-      return p.on_call_expr(args->open(), expr, *args->term());
-    else
-      return p.on_call_expr(args->open(), expr, {});
-  }
-  else
-    return make_error_node<Expr>();
-}
-
-
-// Parse a postfix expression. This is the entry point to all
-// binary or n-ary expressions parsed at this precedence.
 //
-//    postfix-expression ::= call-expression
-//                         | primary-expression
-Expr const*
-parse_postfix_expr(Parser& p, Token_stream& ts) {
-  if (Expr const* e1 = parse_primary_expr(p, ts)) {
-    while (e1) {
-      Expr const* e2;
-      switch (next_token_kind(ts)) {
-      case lparen_tok: 
-        e2 = parse_call_expr(p, ts, e1);
-        break;
-
-      default:
-        e2 = nullptr;
-        break;
-      }
-
-      if (not e2)
-        break;
-
-      e1 = e2;
-    }
-    return e1;
-  }
-  return {};
-}
+//    function-argument ::= expression
 
 
 // -------------------------------------------------------------------------- //
 //                           Unary expressions
-
-
-// A helper function object for dispatching to the
-// semantic action for unary expressions.
-struct on_unary_expr
-{
-  on_unary_expr(Parser& p)
-    : p(p)
-  { }
-
-  Expr const* operator()(Token const* tok, Expr const* e)
-  {
-    return p.on_unary_expr(tok, e);
-  }
-
-  Parser& p;
-};
+//
+//    unary-expression ::= postfix-expression
+//                       | unary-operator unary-expression
 
 
 // Parse a unary operator.
 //
-//    unary-operator ::= '+' | '-' | '!'
+//    unary-operator ::= '+' | '-' | '!' | '~'
 Token const*
 parse_unary_op(Parser& p, Token_stream& ts)
 {
@@ -185,140 +93,38 @@ parse_unary_op(Parser& p, Token_stream& ts)
 }
 
 
-// Parse a unary expression.
-//
-//    unary-expression ::= postfix-expression
-//                       | unary-operator unary-expression
-inline Expr const*
-parse_unary_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_unary_op;
-  auto sub = parse_postfix_expr;
-  return parse_prefix_term(p, ts, op, sub, on_unary_expr(p));
-}
-
-
-
 // -------------------------------------------------------------------------- //
 //                        Binary expressions
 
 
-// A helper function object for dispatching to the
-// semantic action for binary expressions.
-struct on_binary_expr
-{
-  on_binary_expr(Parser& p)
-    : p(p)
-  { }
-
-  Expr const* operator()(Token const* tok, Expr const* e1, Expr const* e2)
-  {
-    return p.on_binary_expr(tok, e1, e2);
-  }
-
-  Parser& p;
-};
-
-
-// Parse a multiplicative expression.
+// Binary expressions are parsed by precedence climbing. The
+// grammar is equivalent to the following layered rules, where
+// each operator is left associative.
 //
-//    multiplicative-expression ::= 
-//        unary-expression
-//      | multiplicative-expression '*' unary-expression
-//      | multiplicative-expression '/' unary-expression
-//      | multiplicative-expression '%' unary-expression
-
-// Match one of the multiplicative operators.
-inline Token const*
-parse_multiplicative_op(Parser& p, Token_stream& ts)
-{
-  switch (next_token_kind(ts)) {
-    case star_tok:
-    case slash_tok:
-    case percent_tok:
-      return get_token(ts);
-    default:
-      break;
-  }
-  return nullptr;
-}
-
-
-// Parse a multiplicative expression.
-Expr const*
-parse_multiplicative_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_multiplicative_op;
-  auto sub = parse_unary_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
-
-// Parse an additive expression.
+//    logical-or-expression ::= 
+//        logical-and-expression
+//      | logical-or-expression '||' logical-and-expression
 //
-//    additive-expression ::= 
-//        multiplicative-expression
-//      | additive-expression '+' multiplicative-expression
-//      | additive-expression '-' multiplicative-expression
-
-// Match one of the additive operators.
-inline Token const*
-parse_additive_op(Parser& p, Token_stream& ts)
-{
-  switch (next_token_kind(ts)) {
-    case plus_tok:
-    case minus_tok:
-      return get_token(ts);
-    default:
-      break;
-  }
-  return nullptr;
-}
-
-
-// Parse an additive expression.
-Expr const*
-parse_additive_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_additive_op;
-  auto sub = parse_multiplicative_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
-
-// Parse a shift expression.
+//    logical-and-expression ::= 
+//        bit-or-expression
+//      | logical-and-expression '&&' bit-or-expression
 //
-//    shift-expression ::= 
-//        additive-expression
-//      | shift-expression '<<' additive-expression
-//      | shift-expression '>>' additive-expression
-
-// Match one of the shift operators.
-inline Token const*
-parse_shift_op(Parser& p, Token_stream& ts)
-{
-  switch (next_token_kind(ts)) {
-    case lt_lt_tok:
-    case gt_gt_tok:
-      return get_token(ts);
-    default:
-      break;
-  }
-  return nullptr;
-}
-
-
-// Parse a shift expression.
-Expr const*
-parse_shift_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_shift_op;
-  auto sub = parse_additive_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
-
-// Parse a relational expression.
+//    bit-or-expression ::= 
+//        bit-xor-expression
+//      | bit-or-expression '|' bit-xor-expression
+//
+//    bit-xor-expression ::= 
+//        bit-and-expression
+//      | bit-xor-expression '^' bit-and-expression
+//
+//    bit-and-expression ::= 
+//        equality-expression
+//      | bit-and-expression '&' equality-expression
+//
+//    equality-expression ::= 
+//        relational-expression
+//      | equality-expression '==' relational-expression
+//      | equality-expression '!=' relational-expression
 //
 //    relational-expression ::= 
 //        shift-expression
@@ -326,202 +132,295 @@ parse_shift_expr(Parser& p, Token_stream& ts)
 //      | relational-expression '>' shift-expression
 //      | relational-expression '<=' shift-expression
 //      | relational-expression '>=' shift-expression
-
-// Match one of the relational operators.
-inline Token const*
-parse_relational_op(Parser& p, Token_stream& ts)
-{
-  switch (next_token_kind(ts)) {
-    case lt_tok:
-    case gt_tok:
-    case lt_eq_tok:
-    case gt_eq_tok:
-      return get_token(ts);
-    default:
-      break;
-  }
-  return nullptr;
-}
-
-
-// Parse a relational expression.
-Expr const*
-parse_relational_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_relational_op;
-  auto sub = parse_shift_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
-
-// Parse an equality expression.
 //
-//    equality-expression ::= 
-//        relational-expression
-//      | equality-expression '==' relational-expression
-//      | equality-expression '!=' relational-expression
-
-// Match one of the equality operators.
-inline Token const*
-parse_equality_op(Parser& p, Token_stream& ts)
-{
-  switch (next_token_kind(ts)) {
-    case eq_eq_tok:
-    case bang_eq_tok:
-      return get_token(ts);
-    default:
-      break;
-  }
-  return nullptr;
-}
+//    shift-expression ::= 
+//        additive-expression
+//      | shift-expression '<<' additive-expression
+//      | shift-expression '>>' additive-expression
+//
+//    additive-expression ::= 
+//        multiplicative-expression
+//      | additive-expression '+' multiplicative-expression
+//      | additive-expression '-' multiplicative-expression
+//
+//    multiplicative-expression ::= 
+//        unary-expression
+//      | multiplicative-expression '*' unary-expression
+//      | multiplicative-expression '/' unary-expression
+//      | multiplicative-expression '%' unary-expression
+//
+// Rather than descending through every level of the grammar
+// to reach a unary expression, the parser compares the
+// precedence of adjacent operators (see parse_expr below).
 
 
-// Parse a equality expression.
-Expr const*
-parse_equality_expr(Parser& p, Token_stream& ts)
+// The precedence of binary operators, indexed by token kind.
+// A higher precedence binds more tightly. Tokens that are not
+// binary operators have precedence 0.
+struct Precedence_table
 {
-  auto op = parse_equality_op;
-  auto sub = parse_relational_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
+  enum : unsigned char
+  {
+    logical_or = 1,
+    logical_and,
+    bit_or,
+    bit_xor,
+    bit_and,
+    equality,
+    relational,
+    shift,
+    additive,
+    multiplicative,
+  };
+
+  Precedence_table();
+
+  int operator[](int k) const { return k < 0 ? 0 : prec[k]; }
+
+  unsigned char prec[256];
+};
 
-// Parse a bitwise and expression.
-//
-//    bit-and-expression ::= 
-//        equality-expression
-//      | bit-and-expression '&' equality-expression
 
-// Match the bitwise and operator.
-inline Token const*
-parse_bit_and_op(Parser& p, Token_stream& ts)
-{
-  return match_token(ts, amp_tok);
+Precedence_table::Precedence_table()
+  : prec()
+{
+  prec[bar_bar_tok] = logical_or;
+  prec[amp_amp_tok] = logical_and;
+  prec[bar_tok] = bit_or;
+  prec[caret_tok] = bit_xor;
+  prec[amp_tok] = bit_and;
+  prec[eq_eq_tok] = equality;
+  prec[bang_eq_tok] = equality;
+  prec[lt_tok] = relational;
+  prec[gt_tok] = relational;
+  prec[lt_eq_tok] = relational;
+  prec[gt_eq_tok] = relational;
+  prec[lt_lt_tok] = shift;
+  prec[gt_gt_tok] = shift;
+  prec[plus_tok] = additive;
+  prec[minus_tok] = additive;
+  prec[star_tok] = multiplicative;
+  prec[slash_tok] = multiplicative;
+  prec[percent_tok] = multiplicative;
 }
 
 
-// Parse a bitwise and expression.
-Expr const*
-parse_bit_and_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_bit_and_op;
-  auto sub = parse_equality_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
+Precedence_table const binary_precedence;
 
 
-// Parse a bitwise exclusive or expression.
-//
-//    bit-xor-expression ::= 
-//        bitwise-and-expression
-//      | bit-xor-expression '^' bitwise-and-expression
+// -------------------------------------------------------------------------- //
+//                          Expression frames
 
-// Match the bitwise xor operator.
-inline Token const*
-parse_bit_xor_op(Parser& p, Token_stream& ts)
+// Expressions are parsed without recursion, so that the depth
+// of nesting is limited only by available memory. Each operator
+// or enclosure that is waiting for an operand is pushed onto
+// an explicit stack of frames:
+//
+//    - a unary frame holds a prefix operator,
+//    - a binary frame holds an operator and its left operand,
+//    - a paren frame holds the '(' of a nested expression, and
+//    - a call frame holds the '(' of an argument list, the
+//      function being called, and the arguments parsed so far.
+//
+// An operand completes the frames above it in order of
+// precedence. A binary frame is completed only when the next
+// operator does not bind more tightly, so operators of the same
+// precedence associate to the left.
+struct Expr_frame
 {
-  return match_token(ts, caret_tok);
-}
+  enum Kind { unary, binary, paren, call };
 
+  Expr_frame(Kind k, Token const* t, Expr const* e = nullptr, int n = 0)
+    : kind(k), tok(t), expr(e), prec(n)
+  { }
 
-// Parse a bitwise xor expression.
-Expr const*
-parse_bit_xor_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_bit_xor_op;
-  auto sub = parse_bit_and_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
+  Kind         kind;
+  Token const* tok;  // The operator or open paren
+  Expr const*  expr; // The left operand or function
+  int          prec; // The precedence of a binary operator
+  Expr_seq     args; // The arguments of a call
+};
 
 
-// Parse a bitwise inclusive or expression.
-//
-//    bit-or-expression ::= 
-//        bitwise-xor-expression
-//      | bit-or-expression '|' bitwise-xor-expression
+using Expr_stack = std::vector<Expr_frame>;
 
-// Match the bitwise or operator.
-inline Token const*
-parse_bit_or_op(Parser& p, Token_stream& ts)
+
+// Push frames for the prefix operators and open parens that
+// precede an operand.
+void
+parse_prefix(Parser& p, Token_stream& ts, Expr_stack& stack)
 {
-  return match_token(ts, bar_tok);
+  while (true) {
+    if (Token const* tok = parse_unary_op(p, ts))
+      stack.emplace_back(Expr_frame::unary, tok);
+    else if (Token const* tok = match_token(ts, lparen_tok))
+      stack.emplace_back(Expr_frame::paren, tok);
+    else
+      break;
+  }
 }
 
 
-// Parse a bitwise or expression.
+// Abandon the parse of an expression after an error. Tokens
+// are skipped through the closing paren of each enclosing
+// nested expression or argument list, so that parsing can
+// resume after the erroneous term.
 Expr const*
-parse_bit_or_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_bit_or_op;
-  auto sub = parse_bit_xor_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
+unwind_expr(Token_stream& ts, Expr_stack& stack)
+{
+  while (!stack.empty()) {
+    Expr_frame::Kind k = stack.back().kind;
+    if (k == Expr_frame::paren || k == Expr_frame::call) {
+      while (next_token_is_not(ts, rparen_tok))
+        get_token(ts);
+      match_token(ts, rparen_tok);
+    }
+    stack.pop_back();
+  }
+  return make_error_node<Expr>();
 }
 
 
-// Parse a logical and expression.
-//
-//    logical-and-expression ::= 
-//        bitwise-or-expression
-//      | logical-and-expression '&&' bitwise-or-expression
+// Handle a missing operand. Empty parens are closed without
+// producing an operand, and an empty argument list completes
+// its call, which is returned. Otherwise, the innermost frame
+// requires an operand, and an error is diagnosed. Returns
+// nullptr only when no frame required an operand.
+Expr const*
+parse_missing_operand(Parser& p, Token_stream& ts, Expr_stack& stack)
+{
+  while (!stack.empty()) {
+    Expr_frame& f = stack.back();
+    switch (f.kind) {
+    case Expr_frame::unary:
+      diagnose(ts.location(), "expected operand");
+      return make_error_node<Expr>();
+
+    case Expr_frame::binary:
+      diagnose(ts.location(), "expected term but got '{}'", ts.peek());
+      return make_error_node<Expr>();
+
+    case Expr_frame::paren:
+      if (!expect_token(p, ts, rparen_tok)) {
+        stack.pop_back();
+        return make_error_node<Expr>();
+      }
+      stack.pop_back();
+      break;
 
-// Match the logical and operator.
-inline Token const*
-parse_lgoical_and_op(Parser& p, Token_stream& ts)
-{
-  return match_token(ts, bar_tok);
+    case Expr_frame::call:
+      if (!f.args.empty()) {
+        diagnose(ts.location(), "expected term");
+        return make_error_node<Expr>();
+      }
+      if (expect_token(p, ts, rparen_tok)) {
+        Token const* open = f.tok;
+        Expr const* fn = f.expr;
+        stack.pop_back();
+        return p.on_call_expr(open, fn, {});
+      }
+      stack.pop_back();
+      return make_error_node<Expr>();
+    }
+  }
+  return nullptr;
 }
 
 
-// Parse a logical and expression.
-Expr const*
-parse_logical_and_expr(Parser& p, Token_stream& ts)
-{
-  auto op = parse_lgoical_and_op;
-  auto sub = parse_bit_or_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
+} // namespace
 
 
-// Parse a logical or expression.
+// Parse an expression.
 //
-//    logical-or-expression ::= 
-//        logical-and-expression
-//      | logical-or-expression '||' logical-and-expression
-
-
-// Match the logical or operator.
-inline Token const*
-parse_lgoical_or_op(Parser& p, Token_stream& ts)
-{
-  return match_token(ts, bar_tok);
-}
-
-
-// Parse a logical or expression.
+//    expression ::= binary-expression
+//
+// Each iteration of the loop parses an operand, if one is
+// required, and then applies its postfix operators. The operand
+// completes the frames that are waiting for it, until an operator
+// or argument list requires a new operand. If no operand is
+// found where the first is required, no error is diagnosed
+// and nullptr is returned.
 Expr const*
-parse_logical_or_expr(Parser& p, Token_stream& ts)
+parse_expr(Parser& p, Token_stream& ts)
 {
-  auto op = parse_lgoical_or_op;
-  auto sub = parse_logical_and_expr;
-  return parse_left_infix_term(p, ts, op, sub, on_binary_expr(p));
-}
-
+  Expr_stack stack;
+  Expr const* e = nullptr;
+  while (true) {
+    // Match an operand.
+    if (!e) {
+      parse_prefix(p, ts, stack);
+      e = parse_primary_expr(p, ts);
+      if (!e)
+        e = parse_missing_operand(p, ts, stack);
+      if (!e)
+        return nullptr;
+      if (is_error_node(e))
+        return unwind_expr(ts, stack);
+    }
 
-inline Expr const*
-parse_binary_expr(Parser& p, Token_stream& ts)
-{
-  return parse_logical_or_expr(p, ts);
-}
+    // Match the argument list of a call.
+    if (Token const* tok = match_token(ts, lparen_tok)) {
+      stack.emplace_back(Expr_frame::call, tok, e);
+      e = nullptr;
+      continue;
+    }
 
+    // Apply prefix operators.
+    while (!stack.empty() && stack.back().kind == Expr_frame::unary) {
+      e = p.on_unary_expr(stack.back().tok, e);
+      stack.pop_back();
+      if (!is_valid_node(e))
+        return unwind_expr(ts, stack);
+    }
 
-} // namespace
+    // Complete binary expressions whose operators bind at least
+    // as tightly as the next.
+    int prec = binary_precedence[next_token_kind(ts)];
+    while (!stack.empty() && stack.back().kind == Expr_frame::binary) {
+      Expr_frame& f = stack.back();
+      if (prec > f.prec)
+        break;
+      e = p.on_binary_expr(f.tok, f.expr, e);
+      stack.pop_back();
+      if (!is_valid_node(e))
+        return unwind_expr(ts, stack);
+    }
 
+    // Match the next operator.
+    if (prec) {
+      stack.emplace_back(Expr_frame::binary, get_token(ts), e, prec);
+      e = nullptr;
+      continue;
+    }
 
-// Parse an expression.
-Expr const*
-parse_expr(Parser& p, Token_stream& ts)
-{
-  return parse_binary_expr(p, ts);
+    if (stack.empty())
+      return e;
+
+    // Close the innermost nested expression or argument list.
+    Expr_frame& f = stack.back();
+    if (f.kind == Expr_frame::paren) {
+      bool ok = expect_token(p, ts, rparen_tok);
+      stack.pop_back();
+      if (!ok)
+        return unwind_expr(ts, stack);
+    } else {
+      f.args.push_back(e);
+      if (match_token(ts, comma_tok)) {
+        e = nullptr;
+        continue;
+      }
+      Token const* open = f.tok;
+      Expr const* fn = f.expr;
+      Expr_seq args = std::move(f.args);
+      bool ok = expect_token(p, ts, rparen_tok);
+      stack.pop_back();
+      if (!ok)
+        return unwind_expr(ts, stack);
+      e = p.on_call_expr(open, fn, std::move(args));
+      if (!is_valid_node(e))
+        return unwind_expr(ts, stack);
+    }
+  }
 }
 
 
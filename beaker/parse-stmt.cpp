@@ -4,6 +4,8 @@
 #include "beaker/parse.hpp"
 #include "beaker/lookup.hpp"
 
+#include <memory>
+
 namespace beaker
 {
 
@@ -43,132 +45,224 @@ parse_empty_stmt(Parser& p, Token_stream& ts)
 }
 
 
-// Parse a sequence of statements.
+// Parse an declaration statement.
 //
-//    statement-seq ::= stmt [',' stmt*]
-Sequence_term<Stmt> const*
-parse_statement_seq(Parser& p, Token_stream& ts)
+//    declaration-stmt ::= decl
+Stmt const*
+parse_declaration_stmt(Parser& p, Token_stream& ts)
 {
-  using Result = Sequence_term<Stmt>;
-  Result result;
-  while (!ts.eof()) {
-    if (next_token_is(ts, rbrace_tok))
-      break;
-
-    if (Required<Stmt> term = parse_stmt(p, ts))
-      result.push_back(*term);
-    
-    // Continue parsing even though we got an error, continue
-    // parsing. This will allow us to diagnose as many errors
-    // as possible in a block statement.
-    else if (term.is_error())
-      continue;
-    
-    // We should probably never have this state.
-    else if (term.is_empty())
-      continue;
-  }
-  return Result::make(std::move(result));
+  if (Required<Decl> d = parse_decl(p, ts))
+    return p.on_declaration_stmt(*d);
+  return make_error_node<Stmt>();
 }
 
 
-// Parse a block statement.
+// Represents an expression wrapped in parens.
+using Paren_expr = Enclosed_term<Expr>;
+
+
+// -------------------------------------------------------------------------- //
+//                          Statement frames
+
+// Statements are parsed without recursion, so that the depth
+// of nesting is limited only by available memory. Each compound
+// statement whose parse is in progress is pushed onto an explicit
+// stack of frames:
+//
+//    - a block frame holds the '{' of a block, its local scope,
+//      and the statements parsed so far,
+//    - an if frame holds the 'if' token and condition of an if
+//      statement, and its "then" clause once that is parsed,
+//    - a while frame holds the 'while' token and condition of a
+//      while statement, and
+//    - a do frame holds the 'do' token of a do statement.
+//
+// Each parsed statement is passed to the innermost frame, which
+// may in turn be completed.
+struct Stmt_frame
+{
+  enum Kind { block, if_, while_, do_ };
+
+  Stmt_frame(Kind k, Token const* t, Expr const* e = nullptr)
+    : kind(k), tok1(t), tok2(nullptr), cond(e), body(nullptr)
+  { }
+
+  Kind                         kind;
+  Token const*                 tok1;  // The first token
+  Token const*                 tok2;  // The 'else' token, if any
+  Expr const*                  cond;  // The condition, if any
+  Stmt const*                  body;  // The "then" clause of an if
+  Stmt_seq                     stmts; // The statements of a block
+  std::unique_ptr<Local_scope> scope; // The scope of a block
+};
+
+
+using Stmt_stack = std::vector<Stmt_frame>;
+
+
+// Begin a block statement.
 //
 //    block-stmt ::= '{' stmt-seq '}'
 //
+//    statement-seq ::= stmt*
+//
 // Each block defines a new local scope.
-Stmt const*
-parse_block_stmt(Parser& p, Token_stream& ts)
+void
+parse_block_open(Parser& p, Token_stream& ts, Stmt_stack& stack)
 {
-  Local_scope scope; // Enter a new local scope.
-
-  using Term = Enclosed_term<Sequence_term<Stmt>>;
-  if (Required<Term> enc = parse_brace_enclosed(p, ts, parse_statement_seq)) {
-    // Note that enc->term() may be empty (null) if there are
-    // no statements in the block.
-    if (enc->term())
-      return p.on_block_stmt(enc->open(), enc->close(), *enc->term());
-    else
-      return p.on_block_stmt(enc->open(), enc->close(), {});
-  }
-  else
-    return make_error_node<Stmt>();
+  std::unique_ptr<Local_scope> scope(new Local_scope());
+  Token const* tok = require_token(ts, lbrace_tok);
+  stack.emplace_back(Stmt_frame::block, tok);
+  stack.back().scope = std::move(scope);
 }
 
 
-// Parse an declaration statement.
-//
-//    declaration-stmt ::= decl
+// Complete the block statement at the top of the stack. The
+// block has no more statements when the next token is '}' or
+// when the input is exhausted.
 Stmt const*
-parse_declaration_stmt(Parser& p, Token_stream& ts)
+parse_block_close(Parser& p, Token_stream& ts, Stmt_stack& stack)
 {
-  if (Required<Decl> d = parse_decl(p, ts))
-    return p.on_declaration_stmt(*d);
-  return make_error_node<Stmt>();
+  Stmt_frame& f = stack.back();
+  Stmt const* s;
+  if (Token const* tok = expect_token(p, ts, rbrace_tok))
+    s = p.on_block_stmt(f.tok1, tok, std::move(f.stmts));
+  else
+    s = make_error_node<Stmt>();
+  stack.pop_back();
+  return s;
 }
 
 
-// Represents an expression wrapped in parens.
-using Paren_expr = Enclosed_term<Expr>;
-
-
-// Parse an if-then or if-else statement.
+// Begin an if-then or if-else statement. Returns an error
+// if the condition could not be parsed.
 //
 //    if-stmt ::= if '(' expr ')' stmt
 //              | if '(' expr ')' stmt 'else' stmt
-//
 Stmt const*
-parse_if_stmt(Parser& p, Token_stream& ts)
+parse_if_open(Parser& p, Token_stream& ts, Stmt_stack& stack)
 {
-  Token const* tok1 = require_token(ts, if_kw);
+  Token const* tok = require_token(ts, if_kw);
 
   // Match the condition.
   Required<Paren_expr> test = parse_paren_enclosed(p, ts, parse_expr);
   if (!test)
     return make_error_node<Stmt>();
-  Expr const* e = test->term();
+  stack.emplace_back(Stmt_frame::if_, tok, test->term());
+  return nullptr;
+}
 
-  // Match the "then" clause.
-  Required<Stmt> b1 = parse_expected(p, ts, parse_stmt);
-  if (!b1)
-    return make_error_node<Stmt>();
 
-  // Match "else stmt".
-  if (Token const* tok2 = match_token(ts, else_kw)) {
-    Required<Stmt> b2 = parse_expected(p, ts, parse_stmt);
-    if (!b2)
-      return make_error_node<Stmt>();
-    return p.on_if_else_stmt(tok1, tok2, e, *b1, *b2);
+// Pass the statement `s` to the if statement at the top of the
+// stack. When `s` is the "then" clause and an 'else' follows,
+// the if statement remains on the stack and nullptr is returned.
+// Otherwise, the completed if statement is returned.
+Stmt const*
+parse_if_close(Parser& p, Token_stream& ts, Stmt_stack& stack, Stmt const* s)
+{
+  Stmt_frame& f = stack.back();
+  if (!is_valid_node(s)) {
+    s = make_error_node<Stmt>();
+  } else if (f.tok2) {
+    // Match "else stmt".
+    s = p.on_if_else_stmt(f.tok1, f.tok2, f.cond, f.body, s);
+  } else if (Token const* tok = match_token(ts, else_kw)) {
+    f.tok2 = tok;
+    f.body = s;
+    return nullptr;
   } else {
-    return p.on_if_then_stmt(tok1, e, *b1);
+    s = p.on_if_then_stmt(f.tok1, f.cond, s);
   }
+  stack.pop_back();
+  return s;
 }
 
 
-// Parse a while statement.
+// Begin a while statement. Returns an error if the condition
+// could not be parsed.
 //
 //    while-stmt ::= 'while' '(' expr ')' stmt
-//
-// TODO: Factor out the 'while '(' expr ')' as a separate
-// clause?
 Stmt const*
-parse_while_stmt(Parser& p, Token_stream& ts)
+parse_while_open(Parser& p, Token_stream& ts, Stmt_stack& stack)
 {
-  error(ts.location(), "not implemented");
-  return make_error_node<Stmt>();
+  Token const* tok = require_token(ts, while_kw);
+
+  // Match the condition.
+  Required<Paren_expr> test = parse_paren_enclosed(p, ts, parse_expr);
+  if (!test)
+    return make_error_node<Stmt>();
+  stack.emplace_back(Stmt_frame::while_, tok, test->term());
+  return nullptr;
+}
+
+
+// Pass the body `s` to the while statement at the top of the
+// stack, completing it.
+Stmt const*
+parse_while_close(Parser& p, Token_stream& ts, Stmt_stack& stack, Stmt const* s)
+{
+  Stmt_frame& f = stack.back();
+  if (is_valid_node(s))
+    s = p.on_while_stmt(f.tok1, f.cond, s);
+  else
+    s = make_error_node<Stmt>();
+  stack.pop_back();
+  return s;
 }
 
 
-// Parse a do statement.
+// Begin a do statement.
 //
 //    do-stmt ::= 'do' stmt 'while' '(' expr ')' ';'
-//
-// TODO: See comments above.
+void
+parse_do_open(Parser& p, Token_stream& ts, Stmt_stack& stack)
+{
+  Token const* tok = require_token(ts, do_kw);
+  stack.emplace_back(Stmt_frame::do_, tok);
+}
+
+
+// Pass the body `s` to the do statement at the top of the
+// stack, and match the condition that follows it.
 Stmt const*
-parse_do_stmt(Parser& p, Token_stream& ts)
+parse_do_close(Parser& p, Token_stream& ts, Stmt_stack& stack, Stmt const* s)
 {
-  error(ts.location(), "not implemented");
-  return make_error_node<Stmt>();
+  Stmt_frame& f = stack.back();
+  Token const* tok1 = f.tok1;
+  stack.pop_back();
+  if (!is_valid_node(s))
+    return make_error_node<Stmt>();
+
+  // Match "while (expr);".
+  Token const* tok2 = expect_token(p, ts, while_kw);
+  if (!tok2)
+    return make_error_node<Stmt>();
+  Required<Paren_expr> test = parse_paren_enclosed(p, ts, parse_expr);
+  if (!test)
+    return make_error_node<Stmt>();
+  if (!expect_token(p, ts, semicolon_tok))
+    return make_error_node<Stmt>();
+  return p.on_do_stmt(tok1, tok2, test->term(), s);
+}
+
+
+// Pass the statement `s` to the compound statement at the top
+// of the stack. Returns the completed statement, or nullptr if
+// the statement requires another.
+Stmt const*
+parse_close(Parser& p, Token_stream& ts, Stmt_stack& stack, Stmt const* s)
+{
+  switch (stack.back().kind) {
+    case Stmt_frame::if_:
+      return parse_if_close(p, ts, stack, s);
+    case Stmt_frame::while_:
+      return parse_while_close(p, ts, stack, s);
+    case Stmt_frame::do_:
+      return parse_do_close(p, ts, stack, s);
+    default:
+      break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -254,38 +348,82 @@ parse_expression_stmt(Parser& p, Token_stream& ts)
 //
 //    statement ::= declaration-statement
 //                | block-statement
+//                | if-statement
+//                | while-statement
+//                | do-statement
 //                | return-statement
 //                | expression-statement
+//
+// Each iteration of the loop either begins a compound statement
+// or parses a simple statement. A parsed statement completes the
+// frames that are waiting for it, until one requires another
+// statement.
 Stmt const*
 parse_stmt(Parser& p, Token_stream& ts)
 {
-  switch (next_token_kind(ts)) {
-    case semicolon_tok:
-      return parse_empty_stmt(p, ts);
-
-    case lbrace_tok:
-      return parse_block_stmt(p, ts);
-    
-    case var_kw:
-    case def_kw:
-      return parse_declaration_stmt(p, ts);
-
-    case if_kw:
-      return parse_if_stmt(p, ts);
-
-    case while_kw:
-      return parse_while_stmt(p, ts);
-
-    case do_kw:
-      return parse_do_stmt(p, ts);
+  Stmt_stack stack;
+  while (true) {
+    Stmt const* s;
+    if (!stack.empty() &&
+        stack.back().kind == Stmt_frame::block &&
+        (ts.eof() || next_token_is(ts, rbrace_tok))) {
+      s = parse_block_close(p, ts, stack);
+    } else {
+      switch (next_token_kind(ts)) {
+        case semicolon_tok:
+          s = parse_empty_stmt(p, ts);
+          break;
+
+        case lbrace_tok:
+          parse_block_open(p, ts, stack);
+          continue;
+        
+        case var_kw:
+        case def_kw:
+          s = parse_declaration_stmt(p, ts);
+          break;
+
+        case if_kw:
+          s = parse_if_open(p, ts, stack);
+          if (!s)
+            continue;
+          break;
+
+        case while_kw:
+          s = parse_while_open(p, ts, stack);
+          if (!s)
+            continue;
+          break;
+
+        case do_kw:
+          parse_do_open(p, ts, stack);
+          continue;
+
+        case return_kw:
+          s = parse_return_stmt(p, ts);
+          break;
+        
+        default:
+          s = parse_expression_stmt(p, ts);
+          break;
+      }
+    }
 
-    case return_kw:
-      return parse_return_stmt(p, ts);
-    
-    default:
-      return parse_expression_stmt(p, ts);
+    // Pass the statement to the enclosing frames. Continue 
+    // parsing after an error in a block statement. This will
+    // allow us to diagnose as many errors as possible.
+    while (s) {
+      if (stack.empty())
+        return s;
+      if (stack.back().kind == Stmt_frame::block) {
+        if (is_valid_node(s))
+          stack.back().stmts.push_back(s);
+        s = nullptr;
+      } else {
+        s = parse_close(p, ts, stack, s);
+      }
+    }
   }
-  lingo_unreachable();
 }
 
 
@@ -28,7 +28,7 @@ parse_type(Parser& p, Token_stream& ts)
       break;
   }
   
-  error(ts.location(), "invalid type '{}'", ts.peek());
+  diagnose(ts.location(), "invalid type '{}'", ts.peek());
   return make_error_node<Type>();
 }
 
@@ -14,12 +14,29 @@
 #include "beaker/evaluate.hpp"
 #include "beaker/graph.hpp"
 #include "beaker/compact.hpp"
+#include "beaker/arena.hpp"
+#include "beaker/context.hpp"
+#include "beaker/thread.hpp"
+#include "beaker/diagnostic.hpp"
 
 
 namespace beaker
 {
 
 Decl const* parse_decl(Parser&, Token_stream&);
+Stmt const* parse_stmt(Parser&, Token_stream&);
+
+
+// Consume a token of kind `k`, which is required by the grammar.
+// Returns nullptr if the next token is not of that kind.
+Token const*
+expect_token(Parser&, Token_stream& ts, int k)
+{
+  if (Token const* tok = match_token(ts, k))
+    return tok;
+  diagnose(ts.location(), "expected '{}' but got '{}'", token_names()[k], ts.peek());
+  return nullptr;
+}
 
 
 // Parse a translation unit.
@@ -32,21 +49,182 @@ parse_file(Parser& p, Token_stream& ts)
   // Enter the global lexical scope.
   Global_scope scope;
 
-  using Term = Sequence_term<Decl>;
-  if (Required<Term> enc = parse_sequence(p, ts, parse_decl))
-    return p.on_unit(**enc);
-  else
-    return make_error_node<Unit>();
+  // No tokens are retained across top-level declarations,
+  // so release them as each declaration is finished.
+  Decl_seq decls;
+  while (!ts.eof()) {
+    Decl const* d = parse_decl(p, ts);
+    if (is_valid_node(d))
+      decls.push_back(d);
+    ts.release();
+  }
+  return p.on_unit(decls);
 }
 
+
+// Parse the text of the buffer. Tokens are lexed on demand
+// as the parser consumes them.
+//
+// The nodes of the program are allocated in an arena owned
+// by the resulting unit.
 Unit const*
-parse(Token_list const& toks)
+parse(Buffer& buf)
 {
-  // Note that the token stream will update the input
-  // context as we consume tokens.
-  Token_stream ts(toks);  
+  std::unique_ptr<Arena> arena(new Arena());
+  Use_arena use(*arena);
+  Token_stream ts(buf);
   Parser p;
-  return parse_file(p, ts);
+  Unit const* u = parse_file(p, ts);
+  modify(u)->arena_ = std::move(arena);
+  return u;
+}
+
+
+// Parse the text of the buffer, checking the definitions of
+// functions in parallel on the threads of `pool` once all
+// declarations have been parsed. A function whose definition
+// fails to check has an invalid body. The resulting unit is the
+// same as for parse(buf).
+//
+// Errors diagnosed while checking definitions are emitted after
+// those diagnosed while parsing, in the order of the definitions.
+Unit const*
+parse(Buffer& buf, Thread_pool& pool)
+{
+  std::unique_ptr<Arena> arena(new Arena());
+  Use_arena use(*arena);
+  Token_stream ts(buf);
+  Definition_seq defs;
+  Parser p(defs);
+  Unit const* u = parse_file(p, ts);
+  modify(u)->arena_ = std::move(arena);
+
+  check_definitions(defs, pool);
+
+  // Define the functions, giving invalid bodies to those
+  // that failed to check.
+  for (Definition const& def : defs)
+    modify(def.decl)->define(def.valid ? def.body : make_error_node<Stmt>());
+  return u;
+}
+
+
+// Parse the text of the buffer within the given compilation
+// context. Compilations in different contexts can proceed
+// concurrently.
+Unit const*
+parse(Context& cxt, Buffer& buf)
+{
+  Use_context use(cxt);
+  return parse(buf);
+}
+
+
+// -------------------------------------------------------------------------- //
+//                            Deferred parsing
+//
+// Tools that need only the declarations of a unit (e.g., to
+// list signatures or emit declarations) do not need to parse
+// the bodies of functions. When parsing declarations, the block
+// body of each function is skipped by matching braces, and its
+// text is saved. The body is parsed when it is first requested.
+//
+// A deferred body is parsed in the scope of the declarations
+// that precede its function in the unit, so its meaning is the
+// same as if it had been parsed with those declarations. Those
+// declarations are found through an index of the declarations
+// of the unit, which is built once, when the unit is parsed. The
+// body is checked after it is parsed. As when parsing the whole
+// file, a body that fails to parse or check is an error node.
+//
+// Deferred bodies must be parsed in the context in which their
+// unit was parsed. Parsing a body modifies its function, so
+// bodies must not be requested concurrently. The back ends parse
+// all bodies with parse_bodies (see allocate_slots) before they
+// run or compile any function, and only read them afterwards.
+
+
+// Parse the text of the buffer, deferring the bodies of
+// functions.
+Unit const*
+parse_declarations(Buffer& buf)
+{
+  std::unique_ptr<Arena> arena(new Arena());
+  Use_arena use(*arena);
+  Token_stream ts(buf);
+  Parser::Deferred_seq bodies;
+  Parser p(bodies);
+  Unit const* u = parse_file(p, ts);
+
+  // Index the declarations of the unit, and record the position
+  // of each function whose body is deferred.
+  Decl_index* index = get_arena().make<Decl_index>();
+  Decl_seq const& decls = u->declarations();
+  for (std::size_t i = 0; i < decls.size(); ++i) {
+    index->insert(decls[i], i);
+    if (Function_decl const* f = as<Function_decl>(decls[i]))
+      if (Deferred_body* b = f->third) {
+        b->index = index;
+        b->pos = i;
+      }
+  }
+  for (Deferred_body* b : bodies)
+    b->unit = u;
+
+  modify(u)->arena_ = std::move(arena);
+  return u;
+}
+
+
+namespace
+{
+
+// Parse and check the deferred body of `f`. The enclosing
+// declarations of `f` must be in scope.
+Stmt const*
+parse_deferred(Function_decl const* f)
+{
+  Deferred_body* b = f->third;
+  modify(f)->defer(nullptr);
+
+  Use_arena use(*b->unit->arena_);
+  Input_context in(*b->buf);
+  char const* text = b->buf->begin();
+  Token_stream ts(*b->buf, text + b->first, text + b->last);
+  Function_scope scope;
+  Parser p;
+  Stmt const* s = make_error_node<Stmt>();
+  if (is_valid_node(p.on_function_start(f))) {
+    Stmt const* s1 = parse_stmt(p, ts);
+    if (is_valid_node(s1) && check_definition(f, s1))
+      s = s1;
+  }
+  modify(f)->define(s);
+  return s;
+}
+
+} // namespace
+
+
+// Parse the deferred body of `f`, which is then the body of
+// `f`. The declarations of its unit up to and including `f`
+// are visible in the body.
+Stmt const*
+parse_body(Function_decl const* f)
+{
+  Use_decl_index use(*f->third->index, f->third->pos + 1);
+  return parse_deferred(f);
+}
+
+
+// Parse all deferred bodies in the unit `u`.
+void
+parse_bodies(Unit const* u)
+{
+  for (Decl const* d : u->declarations())
+    if (Function_decl const* f = as<Function_decl>(d))
+      if (f->is_deferred())
+        parse_body(f);
 }
 
 
@@ -85,10 +263,16 @@ Parser::on_boolean_lit(Token const* tok)
 }
 
 
+// The value `n` of the literal, which is computed by the lexer,
+// must be representable in the precision of the integer type.
 Expr const*
-Parser::on_integer_lit(Token const* tok)
+Parser::on_integer_lit(Token const* tok, Value n)
 {
-  return make_int_expr(tok->location(), as_int(*tok));
+  if (n < 0 || n >> (get_int_type()->precision() - 1)) {
+    diagnose(tok->location(), "integer literal '{}' is too large", *tok);
+    return make_error_node<Expr>();
+  }
+  return make_int_expr(tok->location(), n);
 }
 
 
@@ -97,15 +281,15 @@ Parser::on_identifier_expr(Token const* tok)
 {
   if (Required<Decl> decl = lookup(tok->str()))
     return make_identifier_expr(tok->location(), *decl);
-  error(tok->location(), "unresolved symbol '{}'", *tok);
+  diagnose(tok->location(), "unresolved symbol '{}'", *tok);
   return make_error_node<Expr>();
 }
 
 
 Expr const*
-Parser::on_call_expr(Token const* tok, Expr const* fn, Expr_seq const& args)
+Parser::on_call_expr(Token const* tok, Expr const* fn, Expr_seq&& args)
 {
-  return make_call_expr(tok->location(), fn, args);
+  return make_call_expr(tok->location(), fn, std::move(args));
 }
 
 
@@ -231,16 +415,38 @@ Parser::on_function_start(Decl const* d)
 }
 
 
+// Defer the definition of the function, whose body is the
+// text of `buf` from `first` through `last`.
+Decl const*
+Parser::on_function_defer(Decl const* d, Buffer& buf, Location first, Location last)
+{
+  Function_decl const* f = cast<Function_decl>(d);
+  Deferred_body body {&buf, first.offset(), last.offset() + 1, nullptr, nullptr, 0};
+  Deferred_body* b = get_arena().make<Deferred_body>(body);
+  bodies->push_back(b);
+  modify(f)->defer(b);
+  return f;
+}
+
+
 // Finish the function definitionby assigning the statement.
+//
+// Because the function has already been declared, a body that
+// fails to parse or check does not remove the function. Instead,
+// its body is an error node. Such a function is printed as a
+// declaration, and is not defined by any back end.
 Decl const*
 Parser::on_function_finish(Decl const* d, Stmt const* s)
 {
   Function_decl const* f = cast<Function_decl>(d);
-  if (check_definition(f, s)) {
-    modify(f)->define(s);
+  if (defs && is_valid_node(s)) {
+    defs->push_back(Definition{f, s, false});
     return f;
   }
-  return make_error_node<Decl>();
+  if (!is_valid_node(s) || !check_definition(f, s))
+    s = make_error_node<Stmt>();
+  modify(f)->define(s);
+  return f;
 }
 
 
@@ -259,9 +465,9 @@ Parser::on_empty_stmt(Token const* tok)
 
 
 Stmt const*
-Parser::on_block_stmt(Token const* l, Token const* r, Stmt_seq const& s)
+Parser::on_block_stmt(Token const* l, Token const* r, Stmt_seq&& s)
 {
-  return make_block_stmt(l->location(), r->location(), s);
+  return make_block_stmt(l->location(), r->location(), std::move(s));
 }
 
 
@@ -287,16 +493,16 @@ Parser::on_if_else_stmt(Token const* tok1, Token const* tok2, Expr const* e, Stm
 
 
 Stmt const*
-Parser::on_while_stmt(Token const*, Expr const*, Stmt const*)
+Parser::on_while_stmt(Token const* tok, Expr const* e, Stmt const* s)
 {
-  return nullptr;
+  return make_while_stmt(tok->location(), e, s);
 }
 
 
 Stmt const*
-Parser::on_do_stmt(Token const*, Token const*, Expr const*, Stmt const*)
+Parser::on_do_stmt(Token const* tok1, Token const* tok2, Expr const* e, Stmt const* s)
 {
-  return nullptr;
+  return make_do_stmt(tok1->location(), tok2->location(), e, s);
 }
 
 
@@ -6,6 +6,9 @@
 
 #include "beaker/prelude.hpp"
 #include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/function.hpp"
+#include "beaker/diagnostic.hpp"
 
 #include "lingo/parsing.hpp"
 
@@ -18,14 +21,39 @@ namespace beaker
 //                          Parsing interface
 
 
+struct Deferred_body;
+
+
 // The parser is responsible for constructing syntax nodes
 // from information provided by parse functions.
 //
 // Note that the members of this class expose certain hooks in
 // the grammar.
+//
+// When constructed with a sequence of definitions, the parser
+// does not check function definitions as they are parsed.
+// Instead, they are appended to that sequence, to be checked
+// once the unit has been parsed.
+//
+// When constructed with a sequence of deferred bodies, the
+// parser skips the block bodies of functions, recording the
+// text of each in that sequence.
 struct Parser
 {
   using result_type = void*;
+  using Deferred_seq = std::vector<Deferred_body*>;
+
+  Parser()
+    : defs(nullptr), bodies(nullptr)
+  { }
+
+  explicit Parser(Definition_seq& d)
+    : defs(&d), bodies(nullptr)
+  { }
+
+  explicit Parser(Deferred_seq& b)
+    : defs(nullptr), bodies(&b)
+  { }
 
   String const* on_name(Token const*);
 
@@ -34,23 +62,24 @@ struct Parser
   Type const* on_int_type(Token const*);
 
   Expr const* on_boolean_lit(Token const*);
-  Expr const* on_integer_lit(Token const*);
+  Expr const* on_integer_lit(Token const*, Value);
   Expr const* on_identifier_expr(Token const*);
   Expr const* on_integer_expr(Token const*);
   Expr const* on_member_expr(Token const*, Expr const*, Expr const*);
   Expr const* on_unary_expr(Token const*, Expr const*);
   Expr const* on_binary_expr(Token const*, Expr const*, Expr const*);
-  Expr const* on_call_expr(Token const*, Expr const*, Expr_seq const&);
+  Expr const* on_call_expr(Token const*, Expr const*, Expr_seq&&);
 
   Decl const* on_variable_decl(Token const*, Token const*, Type const*);
   Decl const* on_variable_init(Decl const*, Expr const*);
   Decl const* on_function_decl(Token const*, Token const*, Decl_seq const&, Type const*);
   Decl const* on_function_start(Decl const*);
   Decl const* on_function_finish(Decl const*, Stmt const*);
+  Decl const* on_function_defer(Decl const*, Buffer&, Location, Location);
   Decl const* on_parameter_decl(Token const*, Type const*);
 
   Stmt const* on_empty_stmt(Token const*);
-  Stmt const* on_block_stmt(Token const*, Token const*, Stmt_seq const&);
+  Stmt const* on_block_stmt(Token const*, Token const*, Stmt_seq&&);
   Stmt const* on_declaration_stmt(Decl const*);
   Stmt const* on_if_then_stmt(Token const*, Expr const*, Stmt const*);
   Stmt const* on_if_else_stmt(Token const*, Token const*, Expr const*, Stmt const*, Stmt const*);
@@ -62,17 +91,46 @@ struct Parser
   Stmt const* on_assignment_stmt(Token const*, Token const*, Expr const*, Expr const*);
 
   Unit const* on_unit(Decl_seq const&);
+
+  Definition_seq* defs;   // Deferred definitions, if any
+  Deferred_seq*   bodies; // Deferred bodies, if any
 };
 
 
 void init_grammar();
 
-Unit const* parse(Token_list const&);
+Unit const* parse(Buffer&);
+Unit const* parse(Context&, Buffer&);
+Unit const* parse(Buffer&, Thread_pool&);
+
+Unit const* parse_declarations(Buffer&);
+void        parse_bodies(Unit const*);
 
 
 // ---------------------------------------------------------------------------//
 //                          Parsing support
 
+// The parsing support of lingo reports errors through lingo.
+// These overloads are preferred for the parser, and report
+// errors through diagnose() instead, so that they are counted
+// in the current context (see context.hpp).
+
+Token const* expect_token(Parser&, Token_stream&, int);
+
+
+// Parse a term that is required by the grammar.
+template<typename Rule,
+         typename Term = Term_type<Parser, Token_stream, Rule>>
+inline Term const*
+parse_expected(Parser& p, Token_stream& ts, Rule rule)
+{
+  if (Term const* t = rule(p, ts))
+    return t;
+  diagnose(ts.location(), "expected term but got '{}'", ts.peek());
+  return make_error_node<Term>();
+}
+
+
 // Parse a paren-enclosed term.
 template<typename Parser, 
          typename Stream, 
@@ -105,7 +163,19 @@ template<typename Parser,
 inline Sequence_term<Term> const*
 parse_comma_list(Parser& p, Stream& ts, Rule rule)
 {
-  return parse_list(p, ts, comma_tok, rule);
+  // Diagnose a missing term after a comma here, so that
+  // parse_list() only sees a term or an error.
+  bool first = true;
+  auto elem = [&first, rule](Parser& p, Stream& ts) -> Term const* {
+    Term const* t = rule(p, ts);
+    if (!t && !first) {
+      diagnose(ts.location(), "expected term");
+      t = make_error_node<Term>();
+    }
+    first = false;
+    return t;
+  };
+  return parse_list(p, ts, comma_tok, elem);
 }
 
 } // namespace beaker
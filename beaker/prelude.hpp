@@ -30,7 +30,7 @@
 #include "lingo/debug.hpp"
 
 // Support sequences of terms.
-#include <vector>
+#include "beaker/sequence.hpp"
 
 
 namespace beaker
@@ -82,22 +82,25 @@ struct Return_stmt;
 struct Block_stmt;
 
 struct Unit;
+struct Decl_index;
+
+struct Context;
 
 
 // A sequence of types.
-using Type_seq = std::vector<Type const*>;
+using Type_seq = Small_vector<Type const*, 4>;
 
 
 // A sequence of expressions.
-using Expr_seq = std::vector<Expr const*>;
+using Expr_seq = Small_vector<Expr const*, 4>;
 
 
 // A sequence of declarations.
-using Decl_seq = std::vector<Decl const*>;
+using Decl_seq = Small_vector<Decl const*, 4>;
 
 
 // A list of statements.
-using Stmt_seq = std::vector<Stmt const*>;
+using Stmt_seq = Small_vector<Stmt const*, 4>;
 
 
 } // namespace beaker
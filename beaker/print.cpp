@@ -8,6 +8,8 @@
 #include "beaker/stmt.hpp"
 #include "beaker/unit.hpp"
 
+#include <vector>
+
 
 namespace beaker
 {
@@ -124,10 +126,75 @@ print(Printer& p, Reference_type const* t)
 // Print an expression.
 //
 //    expression ::= <see grammar>
+//
+// Subexpressions are printed using an explicit stack, so the
+// depth of `e` is limited only by available memory. The state
+// of each frame is the number of its subexpressions that have
+// been printed.
 void 
 print(Printer& p, Expr const* e)
 {
-  return apply(e, Print_fn(p));
+  struct Frame
+  {
+    Expr const* expr;
+    std::size_t state;
+  };
+  std::vector<Frame> work {{e, 0}};
+  while (!work.empty()) {
+    Frame& f = work.back();
+    switch (f.expr->kind()) {
+      case unary_expr_kind: {
+        // The operand replaces the unary expression.
+        Unary_expr const* u = cast<Unary_expr>(f.expr);
+        print(p, u->op());
+        f = {u->arg(), 0};
+        continue;
+      }
+
+      case binary_expr_kind: {
+        Binary_expr const* b = cast<Binary_expr>(f.expr);
+        if (f.state == 0) {
+          f.state = 1;
+          work.push_back({b->left(), 0});
+          continue;
+        }
+        if (f.state == 1) {
+          f.state = 2;
+          print_space(p);
+          print(p, b->op());
+          print_space(p);
+          work.push_back({b->right(), 0});
+          continue;
+        }
+        break;
+      }
+
+      case call_expr_kind: {
+        Call_expr const* c = cast<Call_expr>(f.expr);
+        Expr_seq const& args = c->arguments();
+        std::size_t n = f.state++;
+        if (n == 0) {
+          work.push_back({c->function(), 0});
+          continue;
+        }
+        if (n == 1)
+          print(p, '(');
+        if (n <= args.size()) {
+          if (n > 1)
+            print(p, ", ");
+          work.push_back({args[n - 1], 0});
+          continue;
+        }
+        print(p, ')');
+        break;
+      }
+
+      default:
+        apply(f.expr, Print_fn(p));
+        break;
+    }
+    work.pop_back();
+  }
 }
 
 
@@ -251,8 +318,16 @@ print(Printer& p, Function_decl const* d)
   print_parms(p, d);
   print(p, " -> ");
   print(p, d->return_type());
+
+  // A deferred body that failed to parse or check is invalid.
+  // Print only the declaration.
+  Stmt const* s = d->body();
+  if (!is_valid_node(s)) {
+    print(p, ';');
+    return;
+  }
   print_space(p);
-  print(p, d->body());
+  print(p, s);
 }
 
 
@@ -268,10 +343,72 @@ print(Printer& p, Parameter_decl const* d)
 // -------------------------------------------------------------------------- //
 //                                  Statements
 
+namespace
+{
+
+void
+print_paren_expr(Printer& p, Expr const* e)
+{
+  print(p, '(');
+  print(p, e);
+  print(p, ')');
+}
+
+} // namespace
+
+
+// Print a statement.
+//
+// Like expressions, nested statements are printed using an 
+// explicit stack. The state of a block is the number of its
+// statements that have been printed. Note that the statements
+// of a block are laid out as by print_nested().
 void
 print(Printer& p, Stmt const* s)
 {
-  apply(s, Print_fn(p));
+  struct Frame
+  {
+    Stmt const* stmt;
+    std::size_t state;
+  };
+  std::vector<Frame> work {{s, 0}};
+  while (!work.empty()) {
+    Frame& f = work.back();
+    switch (f.stmt->kind()) {
+      case if_then_stmt_kind: {
+        // The branch replaces the if statement.
+        If_then_stmt const* s1 = cast<If_then_stmt>(f.stmt);
+        print(p, "if ");
+        print_paren_expr(p, s1->condition());
+        print_space(p);
+        f = {s1->branch(), 0};
+        continue;
+      }
+
+      case block_stmt_kind: {
+        Stmt_seq const& ss = cast<Block_stmt>(f.stmt)->statements();
+        std::size_t n = f.state++;
+        if (n == 0) {
+          print(p, '{');
+          indent(p);
+        }
+        if (n < ss.size()) {
+          print_newline(p);
+          work.push_back({ss[n], 0});
+          continue;
+        }
+        undent(p);
+        print_newline(p);
+        print(p, '}');
+        break;
+      }
+
+      default:
+        apply(f.stmt, Print_fn(p));
+        break;
+    }
+    work.pop_back();
+  }
 }
 
 
@@ -305,20 +442,6 @@ print(Printer& p, Assignment_stmt const* s)
 }
 
 
-namespace
-{
-
-void
-print_paren_expr(Printer& p, Expr const* e)
-{
-  print(p, '(');
-  print(p, e);
-  print(p, ')');
-}
-
-} // namespace
-
-
 void
 print(Printer& p, If_then_stmt const* s)
 {
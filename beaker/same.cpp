@@ -3,58 +3,72 @@
 
 #include "beaker/same.hpp"
 #include "beaker/type.hpp"
+#include "beaker/expr.hpp"
 
-#include <typeindex>
 
 namespace beaker
 {
 
-// Dispatch to an appropriate function.
-struct Same_fn
+// Returns true if one expression is the same as another.
+// Identical expressions (e.g., those shared by compact())
+// are trivially the same. Otherwise, expressions of the same
+// kind are compared structurally.
+bool
+same(Expr const* a, Expr const* b)
 {
-  Same_fn(Type const* t)
-    : t2(t)
-  { }
+  if (a == b)
+    return true;
+  if (a->kind() != b->kind())
+    return false;
 
-  bool operator()(Void_type const* t1) const
-  { 
-    return same(t1, static_cast<Void_type const*>(t2)); 
-  }
-  
-  bool operator()(Boolean_type const* t1) const
-  { 
-    return same(t1, static_cast<Boolean_type const*>(t2)); 
-  }
-  
-  bool operator()(Integer_type const* t1) const
-  { 
-    return same(t1, static_cast<Integer_type const*>(t2)); 
-  }
-  
-  bool operator()(Function_type const* t1) const
-  { 
-    return same(t1, static_cast<Function_type const*>(t2)); 
+  switch (a->kind()) {
+  case constant_expr_kind:
+    return same(static_cast<Constant_expr const*>(a),
+                static_cast<Constant_expr const*>(b));
+  case identifier_expr_kind:
+    return same(static_cast<Identifier_expr const*>(a),
+                static_cast<Identifier_expr const*>(b));
+  case unary_expr_kind:
+    return same(static_cast<Unary_expr const*>(a),
+                static_cast<Unary_expr const*>(b));
+  case binary_expr_kind:
+    return same(static_cast<Binary_expr const*>(a),
+                static_cast<Binary_expr const*>(b));
+  case call_expr_kind:
+    return same(static_cast<Call_expr const*>(a),
+                static_cast<Call_expr const*>(b));
   }
+  lingo_unreachable();
+}
 
-  bool operator()(Reference_type const* t1) const
-  { 
-    return same(t1, static_cast<Reference_type const*>(t2)); 
-  }
 
-  Type const* t2;
-};
+bool
+same(Constant_expr const* a, Constant_expr const* b)
+{
+  return same(a->type(), b->type()) && a->value() == b->value();
+}
 
 
-// Returns true if one type is the same as another.
-bool 
-same(Type const* a, Type const* b)
+bool
+same(Identifier_expr const* a, Identifier_expr const* b)
 {
-  std::type_index t1 = typeid(*a);
-  std::type_index t2 = typeid(*b);
-  if (t1 != t2)
-    return false;
-  else
-    return apply(a, Same_fn(b));
+  return a->decl() == b->decl();
+}
+
+
+bool
+same(Unary_expr const* a, Unary_expr const* b)
+{
+  return a->op() == b->op() && same(a->arg(), b->arg());
+}
+
+
+bool
+same(Binary_expr const* a, Binary_expr const* b)
+{
+  return a->op() == b->op()
+      && same(a->left(), b->left())
+      && same(a->right(), b->right());
 }
 
 
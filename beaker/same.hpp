@@ -14,7 +14,21 @@
 namespace beaker
 {
 
-bool same(Type const*, Type const*);
+// Returns true if one type is the same as another. Types
+// are canonical (see type.cpp), so two types are the same
+// only when they are the same object.
+inline bool
+same(Type const* a, Type const* b)
+{
+  return a == b;
+}
+
+
+bool same(Expr const*, Expr const*);
+bool same(Constant_expr const*, Constant_expr const*);
+bool same(Identifier_expr const*, Identifier_expr const*);
+bool same(Unary_expr const*, Unary_expr const*);
+bool same(Binary_expr const*, Binary_expr const*);
 
 
 // Two nullary terms are equivalent. Note that many
@@ -53,13 +67,14 @@ same(T const* a, T const * b)
 }
 
 
-// Lexicographically compares sequences of terms.
-template<typename T>
+// Returns true when two sequences of terms have the same
+// length and pairwise equivalent elements.
+template<typename T, std::size_t N>
 inline bool
-same(std::vector<T const*> a, std::vector<T const*> b)
+same(Small_vector<T const*, N> const& a, Small_vector<T const*, N> const& b)
 {
   auto cmp = [](T const* a, T const* b) { return same(a, b); };
-  return std::equal(a.begin(), a.end(), b.begin(), cmp);
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), cmp);
 }
 
 
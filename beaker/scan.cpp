@@ -0,0 +1,455 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define BEAKER_SCAN_X86 1
+#  include <immintrin.h>
+#endif
+
+
+namespace beaker
+{
+
+namespace
+{
+
+// -------------------------------------------------------------------------- //
+//                            Character classes
+
+inline bool
+is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n';
+}
+
+
+inline bool
+is_digit(char c)
+{
+  return (unsigned char)(c - '0') <= 9;
+}
+
+
+inline bool
+is_identifier_char(char c)
+{
+  return (unsigned char)((c | 0x20) - 'a') <= 'z' - 'a' || is_digit(c) || c == '_';
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Scalar scanning
+
+char const*
+scalar_skip_space(char const* first, char const* last)
+{
+  while (first != last && is_space(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_skip_identifier(char const* first, char const* last)
+{
+  while (first != last && is_identifier_char(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_skip_digits(char const* first, char const* last)
+{
+  while (first != last && is_digit(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_find_newline(char const* first, char const* last)
+{
+  while (first != last && *first != '\n')
+    ++first;
+  return first;
+}
+
+
+#if BEAKER_SCAN_X86
+
+// -------------------------------------------------------------------------- //
+//                              SSE2 scanning
+//
+// Each block of 16 characters is classified into a mask having
+// one bit per character. A run ends at the first character whose
+// bit is clear. The final partial block is scanned one character
+// at a time so that we never read past the end of the buffer,
+// which may be the end of a mapped page.
+
+inline __m128i
+sse2_space(__m128i v)
+{
+  __m128i s = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i t = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+  __m128i n = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  return _mm_or_si128(_mm_or_si128(s, t), n);
+}
+
+
+// Returns true in each lane where `v` is within [lo, lo + n].
+inline __m128i
+sse2_in_range(__m128i v, char lo, char n)
+{
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(n)), d);
+}
+
+
+inline __m128i
+sse2_digit(__m128i v)
+{
+  return sse2_in_range(v, '0', 9);
+}
+
+
+inline __m128i
+sse2_identifier(__m128i v)
+{
+  __m128i a = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z' - 'a');
+  __m128i u = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(a, u), sse2_digit(v));
+}
+
+
+// Skip characters while each block satisfies the predicate `f`.
+template<typename F, typename S>
+inline char const*
+sse2_skip(char const* first, char const* last, F f, S scalar)
+{
+  while (last - first >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+    unsigned m = ~_mm_movemask_epi8(f(v)) & 0xffff;
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 16;
+  }
+  return scalar(first, last);
+}
+
+
+char const*
+sse2_skip_space(char const* first, char const* last)
+{
+  return sse2_skip(first, last, sse2_space, scalar_skip_space);
+}
+
+
+char const*
+sse2_skip_identifier(char const* first, char const* last)
+{
+  return sse2_skip(first, last, sse2_identifier, scalar_skip_identifier);
+}
+
+
+char const*
+sse2_skip_digits(char const* first, char const* last)
+{
+  return sse2_skip(first, last, sse2_digit, scalar_skip_digits);
+}
+
+
+char const*
+sse2_find_newline(char const* first, char const* last)
+{
+  __m128i nl = _mm_set1_epi8('\n');
+  while (last - first >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+    unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 16;
+  }
+  return scalar_find_newline(first, last);
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              AVX2 scanning
+//
+// These are the same as the SSE2 scanners, but operate on blocks
+// of 32 characters. They are compiled for AVX2 regardless of the
+// compiler flags, and are only called when the processor supports
+// that instruction set.
+
+#define BEAKER_AVX2 __attribute__((target("avx2")))
+
+
+BEAKER_AVX2 inline __m256i
+avx2_space(__m256i v)
+{
+  __m256i s = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  __m256i t = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+  __m256i n = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+  return _mm256_or_si256(_mm256_or_si256(s, t), n);
+}
+
+
+BEAKER_AVX2 inline __m256i
+avx2_in_range(__m256i v, char lo, char n)
+{
+  __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(n)), d);
+}
+
+
+BEAKER_AVX2 inline __m256i
+avx2_digit(__m256i v)
+{
+  return avx2_in_range(v, '0', 9);
+}
+
+
+BEAKER_AVX2 inline __m256i
+avx2_identifier(__m256i v)
+{
+  __m256i a = avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z' - 'a');
+  __m256i u = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(a, u), avx2_digit(v));
+}
+
+
+BEAKER_AVX2 inline unsigned
+avx2_mask(__m256i v)
+{
+  return static_cast<unsigned>(_mm256_movemask_epi8(v));
+}
+
+
+BEAKER_AVX2 char const*
+avx2_skip_space(char const* first, char const* last)
+{
+  while (last - first >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    unsigned m = ~avx2_mask(avx2_space(v));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 32;
+  }
+  return sse2_skip_space(first, last);
+}
+
+
+BEAKER_AVX2 char const*
+avx2_skip_identifier(char const* first, char const* last)
+{
+  while (last - first >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    unsigned m = ~avx2_mask(avx2_identifier(v));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 32;
+  }
+  return sse2_skip_identifier(first, last);
+}
+
+
+BEAKER_AVX2 char const*
+avx2_skip_digits(char const* first, char const* last)
+{
+  while (last - first >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    unsigned m = ~avx2_mask(avx2_digit(v));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 32;
+  }
+  return sse2_skip_digits(first, last);
+}
+
+
+BEAKER_AVX2 char const*
+avx2_find_newline(char const* first, char const* last)
+{
+  __m256i nl = _mm256_set1_epi8('\n');
+  while (last - first >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    unsigned m = avx2_mask(_mm256_cmpeq_epi8(v, nl));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 32;
+  }
+  return sse2_find_newline(first, last);
+}
+
+
+#undef BEAKER_AVX2
+
+#endif
+
+
+// -------------------------------------------------------------------------- //
+//                              Dispatch
+
+using Scan_fn = char const* (*)(char const*, char const*);
+
+
+// A scanner is a set of implementations of the scanning
+// functions.
+struct Scanner
+{
+  Scan_fn space;
+  Scan_fn identifier;
+  Scan_fn digits;
+  Scan_fn newline;
+};
+
+
+Scanner const scalar_ {
+  scalar_skip_space,
+  scalar_skip_identifier,
+  scalar_skip_digits,
+  scalar_find_newline
+};
+
+#if BEAKER_SCAN_X86
+Scanner const sse2_ {
+  sse2_skip_space,
+  sse2_skip_identifier,
+  sse2_skip_digits,
+  sse2_find_newline
+};
+
+Scanner const avx2_ {
+  avx2_skip_space,
+  avx2_skip_identifier,
+  avx2_skip_digits,
+  avx2_find_newline
+};
+#endif
+
+
+// Returns true if the host supports the given scanner.
+bool
+is_supported(Scan_mode m)
+{
+#if BEAKER_SCAN_X86
+  __builtin_cpu_init();
+  switch (m) {
+    case scalar_scan: return true;
+    case sse2_scan: return __builtin_cpu_supports("sse2");
+    case avx2_scan: return __builtin_cpu_supports("avx2");
+  }
+  return false;
+#else
+  return m == scalar_scan;
+#endif
+}
+
+
+Scanner const*
+get_scanner(Scan_mode m)
+{
+  switch (m) {
+#if BEAKER_SCAN_X86
+    case avx2_scan: return &avx2_;
+    case sse2_scan: return &sse2_;
+#endif
+    default: return &scalar_;
+  }
+}
+
+
+// The current scanner and its mode.
+Scan_mode      mode_ = get_best_scan_mode();
+Scanner const* scan_ = get_scanner(mode_);
+
+
+} // namespace
+
+
+// Returns a pointer past the run of whitespace at the start
+// of [first, last).
+char const*
+skip_space(char const* first, char const* last)
+{
+  return scan_->space(first, last);
+}
+
+
+// Returns a pointer past the run of identifier characters
+// (letters, digits, and '_') at the start of [first, last).
+char const*
+skip_identifier(char const* first, char const* last)
+{
+  return scan_->identifier(first, last);
+}
+
+
+// Returns a pointer past the run of decimal digits at the
+// start of [first, last).
+char const*
+skip_digits(char const* first, char const* last)
+{
+  return scan_->digits(first, last);
+}
+
+
+// Returns a pointer to the first newline in [first, last).
+char const*
+find_newline(char const* first, char const* last)
+{
+  return scan_->newline(first, last);
+}
+
+
+// Returns the current scanner mode.
+Scan_mode
+get_scan_mode()
+{
+  return mode_;
+}
+
+
+// Returns the fastest scanner mode supported by the host.
+Scan_mode
+get_best_scan_mode()
+{
+  if (is_supported(avx2_scan))
+    return avx2_scan;
+  if (is_supported(sse2_scan))
+    return sse2_scan;
+  return scalar_scan;
+}
+
+
+// Select the scanner mode. Returns false if the mode is not
+// supported by the host, in which case the mode is unchanged.
+//
+// Note that this should not be called while lexing.
+bool
+set_scan_mode(Scan_mode m)
+{
+  if (!is_supported(m))
+    return false;
+  mode_ = m;
+  scan_ = get_scanner(m);
+  return true;
+}
+
+
+char const*
+get_spelling(Scan_mode m)
+{
+  switch (m) {
+    case scalar_scan: return "scalar";
+    case sse2_scan: return "sse2";
+    case avx2_scan: return "avx2";
+  }
+  lingo_unreachable("invalid scan mode ({})", (int)m);
+}
+
+
+} // namespace beaker
@@ -0,0 +1,48 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_SCAN_HPP
+#define BEAKER_SCAN_HPP
+
+// The scan module provides fast scanning of the character runs
+// that dominate lexing: whitespace, the text of line comments,
+// and the characters of identifiers and integers.
+//
+// Each scanner returns a pointer to the first character in
+// [first, last) that does not belong to the run, or last if
+// every character does. Scanners are vectorized when the host
+// supports it. The implementation is selected at startup by
+// querying the processor, and the portable (scalar) version
+// is always available.
+
+#include "beaker/prelude.hpp"
+
+
+namespace beaker
+{
+
+// The kinds of scanner implementations.
+enum Scan_mode
+{
+  scalar_scan, // One character at a time
+  sse2_scan,   // 16 characters at a time
+  avx2_scan,   // 32 characters at a time
+};
+
+
+char const* skip_space(char const*, char const*);
+char const* skip_identifier(char const*, char const*);
+char const* skip_digits(char const*, char const*);
+char const* find_newline(char const*, char const*);
+
+Scan_mode get_scan_mode();
+Scan_mode get_best_scan_mode();
+bool      set_scan_mode(Scan_mode);
+
+char const* get_spelling(Scan_mode);
+
+
+} // namespace beaker
+
+
+#endif
@@ -0,0 +1,232 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_SEQUENCE_HPP
+#define BEAKER_SEQUENCE_HPP
+
+// This module defines the small vector used to represent the
+// sequences of terms stored in other terms (e.g., the arguments
+// of a call or the statements of a block). Most sequences are
+// short, so the first few elements are stored within the vector
+// itself, and hence within the node that contains it. Longer
+// sequences spill into the current arena (see arena.hpp).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+namespace beaker
+{
+
+void* allocate_sequence(std::size_t, std::size_t);
+
+
+// A small vector stores up to N elements without allocating.
+// The element type must be trivial (in practice, a pointer),
+// so elements are copied as bytes and never destroyed.
+//
+// Storage for more elements is allocated in the current arena,
+// and is released with that arena, not by the vector, so a
+// small vector is trivially destructible. A vector that spills
+// must not outlive the arena that was current when it did. When a vector grows, its
+// previous storage is not reused, so growing by doubling wastes
+// no more than the final capacity.
+template<typename T, std::size_t N>
+struct Small_vector
+{
+  static_assert(std::is_trivial<T>::value, "element type must be trivial");
+  static_assert(N > 0, "inline capacity must be positive");
+
+  using value_type      = T;
+  using size_type       = std::size_t;
+  using reference       = T&;
+  using const_reference = T const&;
+  using iterator        = T*;
+  using const_iterator  = T const*;
+
+  Small_vector()
+    : data_(buf_), size_(0), cap_(N)
+  { }
+
+  template<typename I, typename = typename std::iterator_traits<I>::iterator_category>
+  Small_vector(I, I);
+
+  Small_vector(std::initializer_list<T> l)
+    : Small_vector(l.begin(), l.end())
+  { }
+
+  Small_vector(std::vector<T> const& v)
+    : Small_vector(v.begin(), v.end())
+  { }
+
+  Small_vector(Small_vector const& x)
+    : Small_vector(x.begin(), x.end())
+  { }
+
+  Small_vector(Small_vector&&);
+
+  Small_vector& operator=(Small_vector const&);
+  Small_vector& operator=(Small_vector&&);
+
+  // Observers
+  bool      empty() const    { return size_ == 0; }
+  size_type size() const     { return size_; }
+  size_type capacity() const { return cap_; }
+  bool      is_inline() const { return data_ == buf_; }
+
+  // Element access
+  T&       operator[](size_type n)       { return data_[n]; }
+  T const& operator[](size_type n) const { return data_[n]; }
+  T&       front()                       { return data_[0]; }
+  T const& front() const                 { return data_[0]; }
+  T&       back()                        { return data_[size_ - 1]; }
+  T const& back() const                  { return data_[size_ - 1]; }
+  T*       data()                        { return data_; }
+  T const* data() const                  { return data_; }
+
+  // Iterators
+  iterator       begin()       { return data_; }
+  iterator       end()         { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end() const   { return data_ + size_; }
+
+  // Modifiers
+  void reserve(size_type);
+  void push_back(T const& x);
+  void pop_back() { --size_; }
+  void clear()    { size_ = 0; }
+
+  void release();
+
+  T*        data_; // The first element
+  size_type size_; // The number of elements
+  size_type cap_;  // The capacity of data_
+  T         buf_[N];
+};
+
+
+template<typename T, std::size_t N>
+template<typename I, typename>
+inline
+Small_vector<T, N>::Small_vector(I first, I last)
+  : Small_vector()
+{
+  reserve(std::distance(first, last));
+  for (; first != last; ++first)
+    data_[size_++] = *first;
+}
+
+
+// Take the elements of `x`. When `x` has spilled into the
+// arena, its storage is taken. Otherwise, its elements are
+// copied.
+template<typename T, std::size_t N>
+inline
+Small_vector<T, N>::Small_vector(Small_vector&& x)
+  : Small_vector()
+{
+  *this = std::move(x);
+}
+
+
+template<typename T, std::size_t N>
+inline Small_vector<T, N>&
+Small_vector<T, N>::operator=(Small_vector const& x)
+{
+  if (this != &x) {
+    clear();
+    reserve(x.size_);
+    std::memcpy(data_, x.data_, x.size_ * sizeof(T));
+    size_ = x.size_;
+  }
+  return *this;
+}
+
+
+template<typename T, std::size_t N>
+inline Small_vector<T, N>&
+Small_vector<T, N>::operator=(Small_vector&& x)
+{
+  if (this == &x)
+    return *this;
+  if (x.is_inline()) {
+    clear();
+    std::memcpy(data_, x.data_, x.size_ * sizeof(T));
+    size_ = x.size_;
+  } else {
+    data_ = x.data_;
+    size_ = x.size_;
+    cap_ = x.cap_;
+    x.data_ = x.buf_;
+    x.cap_ = N;
+  }
+  x.size_ = 0;
+  return *this;
+}
+
+
+// Ensure that the vector can hold at least `n` elements.
+template<typename T, std::size_t N>
+inline void
+Small_vector<T, N>::reserve(size_type n)
+{
+  if (n <= cap_)
+    return;
+  T* p = static_cast<T*>(allocate_sequence(n * sizeof(T), alignof(T)));
+  std::memcpy(p, data_, size_ * sizeof(T));
+  data_ = p;
+  cap_ = n;
+}
+
+
+template<typename T, std::size_t N>
+inline void
+Small_vector<T, N>::push_back(T const& x)
+{
+  if (size_ == cap_) {
+    T y = x; // x may refer to an element
+    reserve(2 * cap_);
+    data_[size_++] = y;
+  } else {
+    data_[size_++] = x;
+  }
+}
+
+
+// Return to the inline storage, leaving the vector empty.
+template<typename T, std::size_t N>
+inline void
+Small_vector<T, N>::release()
+{
+  data_ = buf_;
+  size_ = 0;
+  cap_ = N;
+}
+
+
+template<typename T, std::size_t N>
+inline bool
+operator==(Small_vector<T, N> const& a, Small_vector<T, N> const& b)
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+
+template<typename T, std::size_t N>
+inline bool
+operator!=(Small_vector<T, N> const& a, Small_vector<T, N> const& b)
+{
+  return !(a == b);
+}
+
+
+} // namespace beaker
+
+
+#endif
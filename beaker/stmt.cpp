@@ -6,6 +6,8 @@
 #include "beaker/type.hpp"
 #include "beaker/stmt.hpp"
 #include "beaker/same.hpp"
+#include "beaker/arena.hpp"
+#include "beaker/diagnostic.hpp"
 
 namespace beaker
 {
@@ -38,21 +40,21 @@ Assignment_stmt::location() const
 Empty_stmt*
 make_empty_stmt(Location loc)
 {
-  return new Empty_stmt(loc);
+  return get_arena().make<Empty_stmt>(loc);
 }
 
 
 Declaration_stmt* 
 make_declaration_stmt(Decl const* d)
 {
-  return new Declaration_stmt(d);
+  return get_arena().make<Declaration_stmt>(d);
 }
 
 
 Expression_stmt* 
 make_expression_stmt(Location loc, Expr const* e)
 {
-  return new Expression_stmt(loc, e);
+  return get_arena().make<Expression_stmt>(loc, e);
 }
 
 
@@ -67,12 +69,12 @@ make_assignment_stmt(Location loc, Expr const* e1, Expr const* e2)
       Type const* t1 = get_expr_type(e1);
       Type const* t2 = get_expr_type(e2);
       if (!same(t1, t2)) {
-        error(e2->location(), "type mismatch in assigned value "
-                              "(expected '{}' but got '{}')",
-                              t1, t2);
+        diagnose(e2->location(), "type mismatch in assigned value "
+                                 "(expected '{}' but got '{}')",
+                                 t1, t2);
         return make_error_node<Assignment_stmt>();
       }
-      return new Assignment_stmt(loc, e1, e2);
+      return get_arena().make<Assignment_stmt>(loc, e1, e2);
     }
 
     // TODO: Can you assign to a function? Like this:
@@ -82,14 +84,14 @@ make_assignment_stmt(Location loc, Expr const* e1, Expr const* e2)
     //
     // That seems like a bit of stretch.
 
-    error(e1->location(), "assignment to non-object");
+    diagnose(e1->location(), "assignment to non-object");
     return make_error_node<Assignment_stmt>();
   } else {
     // TODO: Diagnose the span of the LHS?
     if (is_void_type(e1->type()))
-      error(e1->location(), "assignment to 'void'");
+      diagnose(e1->location(), "assignment to 'void'");
     else
-      error(e1->location(), "assignment to temporary");
+      diagnose(e1->location(), "assignment to temporary");
   }
   return make_error_node<Assignment_stmt>();
 }
@@ -99,13 +101,14 @@ make_assignment_stmt(Location loc, Expr const* e1, Expr const* e2)
 namespace
 {
 
-// Diagnose errors in a condition.
+// Diagnose errors in a condition. The value of a variable
+// may be used as a condition.
 bool
 check_condition(Expr const* e) 
 {
   // FIXME: Define and use the span to diagnose this error.
-  if (!is_boolean_type(e->type())) {
-    error(e->location(), "expression does not have type 'bool'");
+  if (!is_boolean_type(get_expr_type(e))) {
+    diagnose(e->location(), "expression does not have type 'bool'");
     return false;
   }
   return true;
@@ -120,7 +123,7 @@ make_if_then_stmt(Location loc, Expr const* e, Stmt const* s)
 {
   if (!check_condition(e))
     return make_error_node<If_then_stmt>();
-  return new If_then_stmt(loc, e, s);
+  return get_arena().make<If_then_stmt>(loc, e, s);
 }
 
 
@@ -129,7 +132,7 @@ make_if_else_stmt(Location l1, Location l2, Expr const* e, Stmt const* s1, Stmt
 {
   if (!check_condition(e))
     return make_error_node<If_else_stmt>();
-  return new If_else_stmt(l1, l2, e, s1, s2);
+  return get_arena().make<If_else_stmt>(l1, l2, e, s1, s2);
 }
 
 
@@ -138,7 +141,7 @@ make_while_stmt(Location loc, Expr const* e, Stmt const* s)
 {
   if (!check_condition(e))
     return make_error_node<While_stmt>();
-  return new While_stmt(loc, e, s);
+  return get_arena().make<While_stmt>(loc, e, s);
 }
 
 
@@ -147,28 +150,35 @@ make_do_stmt(Location l1, Location l2, Expr const* e, Stmt const* s)
 {
   if (!check_condition(e))
     return make_error_node<Do_stmt>();
-  return new Do_stmt(l1, l2, e, s);
+  return get_arena().make<Do_stmt>(l1, l2, e, s);
 }
 
 
 Exit_stmt*
 make_exit_stmt(Location l1, Location l2)
 {
-  return new Exit_stmt(l1, l2);
+  return get_arena().make<Exit_stmt>(l1, l2);
 }
 
 
 Return_stmt*
 make_return_stmt(Location l1, Location l2, Expr const* e)
 {
-  return new Return_stmt(l1, l2, e);
+  return get_arena().make<Return_stmt>(l1, l2, e);
 }
 
 
 Block_stmt* 
 make_block_stmt(Location l1, Location l2, Stmt_seq const& seq)
 {
-  return new Block_stmt(l1, l2, seq);
+  return get_arena().make<Block_stmt>(l1, l2, seq);
+}
+
+
+Block_stmt* 
+make_block_stmt(Location l1, Location l2, Stmt_seq&& seq)
+{
+  return get_arena().make<Block_stmt>(l1, l2, std::move(seq));
 }
 
 
@@ -18,20 +18,44 @@ namespace beaker
 struct Stmt_visitor;
 
 
+// The kinds of statements.
+enum Stmt_kind
+{
+  empty_stmt_kind,
+  declaration_stmt_kind,
+  expression_stmt_kind,
+  assignment_stmt_kind,
+  if_then_stmt_kind,
+  if_else_stmt_kind,
+  while_stmt_kind,
+  do_stmt_kind,
+  exit_stmt_kind,
+  return_stmt_kind,
+  block_stmt_kind,
+};
+
+
 // The base class of all statements in the language. A statement 
 // contains a declaration, an expression, or it represents a
 // form of flow control.
 struct Stmt
 {
+  Stmt(Stmt_kind k)
+    : kind_(k)
+  { }
+
   virtual ~Stmt() { }
 
-  String node_name() const;
+  String    node_name() const;
+  Stmt_kind kind() const { return kind_; }
 
   // Accept a statement visitor.
   virtual void accept(Stmt_visitor&) const = 0;
   
   // Returns the source location where the statement begins.
   virtual Location location() const = 0;
+
+  Stmt_kind kind_;
 };
 
 
@@ -54,8 +78,10 @@ struct Stmt_visitor
 // The empty statement invokes no commands.
 struct Empty_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = empty_stmt_kind;
+
   Empty_stmt(Location loc)
-    : loc_(loc)
+    : Stmt(node_kind), loc_(loc)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -69,8 +95,10 @@ struct Empty_stmt : Stmt
 // A declaration statement contains a declaration.
 struct Declaration_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = declaration_stmt_kind;
+
   Declaration_stmt(Decl const* d)
-    : first(d)
+    : Stmt(node_kind), first(d)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -88,8 +116,10 @@ struct Declaration_stmt : Stmt
 // may save the result in a log file (or terminal).
 struct Expression_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = expression_stmt_kind;
+
   Expression_stmt(Location l, Expr const* e)
-    : loc_(l), first(e)
+    : Stmt(node_kind), loc_(l), first(e)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -107,8 +137,10 @@ struct Expression_stmt : Stmt
 /* Represents an assignment statement. */
 struct Assignment_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = assignment_stmt_kind;
+
   Assignment_stmt(Location loc, Expr const* l, Expr const* r)
-    : loc_(loc), first(l), second(r)
+    : Stmt(node_kind), loc_(loc), first(l), second(r)
   { }
   
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -127,8 +159,10 @@ struct Assignment_stmt : Stmt
 
 struct If_then_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = if_then_stmt_kind;
+
   If_then_stmt(Location loc, Expr const* c, Stmt const* b)
-    : loc_(loc), first(c), second(b)
+    : Stmt(node_kind), loc_(loc), first(c), second(b)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -145,8 +179,10 @@ struct If_then_stmt : Stmt
 
 struct If_else_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = if_else_stmt_kind;
+
   If_else_stmt(Location l1, Location l2, Expr const* c, Stmt const* t, Stmt const* f)
-    : if_(l1), else_(l2), first(c), second(t), third(f)
+    : Stmt(node_kind), if_(l1), else_(l2), first(c), second(t), third(f)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -170,8 +206,10 @@ struct If_else_stmt : Stmt
 // Represents a while-statement.
 struct While_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = while_stmt_kind;
+
   While_stmt(Location loc, Expr const* c, Stmt const* b)
-    : loc_(loc), first(c), second(b)
+    : Stmt(node_kind), loc_(loc), first(c), second(b)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -189,8 +227,10 @@ struct While_stmt : Stmt
 // Represents a do-while-statement.
 struct Do_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = do_stmt_kind;
+
   Do_stmt(Location l1, Location l2, Expr const* c, Stmt const* b)
-    : do_(l1), while_(l2), first(c), second(b)
+    : Stmt(node_kind), do_(l1), while_(l2), first(c), second(b)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -213,8 +253,10 @@ struct Do_stmt : Stmt
 // value. Note that this is only valid for void functions.
 struct Exit_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = exit_stmt_kind;
+
   Exit_stmt(Location l1, Location l2)
-    : ret_(l1), semi_(l2)
+    : Stmt(node_kind), ret_(l1), semi_(l2)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -233,8 +275,10 @@ struct Exit_stmt : Stmt
 // context.
 struct Return_stmt : Stmt
 {
+  static constexpr Stmt_kind node_kind = return_stmt_kind;
+
   Return_stmt(Location l1, Location l2, Expr const* e)
-    : ret_(l1), semi_(l2), first(e)
+    : Stmt(node_kind), ret_(l1), semi_(l2), first(e)
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -254,9 +298,14 @@ struct Return_stmt : Stmt
 // A block statement is a sequence of statements. 
 struct Block_stmt : Stmt
 {
-  // TODO: Support move semantics for the statement sequence.
+  static constexpr Stmt_kind node_kind = block_stmt_kind;
+
   Block_stmt(Location l1, Location l2, Stmt_seq const& s)
-    : open_(l1), close_(l2), first(s)
+    : Stmt(node_kind), open_(l1), close_(l2), first(s)
+  { }
+
+  Block_stmt(Location l1, Location l2, Stmt_seq&& s)
+    : Stmt(node_kind), open_(l1), close_(l2), first(std::move(s))
   { }
 
   void accept(Stmt_visitor& v) const { v.visit(this); }
@@ -287,6 +336,7 @@ Do_stmt*          make_do_stmt(Location, Location, Expr const*, Stmt const*);
 Exit_stmt*        make_exit_stmt(Location, Location);
 Return_stmt*      make_return_stmt(Location, Location, Expr const*);
 Block_stmt*       make_block_stmt(Location, Location, Stmt_seq const&);
+Block_stmt*       make_block_stmt(Location, Location, Stmt_seq&&);
 
 
 inline Empty_stmt*
@@ -341,16 +391,57 @@ struct Generic_stmt_visitor : Stmt_visitor, Generic_visitor<F, T>
 };
 
 
-// Apply the function f to the statement s.
+// Apply the function f to the statement s using the virtual
+// visitor. The return type is that of the function object F.
 template<typename F, typename T = typename std::result_of<F(Empty_stmt*)>::type>
 inline T
-apply(Stmt const* s, F fn)
+apply_visitor(Stmt const* s, F fn)
 {
   Generic_stmt_visitor<F, T> v(fn);
   return accept(s, v);
 }
 
 
+// Apply the function f to the statement s. This dispatches on
+// the kind of s, which allows calls to f to be inlined. When
+// BEAKER_VIRTUAL_DISPATCH is defined, this uses the virtual
+// visitor instead.
+template<typename F, typename T = typename std::result_of<F(Empty_stmt*)>::type>
+inline T
+apply(Stmt const* s, F fn)
+{
+#ifdef BEAKER_VIRTUAL_DISPATCH
+  return apply_visitor<F, T>(s, fn);
+#else
+  switch (s->kind()) {
+  case empty_stmt_kind:
+    return fn(static_cast<Empty_stmt const*>(s));
+  case declaration_stmt_kind:
+    return fn(static_cast<Declaration_stmt const*>(s));
+  case expression_stmt_kind:
+    return fn(static_cast<Expression_stmt const*>(s));
+  case assignment_stmt_kind:
+    return fn(static_cast<Assignment_stmt const*>(s));
+  case if_then_stmt_kind:
+    return fn(static_cast<If_then_stmt const*>(s));
+  case if_else_stmt_kind:
+    return fn(static_cast<If_else_stmt const*>(s));
+  case while_stmt_kind:
+    return fn(static_cast<While_stmt const*>(s));
+  case do_stmt_kind:
+    return fn(static_cast<Do_stmt const*>(s));
+  case exit_stmt_kind:
+    return fn(static_cast<Exit_stmt const*>(s));
+  case return_stmt_kind:
+    return fn(static_cast<Return_stmt const*>(s));
+  case block_stmt_kind:
+    return fn(static_cast<Block_stmt const*>(s));
+  }
+  lingo_unreachable();
+#endif
+}
+
+
 } // namespace beaker
 
 #endif
@@ -0,0 +1,90 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/thread.hpp"
+
+
+namespace beaker
+{
+
+// Create a pool with `n` worker threads.
+Thread_pool::Thread_pool(int n)
+  : active_(0), done_(false)
+{
+  for (int i = 0; i < n; ++i)
+    threads_.emplace_back(&Thread_pool::work, this);
+}
+
+
+// Wait for all submitted tasks to complete and join the
+// worker threads.
+Thread_pool::~Thread_pool()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  ready_.notify_all();
+  for (std::thread& t : threads_)
+    t.join();
+}
+
+
+// Returns the number of hardware threads, or 1 if that
+// cannot be determined.
+int
+Thread_pool::default_size()
+{
+  int n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+
+// Schedule the task `t` to run on some worker thread.
+void
+Thread_pool::submit(Task t)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(t));
+    ++active_;
+  }
+  ready_.notify_one();
+}
+
+
+// Block until all submitted tasks have completed.
+void
+Thread_pool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return active_ == 0; });
+}
+
+
+// Run tasks until the pool is destroyed. Pending tasks are
+// run before the worker exits.
+void
+Thread_pool::work()
+{
+  while (true) {
+    Task t;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this]() { return done_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return;
+      t = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    t();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (--active_ == 0)
+        idle_.notify_all();
+    }
+  }
+}
+
+
+} // namespace beaker
@@ -0,0 +1,60 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_THREAD_HPP
+#define BEAKER_THREAD_HPP
+
+// The thread module provides a simple pool of worker threads
+// for running independent tasks in parallel.
+
+#include "beaker/prelude.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace beaker
+{
+
+// A thread pool runs submitted tasks on a fixed set of worker
+// threads. Tasks are run in the order they are submitted, but
+// may complete in any order. Use wait() to block until all
+// submitted tasks have completed.
+//
+// Tasks must not throw exceptions.
+struct Thread_pool
+{
+  using Task = std::function<void()>;
+
+  explicit Thread_pool(int = default_size());
+  ~Thread_pool();
+
+  Thread_pool(Thread_pool const&) = delete;
+  Thread_pool& operator=(Thread_pool const&) = delete;
+
+  int size() const { return threads_.size(); }
+
+  void submit(Task);
+  void wait();
+
+  static int default_size();
+
+  void work();
+
+  std::vector<std::thread> threads_;
+  std::deque<Task>         tasks_;   // Pending tasks
+  int                      active_;  // Submitted but incomplete tasks
+  bool                     done_;    // True when shutting down
+  std::mutex               mutex_;
+  std::condition_variable  ready_;   // Signals a new task
+  std::condition_variable  idle_;    // Signals that all tasks are done
+};
+
+
+} // namespace beaker
+
+
+#endif
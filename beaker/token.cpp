@@ -2,16 +2,194 @@
 // All rights reserved
 
 #include "beaker/token.hpp"
+#include "beaker/context.hpp"
+
+#include <cstring>
+#include <limits>
+#include <mutex>
 
 
 namespace beaker
 {
 
+// -------------------------------------------------------------------------- //
+//                              Keywords
+//
+// Keywords (including the boolean literals) are recognized
+// using a perfect hash over their spellings. Because the set
+// of keywords is fixed, the hash function was chosen so that
+// no two keywords share a slot in the table. Classifying an
+// identifier requires a hash of its length and first and last
+// characters, a probe, and a comparison against the single
+// candidate in that slot.
+
+namespace
+{
+
+constexpr std::size_t keyword_table_size = 16;
+constexpr std::size_t min_keyword_length = 2;
+constexpr std::size_t max_keyword_length = 6;
+
+
+constexpr std::size_t
+hash_keyword(char const* s, std::size_t n)
+{
+  return (n + (unsigned char)s[0] + 6 * (unsigned char)s[n - 1]) % keyword_table_size;
+}
+
+
+// The spelling of the keyword in each slot of the table.
+constexpr char const* keyword_spellings[keyword_table_size] {
+  "do",     nullptr,  "void",   nullptr,
+  "int",    "var",    "true",   "else",
+  nullptr,  "false",  "while",  "def",
+  "return", nullptr,  "bool",   "if"
+};
+
+
+constexpr bool
+same_spelling(char const* a, char const* b)
+{
+  return *a == *b && (*a == 0 || same_spelling(a + 1, b + 1));
+}
+
+
+// Returns true if `s` hashes to the slot holding its spelling.
+constexpr bool
+is_perfect(char const* s, std::size_t n)
+{
+  return keyword_spellings[hash_keyword(s, n)]
+      && same_spelling(keyword_spellings[hash_keyword(s, n)], s);
+}
+
+
+static_assert(is_perfect("bool", 4),   "keyword hash collision");
+static_assert(is_perfect("def", 3),    "keyword hash collision");
+static_assert(is_perfect("do", 2),     "keyword hash collision");
+static_assert(is_perfect("else", 4),   "keyword hash collision");
+static_assert(is_perfect("false", 5),  "keyword hash collision");
+static_assert(is_perfect("if", 2),     "keyword hash collision");
+static_assert(is_perfect("int", 3),    "keyword hash collision");
+static_assert(is_perfect("return", 6), "keyword hash collision");
+static_assert(is_perfect("true", 4),   "keyword hash collision");
+static_assert(is_perfect("var", 3),    "keyword hash collision");
+static_assert(is_perfect("void", 4),   "keyword hash collision");
+static_assert(is_perfect("while", 5),  "keyword hash collision");
+
+
+// The symbol for the keyword in each slot of the table. This
+// is populated by init_tokens().
+Symbol const* keyword_symbols[keyword_table_size];
+
+
+// The symbol for `true`.
+Symbol const* true_symbol;
+
+
+// Guards lingo's symbol table.
+std::mutex symbol_mutex_;
+
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+//                              Symbol tables
+
+// The first ids are reserved for the slots of the keyword
+// table, whose symbols are not stored in the symbol table.
+Symbol_table::Symbol_table()
+  : syms_(keyword_table_size, nullptr)
+{ }
+
+
+// Returns the id of the symbol spelled by the characters in
+// [first, last), interning it if needed. If the symbol is new,
+// its token kind is `k`. Note that `k` is ignored for symbols
+// that already have a token kind (e.g., punctuators and keywords).
+std::uint32_t
+Symbol_table::intern(char const* first, char const* last, int k)
+{
+  auto iter = cache_.find(Spelling{first, std::size_t(last - first)});
+  if (iter != cache_.end())
+    return iter->second;
+
+  int kw = get_keyword_id(first, last);
+  if (kw >= 0)
+    return kw;
+
+  Symbol const* sym;
+  {
+    std::lock_guard<std::mutex> lock(symbol_mutex_);
+    sym = &get_symbol(first, last, k);
+  }
+  std::uint32_t n = syms_.size();
+  cache_.insert({Spelling{sym->str.data(), sym->str.size()}, n});
+  syms_.push_back(sym);
+  return n;
+}
+
+
+// Returns the symbol with the id `n`.
+Symbol const&
+Symbol_table::symbol(std::uint32_t n) const
+{
+  if (n < keyword_table_size)
+    return *keyword_symbols[n];
+  return *syms_[n];
+}
+
+
+// Returns the id of the keyword spelled by the characters in
+// [first, last) or -1 if those characters do not spell a keyword.
+int
+get_keyword_id(char const* first, char const* last)
+{
+  std::size_t n = last - first;
+  if (n < min_keyword_length || n > max_keyword_length)
+    return -1;
+  std::size_t k = hash_keyword(first, n);
+  Symbol const* sym = keyword_symbols[k];
+  if (sym && sym->str.size() == n && !std::memcmp(sym->str.data(), first, n))
+    return k;
+  return -1;
+}
+
+
+// Returns the symbol for the keyword spelled by the characters
+// in [first, last) or nullptr if those characters do not spell
+// a keyword.
+Symbol const*
+get_keyword(char const* first, char const* last)
+{
+  int k = get_keyword_id(first, last);
+  return k < 0 ? nullptr : keyword_symbols[k];
+}
+
+
+// Returns the symbol spelled by [first, last) in the current
+// compilation, where `k` is the token kind of a new symbol.
+Symbol const&
+intern_symbol(char const* first, char const* last, int k)
+{
+  Symbol_table& syms = current_context().symbols;
+  return syms.symbol(syms.intern(first, last, k));
+}
+
+
+// Returns the symbol with the given id.
+Symbol const&
+get_symbol_by_id(std::uint32_t n)
+{
+  return current_context().symbols.symbol(n);
+}
+
+
 // Returns an identifer.
 String const*
 get_identifier(char const* str)
 {
-  return &lingo::get_symbol(str, identifier_tok).str;
+  return &intern_symbol(str, str + std::strlen(str), identifier_tok).str;
 }
 
 
@@ -19,11 +197,12 @@ get_identifier(char const* str)
 String const*
 get_identifier(String const& str)
 {
-  return &lingo::get_symbol(str, identifier_tok).str;
+  return &intern_symbol(str.data(), str.data() + str.size(), identifier_tok).str;
 }
 
 
-// Initialize language tokens.
+// Initialize language tokens. This must be called before
+// any compilation begins.
 void
 init_tokens()
 {
@@ -80,23 +259,85 @@ init_tokens()
   // TODO: We probably want a way of registering the
   // spelling of token names without values (e.g., integers,
   // booleans, and identifiers).
-  get_symbol("true", boolean_tok);
+  true_symbol = &get_symbol("true", boolean_tok);
   get_symbol("false", boolean_tok);
+
+  // Populate the keyword table.
+  for (char const* str : keyword_spellings) {
+    if (str)
+      keyword_symbols[hash_keyword(str, std::strlen(str))] = &get_symbol(str);
+  }
 }
 
 Value
 as_bool(Token const& tok)
 {
   lingo_assert(tok.kind() == boolean_tok);
-  return tok.symbol() == get_symbol("true");
+  return &tok.symbol() == true_symbol;
 }
 
 
+// Returns the value of an integer literal, or -1 if that value
+// is not representable as a Value. Note that the parser uses
+// the value computed by the lexer (see Token_buffer).
 Value
 as_int(Token const& tok)
 {
   lingo_assert(tok.kind() == integer_tok);
-  return std::stol(*tok.str());
+  String const& s = tok.symbol().str;
+  return to_integer(s.data(), s.data() + s.size());
+}
+
+
+// -------------------------------------------------------------------------- //
+//                            Integer literals
+//
+// The value of each integer literal is computed by the lexer,
+// directly from the source text, and stored with its token.
+
+namespace
+{
+
+// Returns the value of the digit `c`, which is valid in
+// the given base.
+inline int
+digit_value(char c)
+{
+  if (c <= '9')
+    return c - '0';
+  return (c | 0x20) - 'a' + 10;
+}
+
+
+} // namespace
+
+
+// Returns the value of the integer literal spelled by the
+// characters in [first, last). A literal with the prefix 0x
+// or 0b is hexadecimal or binary, respectively. Returns -1 if
+// the value cannot be represented.
+Value
+to_integer(char const* first, char const* last)
+{
+  int base = 10;
+  if (last - first > 2 && first[0] == '0') {
+    if ((first[1] | 0x20) == 'x')
+      base = 16;
+    else if ((first[1] | 0x20) == 'b')
+      base = 2;
+    if (base != 10)
+      first += 2;
+  }
+
+  constexpr Value max = std::numeric_limits<Value>::max();
+  Value n = 0;
+  for (; first != last; ++first) {
+    int d = digit_value(*first);
+    if (n > (max - d) / base)
+      return -1;
+    n = n * base + d;
+  }
+  return n;
 }
 
 
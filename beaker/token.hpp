@@ -11,6 +11,12 @@
 
 #include "lingo/token.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
 namespace beaker
 {
 
@@ -74,15 +80,174 @@ enum Token_kind
 };
 
 
+int           get_keyword_id(char const*, char const*);
+Symbol const* get_keyword(char const*, char const*);
+Symbol const& intern_symbol(char const*, char const*, int);
+
+Symbol const& get_symbol_by_id(std::uint32_t);
+
 String const* get_identifier(char const*);
 String const* get_identifier(String const&);
 
 Value as_bool(Token const&);
 Value as_int(Token const&);
+Value to_integer(char const*, char const*);
 
 void init_tokens();
 
 
+// -------------------------------------------------------------------------- //
+//                              Symbol tables
+
+// The spelling of a token, referring to the source text.
+struct Spelling
+{
+  char const* first;
+  std::size_t size;
+};
+
+
+inline bool
+operator==(Spelling a, Spelling b)
+{
+  return a.size == b.size && !std::memcmp(a.first, b.first, a.size);
+}
+
+
+// FNV-1a hash of a spelling.
+struct Spelling_hash
+{
+  std::size_t operator()(Spelling s) const
+  {
+    std::size_t h = 2166136261u;
+    for (std::size_t i = 0; i < s.size; ++i)
+      h = (h ^ (unsigned char)s.first[i]) * 16777619u;
+    return h;
+  }
+};
+
+
+// A symbol table holds the symbol information of a single
+// compilation (see context.hpp).
+//
+// Symbols themselves are interned in lingo's symbol table,
+// which is shared by all compilations. Access to that table
+// is synchronized, so each symbol table caches the symbols
+// it has seen and interns only spellings that are new to the
+// compilation. The cache is keyed by the spelling of the
+// symbol, not of the source text, so it outlives the buffers
+// from which symbols were lexed.
+//
+// Each symbol is assigned a dense integer id when it is
+// interned, which is stored in the cache with the symbol.
+// The ids of keywords are their slots in the keyword table
+// and are the same in every compilation.
+struct Symbol_table
+{
+  Symbol_table();
+
+  std::uint32_t intern(char const*, char const*, int);
+  Symbol const& symbol(std::uint32_t) const;
+
+  using Cache = std::unordered_map<Spelling, std::uint32_t, Spelling_hash>;
+
+  Cache                      cache_;
+  std::vector<Symbol const*> syms_;
+};
+
+
+// -------------------------------------------------------------------------- //
+//                              Token buffers
+
+// A token buffer is a compact sequence of tokens from a single
+// source buffer. Rather than storing an array of tokens, each
+// attribute of the token is stored in a separate array: a one
+// byte kind, the offset of the token in the source buffer, and
+// an index identifying the token's symbol. Scanning the kinds
+// of tokens (e.g., in lookahead) touches only the kind array.
+// The values of integer literals, which are computed by the
+// lexer, are stored in order in a separate array, so the kth
+// integer literal in the buffer has the kth value.
+//
+// Tokens and their locations are reconstructed as needed.
+struct Token_buffer
+{
+  Token_buffer(Buffer const& b)
+    : buf_(&b)
+  { }
+
+  std::size_t size() const  { return kinds_.size(); }
+  bool        empty() const { return kinds_.empty(); }
+
+  int           kind(std::size_t n) const   { return kinds_[n]; }
+  Location      location(std::size_t n) const { return Location(buf_, offsets_[n]); }
+  Symbol const& symbol(std::size_t n) const { return get_symbol_by_id(syms_[n]); }
+  Token         token(std::size_t n) const  { return Token(location(n), kind(n), symbol(n)); }
+  Value         integer(std::size_t k) const { return ints_[k]; }
+
+  void push_back(Token const&, std::uint32_t, Value = 0);
+  void erase(std::size_t);
+  void clear();
+
+  std::size_t bytes() const;
+
+  Buffer const*              buf_;     // The source buffer
+  std::vector<std::uint8_t>  kinds_;   // Token kinds
+  std::vector<std::uint32_t> offsets_; // Source offsets
+  std::vector<std::uint32_t> syms_;    // Symbol ids
+  std::vector<Value>         ints_;    // Values of integer literals
+};
+
+
+// Append the token `tok`, whose symbol has the id `id`, to
+// the buffer. If the token is an integer literal, `v` is its
+// value.
+inline void
+Token_buffer::push_back(Token const& tok, std::uint32_t id, Value v)
+{
+  static_assert(integer_tok < 256, "token kinds do not fit in a byte");
+  lingo_assert(0 <= tok.kind());
+  kinds_.push_back(tok.kind());
+  offsets_.push_back(tok.location().offset());
+  syms_.push_back(id);
+  if (tok.kind() == integer_tok)
+    ints_.push_back(v);
+}
+
+
+// Remove the first `n` tokens from the buffer.
+inline void
+Token_buffer::erase(std::size_t n)
+{
+  std::size_t k = std::count(kinds_.begin(), kinds_.begin() + n, integer_tok);
+  kinds_.erase(kinds_.begin(), kinds_.begin() + n);
+  offsets_.erase(offsets_.begin(), offsets_.begin() + n);
+  syms_.erase(syms_.begin(), syms_.begin() + n);
+  ints_.erase(ints_.begin(), ints_.begin() + k);
+}
+
+
+inline void
+Token_buffer::clear()
+{
+  kinds_.clear();
+  offsets_.clear();
+  syms_.clear();
+  ints_.clear();
+}
+
+
+// Returns the number of bytes allocated for the buffer.
+inline std::size_t
+Token_buffer::bytes() const
+{
+  return kinds_.capacity() * sizeof(std::uint8_t)
+       + offsets_.capacity() * sizeof(std::uint32_t)
+       + syms_.capacity() * sizeof(std::uint32_t)
+       + ints_.capacity() * sizeof(Value);
+}
+
+
 } // namespace beaker
 
 
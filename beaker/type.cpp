@@ -4,45 +4,147 @@
 #include "beaker/type.hpp"
 #include "beaker/expr.hpp"
 #include "beaker/decl.hpp"
-#include "beaker/less.hpp"
+#include "beaker/hash.hpp"
+#include "beaker/context.hpp"
+#include "beaker/diagnostic.hpp"
+#include "beaker/arena.hpp"
 
-#include "lingo/memory.hpp"
+#include <deque>
+#include <mutex>
 
 
 namespace beaker
 {
 
 // -------------------------------------------------------------------------- //
-//                             Type accessors
+//                              Type tables
 
-// Global types.
+// Global types. The function and reference types are interned
+// in the global type table, and cached by the type table of each
+// compilation.
 namespace
 {
 
-// Compares type values.
-struct Type_less
+Void_type void_;
+Boolean_type bool_;
+Integer_type int_;
+
+
+// The function and reference types of all compilations, which
+// are never released. The parameter types of function types
+// are stored in the table's arena.
+struct Global_types
 {
-  bool operator()(Type const& a, Type const& b) const
-  {
-    return less(&a, &b);
-  }
+  std::mutex                 mutex;
+  Type_table                 index;
+  std::deque<Function_type>  functions;
+  std::deque<Reference_type> references;
+  Arena                      arena;
 };
 
 
-// Canonicalizing factories.
-using Function_types = Unique_factory<Function_type, Type_less> ;
-using Reference_types = Unique_factory<Reference_type, Type_less> ;
+Global_types&
+global_types()
+{
+  static Global_types types;
+  return types;
+}
 
 
-Void_type void_;
-Boolean_type bool_;
-Integer_type int_;
-Function_types fn_;
-Reference_types ref_;
+// Returns the hash of the function type with parameter types
+// `t` and return type `r`.
+std::size_t
+hash_function_type(Type_seq const& t, Type const* r)
+{
+  std::size_t h = hash_value(r);
+  for (Type const* p : t)
+    h = hash_combine(h, hash_value(p));
+  return h;
+}
+
+
+// Returns the function type with hash `h`, parameter types `t`,
+// and return type `r` in the index, or nullptr if there is none.
+Function_type const*
+find_function_type(Type_table const& tab, std::size_t h, Type_seq const& t, Type const* r)
+{
+  auto range = tab.functions.equal_range(h);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    Function_type const* f = iter->second;
+    if (f->return_type() == r && f->parameter_types() == t)
+      return f;
+  }
+  return nullptr;
+}
+
+
+// Returns the reference to `t` in the index, or nullptr if
+// there is none.
+Reference_type const*
+find_reference_type(Type_table const& tab, Type const* t)
+{
+  auto iter = tab.references.find(t);
+  return iter != tab.references.end() ? iter->second : nullptr;
+}
 
 } // namespace
 
 
+// Returns the unique function type with parameter types `t`
+// and return type `r`.
+Function_type const*
+Type_table::function(Type_seq const& t, Type const* r)
+{
+  std::size_t h = hash_function_type(t, r);
+  if (Function_type const* f = find_function_type(*this, h, t, r))
+    return f;
+
+  Global_types& g = global_types();
+  Function_type const* f;
+  {
+    std::lock_guard<std::mutex> lock(g.mutex);
+    f = find_function_type(g.index, h, t, r);
+    if (!f) {
+      Use_arena use(g.arena);
+      g.functions.emplace_back(t, r);
+      f = &g.functions.back();
+      g.index.functions.insert({h, f});
+    }
+  }
+  functions.insert({h, f});
+  return f;
+}
+
+
+// Returns the unique reference to the type `t`. The index is
+// searched before inserting, since inserting allocates a node
+// even when the type is found.
+Reference_type const*
+Type_table::reference(Type const* t)
+{
+  if (Reference_type const* r = find_reference_type(*this, t))
+    return r;
+
+  Global_types& g = global_types();
+  Reference_type const* r;
+  {
+    std::lock_guard<std::mutex> lock(g.mutex);
+    r = find_reference_type(g.index, t);
+    if (!r) {
+      g.references.emplace_back(t);
+      r = &g.references.back();
+      g.index.references.insert({t, r});
+    }
+  }
+  references.insert({t, r});
+  return r;
+}
+
+
+// -------------------------------------------------------------------------- //
+//                             Type accessors
+
+
 Void_type const*
 get_void_type()
 {
@@ -67,7 +169,7 @@ get_int_type()
 Function_type const*
 get_function_type(Type_seq const& t, Type const* r)
 {
-  return fn_.make(t, r);
+  return current_context().types.function(t, r);
 }
 
 
@@ -87,7 +189,7 @@ get_parameter_types(Decl_seq const& p)
 Function_type const*
 get_function_type(Decl_seq const& d, Type const* r)
 {
-  return fn_.make(get_parameter_types(d), r);
+  return current_context().types.function(get_parameter_types(d), r);
 }
 
 
@@ -97,7 +199,7 @@ get_reference_type(Type const* t)
 {
   // If T is non-void, T& is a reference type.
   if (is_void_type(t)) {
-    error("forming a reference to 'void'");
+    diagnose("forming a reference to 'void'");
     return make_error_node<Reference_type>();
   }
 
@@ -105,7 +207,7 @@ get_reference_type(Type const* t)
   if (Reference_type const* t1 = as<Reference_type>(t))
     return t1;
 
-  return ref_.make(t);
+  return current_context().types.reference(t);
 }
 
 
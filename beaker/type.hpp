@@ -8,6 +8,8 @@
 
 #include "lingo/node.hpp"
 
+#include <unordered_map>
+
 
 namespace beaker
 {
@@ -18,13 +20,33 @@ struct Type_visitor;
 // -------------------------------------------------------------------------- //
 //                                Types
 
+// The kinds of types. Each type stores its kind so that
+// types can be distinguished without RTTI.
+enum Type_kind
+{
+  void_type_kind,
+  boolean_type_kind,
+  integer_type_kind,
+  function_type_kind,
+  reference_type_kind,
+};
+
+
 // The Type class represents the set of all types defined
 // by and definable within the cmin language.
 struct Type
 {
+  Type(Type_kind k)
+    : kind_(k)
+  { }
+
   virtual ~Type() { }
 
   virtual void accept(Type_visitor&) const = 0;
+
+  Type_kind kind() const { return kind_; }
+
+  Type_kind kind_;
 };
 
 
@@ -42,6 +64,12 @@ struct Type_visitor
 // The type of boolean values.
 struct Void_type : Type
 {
+  static constexpr Type_kind node_kind = void_type_kind;
+
+  Void_type()
+    : Type(node_kind)
+  { }
+
   void accept(Type_visitor& v) const { v.visit(this); }
 };
 
@@ -49,6 +77,12 @@ struct Void_type : Type
 // The type of boolean values.
 struct Boolean_type : Type
 {
+  static constexpr Type_kind node_kind = boolean_type_kind;
+
+  Boolean_type()
+    : Type(node_kind)
+  { }
+
   void accept(Type_visitor& v) const { v.visit(this); }
 };
 
@@ -61,8 +95,10 @@ struct Boolean_type : Type
 // by configuration.
 struct Integer_type : Type
 {
+  static constexpr Type_kind node_kind = integer_type_kind;
+
   Integer_type()
-    : prec_(32)
+    : Type(node_kind), prec_(32)
   { }
 
   void accept(Type_visitor& v) const { v.visit(this); }
@@ -77,8 +113,10 @@ struct Integer_type : Type
 // input types to an output type.
 struct Function_type : Type
 {
+  static constexpr Type_kind node_kind = function_type_kind;
+
   Function_type(Type_seq const& a, Type const* r)
-    : first(a), second(r)
+    : Type(node_kind), first(a), second(r)
   { }
 
   void accept(Type_visitor& v) const { v.visit(this); }
@@ -94,8 +132,10 @@ struct Function_type : Type
 // A reference to an object of a given type.
 struct Reference_type : Type
 {
+  static constexpr Type_kind node_kind = reference_type_kind;
+
   Reference_type(Type const* t)
-    : first(t)
+    : Type(node_kind), first(t)
   { }
 
   void accept(Type_visitor& v) const { v.visit(this); }
@@ -106,6 +146,36 @@ struct Reference_type : Type
 };
 
 
+// -------------------------------------------------------------------------- //
+//                              Type tables
+//
+// Function and reference types are interned in hash tables
+// keyed by the addresses of their component types. Because the
+// components are themselves canonical, a type can be found
+// without visiting its structure, and two types are the same
+// exactly when they have the same address.
+//
+// Types are interned in a global table that is shared by all
+// compilations, so types can be compared across compilations,
+// and a type outlives the compilation that created it. Access
+// to that table is synchronized, so each compilation has a
+// type table that caches the types it has seen, and consults
+// the global table only for types that are new to it (see
+// context.hpp). The void, boolean, and integer types are
+// shared by all compilations.
+
+
+// The function and reference types seen by a compilation.
+struct Type_table
+{
+  Function_type const*  function(Type_seq const&, Type const*);
+  Reference_type const* reference(Type const*);
+
+  std::unordered_multimap<std::size_t, Function_type const*> functions;
+  std::unordered_map<Type const*, Reference_type const*>      references;
+};
+
+
 // -------------------------------------------------------------------------- //
 //                               Queries
 
@@ -189,17 +259,45 @@ struct Generic_type_visitor : Type_visitor, Generic_visitor<F, T>
 };
 
 
-// Apply the function f to the type t.
-// The return type is that of the function object F.
+// Apply the function f to the type t using the virtual
+// visitor. The return type is that of the function object F.
 template<typename F, typename T = typename std::result_of<F(Void_type*)>::type>
 inline T
-apply(Type const* t, F fn)
+apply_visitor(Type const* t, F fn)
 {
   Generic_type_visitor<F, T> v(fn);
   return accept(t, v);
 }
 
 
+// Apply the function f to the type t. This dispatches on
+// the kind of t, which allows calls to f to be inlined. When
+// BEAKER_VIRTUAL_DISPATCH is defined, this uses the virtual
+// visitor instead.
+template<typename F, typename T = typename std::result_of<F(Void_type*)>::type>
+inline T
+apply(Type const* t, F fn)
+{
+#ifdef BEAKER_VIRTUAL_DISPATCH
+  return apply_visitor<F, T>(t, fn);
+#else
+  switch (t->kind()) {
+  case void_type_kind:
+    return fn(static_cast<Void_type const*>(t));
+  case boolean_type_kind:
+    return fn(static_cast<Boolean_type const*>(t));
+  case integer_type_kind:
+    return fn(static_cast<Integer_type const*>(t));
+  case function_type_kind:
+    return fn(static_cast<Function_type const*>(t));
+  case reference_type_kind:
+    return fn(static_cast<Reference_type const*>(t));
+  }
+  lingo_unreachable();
+#endif
+}
+
+
 } // namespace beaker
 
 
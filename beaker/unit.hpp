@@ -8,9 +8,12 @@
 // or programs.
 
 #include "beaker/prelude.hpp"
+#include "beaker/arena.hpp"
 
 #include "lingo/node.hpp"
 
+#include <memory>
+
 
 namespace beaker
 {
@@ -22,6 +25,9 @@ struct Stmt_visitor;
 // comprising a module or program.
 //
 // There are (currently) no derived translation units.
+//
+// A unit may own the arena in which its nodes were allocated.
+// Destroying the unit releases all of those nodes.
 struct Unit
 {
   Unit(Decl_seq const& d)
@@ -29,8 +35,10 @@ struct Unit
   { }
 
   Decl_seq const& declarations() const { return first; }
+  Arena const*    arena() const        { return arena_.get(); }
 
-  Decl_seq first;
+  Decl_seq               first;
+  std::unique_ptr<Arena> arena_;
 };
 
 
@@ -13,12 +13,16 @@
 
 #include "beaker/prelude.hpp"
 
+#include <vector>
+
 
 namespace beaker
 {
 
 using Value = std::intmax_t;
 
+using Value_seq = std::vector<Value>;
+
 } // namespace beaker
 
 
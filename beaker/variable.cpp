@@ -12,11 +12,12 @@ namespace beaker
 {
 
 // The type of the initializer `e` shall match the 
-// declared type of the variable `t`.
+// declared type of the variable `t`. The value of another
+// variable may be used as an initializer.
 bool 
 check_initializer(Type const* t, Expr const* e)
 {
-  return same(e->type(), t);
+  return same(get_expr_type(e), t);
 }
 
 
@@ -0,0 +1,87 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Counts the allocations made while parsing a source file.
+//
+//    bench-alloc <path>
+//
+// Use bench-file gen to create an input. Heap allocations are
+// counted by replacing the global operator new. Nodes that are
+// allocated in the unit's arena are reported separately.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/unit.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+std::size_t heap_allocs = 0;
+
+
+void*
+operator new(std::size_t n)
+{
+  ++heap_allocs;
+  if (void* p = std::malloc(n))
+    return p;
+  throw std::bad_alloc();
+}
+
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+  std::size_t before = heap_allocs;
+  Unit const* u = parse(f);
+  std::size_t heap = heap_allocs - before;
+  if (error_count())
+    return -1;
+
+  double n = u->declarations().size();
+  Arena const& a = *u->arena();
+  std::cout << "functions:          " << n << '\n'
+            << "heap allocations:   " << heap << " (" << heap / n << " per function)\n"
+            << "arena allocations:  " << a.allocations() << " (" << a.allocations() / n << " per function)\n"
+            << "arena bytes:        " << a.bytes() << '\n'
+            << "arena blocks:       " << a.blocks() << '\n';
+
+  // Release the program.
+  bench::Stopwatch sw;
+  delete u;
+  std::cout << "release:            " << sw.seconds() * 1e3 << " ms\n";
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares checking function definitions while parsing with
+// checking them in parallel after parsing.
+//
+//    bench-check <path> [threads]
+//
+// Use bench-file gen to create a large input. The file is parsed
+// once with definitions checked inline, and then once for each
+// number of threads from 0 to the given maximum (the hardware
+// concurrency by default). The calling thread also checks
+// definitions, so 0 threads checks them after parsing, but
+// serially.
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  int threads = argc > 2 ? std::atoi(argv[2]) : Thread_pool::default_size();
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  {
+    bench::Stopwatch sw;
+    std::unique_ptr<Unit const> u(parse(f));
+    double s = sw.seconds();
+    std::cout << "inline:     " << s << " s ("
+              << bench::mb_per_second(f.size(), s) << " MB/s)\n";
+  }
+
+  for (int t = 0; t <= threads; ++t) {
+    Thread_pool pool(t);
+    bench::Stopwatch sw;
+    std::unique_ptr<Unit const> u(parse(f, pool));
+    double s = sw.seconds();
+    std::cout << "threads: " << t << ", " << s << " s ("
+              << bench::mb_per_second(f.size(), s) << " MB/s)\n";
+  }
+  return error_count() ? -1 : 0;
+}
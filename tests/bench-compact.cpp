@@ -0,0 +1,169 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares hash-consed compaction of expressions with the
+// previous implementation, which shared only leaves using an
+// ordered set.
+//
+//    bench-compact [nodes] [variables]
+//
+// Random expressions (1M nodes in total by default) are generated
+// over a few variables (2 by default) and the constants 0 through
+// 3, so that they contain many common subexpressions.
+
+#include "beaker/token.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/less.hpp"
+#include "beaker/compact.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <unordered_set>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// -------------------------------------------------------------------------- //
+//                            Leaf compaction
+
+using Leaf_set = std::set<Expr const*, Term_less>;
+
+
+Expr const*
+leaf_compact(Leaf_set& leaf, Expr const* e)
+{
+  struct Fn
+  {
+    Expr const* operator()(Constant_expr const* e) const 
+    { 
+      return *l.insert(e).first; 
+    }
+    
+    Expr const* operator()(Identifier_expr const* e) const 
+    { 
+      return *l.insert(e).first; 
+    }
+    
+    Expr const* operator()(Unary_expr const* e) const 
+    { 
+      return make_unary_expr(e->op(), leaf_compact(l, e->arg())); 
+    }
+    
+    Expr const* operator()(Binary_expr const* e) const 
+    {
+      Expr const* e1 = leaf_compact(l, e->left());
+      Expr const* e2 = leaf_compact(l, e->right());
+      return make_binary_expr(e->op(), e1, e2);
+    }
+
+    Expr const* operator()(Call_expr const* e) const 
+    { 
+      return e; 
+    }
+
+    Leaf_set& l;
+  };
+  return apply(e, Fn{leaf});
+}
+
+
+// -------------------------------------------------------------------------- //
+//                              Generation
+
+// Generate a random integer expression having approximately
+// `n` nodes.
+Expr const*
+generate(std::minstd_rand& rng, Decl_seq const& vars, std::size_t n)
+{
+  if (n <= 1) {
+    if (rng() % 2)
+      return make_identifier_expr(vars[rng() % vars.size()]);
+    return make_int_expr(rng() % 4);
+  }
+  if (rng() % 8 == 0)
+    return make_unary_expr(num_neg_op, generate(rng, vars, n - 1));
+  static Binary_op const ops[] { num_add_op, num_sub_op, num_mul_op };
+  std::size_t k = 1 + rng() % (n - 1);
+  Expr const* e1 = generate(rng, vars, k);
+  Expr const* e2 = generate(rng, vars, n - k);
+  return make_binary_expr(ops[rng() % 3], e1, e2);
+}
+
+
+// Count the distinct nodes reachable from `e`.
+std::size_t
+count(Expr const* e, std::unordered_set<Expr const*>& seen)
+{
+  if (!seen.insert(e).second)
+    return 0;
+  if (Unary_expr const* u = as<Unary_expr>(e))
+    return 1 + count(u->arg(), seen);
+  if (Binary_expr const* b = as<Binary_expr>(e))
+    return 1 + count(b->left(), seen) + count(b->right(), seen);
+  return 1;
+}
+
+
+std::size_t
+count(Expr const* e)
+{
+  std::unordered_set<Expr const*> seen;
+  return count(e, seen);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  std::size_t n = argc > 1 ? std::atol(argv[1]) : 1000000;
+  int nvars = argc > 2 ? std::atoi(argv[2]) : 2;
+
+  Decl_seq vars;
+  for (int i = 0; i < nvars; ++i) {
+    String name = "x" + std::to_string(i);
+    vars.push_back(make_parameter_decl(get_identifier(name), get_int_type()));
+  }
+
+  std::minstd_rand rng(42);
+  std::vector<Expr const*> exprs;
+  std::size_t nodes = 0;
+  while (nodes < n) {
+    exprs.push_back(generate(rng, vars, 1000));
+    nodes += count(exprs.back());
+  }
+
+  std::vector<Expr const*> result(exprs.size());
+
+  bench::Stopwatch sw1;
+  for (std::size_t i = 0; i < exprs.size(); ++i) {
+    Leaf_set leaf;
+    result[i] = leaf_compact(leaf, exprs[i]);
+  }
+  double t1 = sw1.seconds();
+  std::size_t leaf_nodes = 0;
+  for (Expr const* e : result)
+    leaf_nodes += count(e);
+
+  bench::Stopwatch sw2;
+  for (std::size_t i = 0; i < exprs.size(); ++i)
+    result[i] = compact(exprs[i]);
+  double t2 = sw2.seconds();
+  std::size_t dag_nodes = 0;
+  for (Expr const* e : result)
+    dag_nodes += count(e);
+
+  std::cout << "tree:      " << nodes << " nodes\n"
+            << "leaf set:  " << leaf_nodes << " nodes, " << t1 << " s\n"
+            << "hash-cons: " << dag_nodes << " nodes, " << t2 << " s\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the throughput of independent compilations, each in
+// its own context, as the number of threads increases.
+//
+//    bench-context <path> [threads] [compilations]
+//
+// Use bench-file gen to create a large input. For each number
+// of threads from 1 to the given maximum (the hardware
+// concurrency by default), the file is parsed the given number
+// of times (8 by default).
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/context.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  int threads = argc > 2 ? std::atoi(argv[2]) : Thread_pool::default_size();
+  int n = argc > 3 ? std::atoi(argv[3]) : 8;
+
+  Mapped_file f(argv[1]);
+  std::atomic<int> errors(0);
+  for (int t = 1; t <= threads; ++t) {
+    Thread_pool pool(t);
+    bench::Stopwatch sw;
+    for (int i = 0; i < n; ++i) {
+      pool.submit([&f, &errors]() {
+        Context cxt;
+        Input_context in(f);
+        std::unique_ptr<Unit const> u(parse(cxt, f));
+        errors += cxt.errors;
+      });
+    }
+    pool.wait();
+    double s = sw.seconds();
+    std::cout << "threads: " << t << ", "
+              << s << " s ("
+              << bench::mb_per_second(f.size() * n, s) << " MB/s)\n";
+  }
+  return errors ? -1 : 0;
+}
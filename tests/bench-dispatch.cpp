@@ -0,0 +1,120 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the cost of traversals that dispatch through apply():
+// the reduction of deeply nested expressions and the printing
+// of a large translation unit.
+//
+//    bench-dispatch <path> [depth] [rounds]
+//
+// Use bench-file gen to create a large input. Expressions are
+// nested to the given depth (2000 by default). Each traversal
+// is repeated for the given number of rounds (10 by default).
+//
+// Configure with -DBEAKER_VIRTUAL_DISPATCH=ON to measure the
+// virtual visitors instead of the switch on node kinds.
+
+#include "beaker/token.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/arena.hpp"
+#include "beaker/evaluate.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns a constant expression nested to depth `n`. The
+// operators vary so that every kind of expression (except
+// calls) is reduced.
+Expr const*
+generate(int n)
+{
+  Expr const* e = make_int_expr(1);
+  for (int i = 0; i < n; ++i) {
+    switch (i % 4) {
+    case 0:
+      e = make_binary_expr(num_add_op, e, make_int_expr(i));
+      break;
+    case 1:
+      e = make_binary_expr(num_mul_op, make_int_expr(3), e);
+      break;
+    case 2:
+      e = make_unary_expr(num_neg_op, e);
+      break;
+    case 3:
+      e = make_binary_expr(bit_and_op, e, make_int_expr(0xffff));
+      break;
+    }
+  }
+  return e;
+}
+
+
+// A stream buffer that discards its output.
+struct Null_buffer : std::streambuf
+{
+  int overflow(int c) { return c; }
+  std::streamsize xsputn(char const*, std::streamsize n) { return n; }
+};
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  int depth = argc > 2 ? std::atoi(argv[2]) : 2000;
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 10;
+
+#ifdef BEAKER_VIRTUAL_DISPATCH
+  std::cout << "dispatch: virtual\n";
+#else
+  std::cout << "dispatch: switch\n";
+#endif
+
+  // Reduce deep expressions. Reduction allocates new nodes,
+  // so each round uses its own arena.
+  Expr const* e = generate(depth);
+  Value v = 0;
+  bench::Stopwatch sw1;
+  for (int i = 0; i < rounds; ++i) {
+    Arena a;
+    Use_arena use(a);
+    for (int j = 0; j < 100; ++j)
+      v += cast<Constant_expr>(reduce(e))->value();
+  }
+  double t1 = sw1.seconds();
+  std::cout << "reduce: " << t1 << " s (" << v << ")\n";
+
+  // Print a large unit.
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Null_buffer buf;
+  std::ostream os(&buf);
+  bench::Stopwatch sw2;
+  for (int i = 0; i < rounds; ++i) {
+    Printer p(os);
+    print(p, u);
+  }
+  double t2 = sw2.seconds();
+  std::cout << "print:  " << t2 << " s ("
+            << bench::mb_per_second(f.size() * rounds, t2) << " MB/s)\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the time needed to parse expression-heavy code.
+//
+//    bench-expr [functions] [terms] [rounds]
+//
+// Generates a unit with the given number of functions (10000 by
+// default), each returning an expression of the given number of
+// terms (32 by default) that mixes operators of every precedence
+// with literals, parameters, and parenthesized subexpressions.
+// The unit is parsed for the given number of rounds (5 by
+// default), and the best time is reported.
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// The operators used to join terms. These never form a bool
+// operand, so every expression has type int.
+char const* ops[] = {
+  " + ", " - ", " * ", " / ", " % ", " << ", " >> ", " & ", " ^ ", " | ",
+};
+
+
+// Returns the text of the ith term of an expression.
+std::string
+term(int i)
+{
+  switch (i % 4) {
+  case 0: return "a";
+  case 1: return std::to_string(i);
+  case 2: return "(b - " + std::to_string(i) + ")";
+  default: return "-c";
+  }
+}
+
+
+std::string
+generate(int nfns, int nterms)
+{
+  std::string text;
+  for (int i = 0; i < nfns; ++i) {
+    text += "def f" + std::to_string(i) + "(a : int, b : int, c : int) -> int\n";
+    text += "{\n  return " + term(0);
+    for (int j = 1; j < nterms; ++j)
+      text += ops[(i + j) % 10] + term(j);
+    text += ";\n}\n\n";
+  }
+  return text;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  int nfns = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int nterms = argc > 2 ? std::atoi(argv[2]) : 32;
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  Buffer buf(generate(nfns, nterms));
+  Input_context cxt(buf);
+
+  double best = 0;
+  for (int i = 0; i < rounds; ++i) {
+    bench::Stopwatch sw;
+    std::unique_ptr<Unit const> u(parse(buf));
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+  }
+  std::cout << "bytes:      " << buf.size() << '\n'
+            << "time:       " << best << " s\n"
+            << "throughput: " << bench::mb_per_second(buf.size(), best) << " MB/s\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares lexing from a heap copy of a source file with
+// lexing from a memory mapped file.
+//
+//    bench-file gen <path> <megabytes>
+//    bench-file read <path>
+//    bench-file mmap <path>
+//
+// Run each mode in a separate process so that the reported
+// peak memory use is that of a single strategy.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/file.hpp"
+
+#include "lingo/file.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+void
+report(char const* mode, Buffer& buf, bench::Stopwatch const& sw)
+{
+  Token_list toks = lex(buf);
+  double t = sw.seconds();
+  std::cout << "mode:       " << mode << '\n'
+            << "bytes:      " << buf.size() << '\n'
+            << "tokens:     " << toks.size() << '\n'
+            << "time:       " << t << " s\n"
+            << "throughput: " << bench::mb_per_second(buf.size(), t) << " MB/s\n"
+            << "peak rss:   " << bench::peak_rss() << " MB\n";
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  if (argc < 3) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  if (!std::strcmp(argv[1], "gen") && argc == 4) {
+    std::ofstream os(argv[2]);
+    bench::generate_source(os, std::atol(argv[3]) << 20);
+    return 0;
+  }
+
+  // Time both the acquisition of the text and lexing.
+  bench::Stopwatch sw;
+  if (!std::strcmp(argv[1], "read")) {
+    File& f = open_file(argv[2]);
+    report("read", f, sw);
+  } else if (!std::strcmp(argv[1], "mmap")) {
+    Mapped_file f(argv[2]);
+    report("mmap", f, sw);
+  } else {
+    error("unknown mode '{}'", argv[1]);
+    return -1;
+  }
+  return error_count() ? -1 : 0;
+}
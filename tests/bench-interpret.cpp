@@ -0,0 +1,74 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the time needed to interpret a program.
+//
+//    bench-interpret <path> <function> [arg] [rounds]
+//
+// Calls the named function of the program with the given
+// argument, or with no arguments if none is given. The call is
+// repeated for the given number of rounds (5 by default), and
+// the best time is reported. For example:
+//
+//    bench-interpret input/interpret/fib.bkr fib 27
+//    bench-interpret input/interpret/gcd.bkr gcd_sum 300
+//    bench-interpret input/interpret/primes.bkr count_primes 200000
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Value_seq args;
+  if (argc > 3)
+    args.push_back(std::atoi(argv[3]));
+  int rounds = argc > 4 ? std::atoi(argv[4]) : 5;
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, argv[2]);
+  if (!fn) {
+    error("no function named '{}'", argv[2]);
+    return -1;
+  }
+
+  Interpreter interp(u);
+  Value result = 0;
+  double best = 0;
+  for (int i = 0; i < rounds; ++i) {
+    bench::Stopwatch sw;
+    result = interp.call(fn, args);
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+  }
+  std::cout << "result:     " << result << '\n'
+            << "time:       " << best << " s\n";
+  return error_count() ? -1 : 0;
+}
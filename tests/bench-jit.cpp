@@ -0,0 +1,112 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares the time needed to run a program as native code with
+// the time needed to run it on the bytecode machine.
+//
+//    bench-jit <path> <function> [arg] [rounds] [pipeline]
+//
+// Calls the named function of the program with the given
+// argument, or with no arguments if none is given. Each call
+// is repeated for the given number of rounds (5 by default),
+// and the best times are reported. The function is compiled
+// with the given pass pipeline ("default<O2>" by default). For
+// example:
+//
+//    bench-jit input/interpret/fib.bkr fib 32
+//    bench-jit input/interpret/primes.bkr count_primes 200000 5 "default<O3>"
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+#include "beaker/codegen/jit.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns the best time of `rounds` calls to `fn`, storing
+// the value of the last call in `result`.
+template<typename F>
+double
+best_of(int rounds, Value& result, F fn)
+{
+  double best = 0;
+  for (int i = 0; i < rounds; ++i) {
+    bench::Stopwatch sw;
+    result = fn();
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+  }
+  return best;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Value_seq args;
+  if (argc > 3)
+    args.push_back(std::atoi(argv[3]));
+  int rounds = argc > 4 ? std::atoi(argv[4]) : 5;
+  Jit_options opts;
+  if (argc > 5)
+    opts.pipeline = argv[5];
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, argv[2]);
+  if (!fn) {
+    error("no function named '{}'", argv[2]);
+    return -1;
+  }
+
+  Program prog = to_bytecode(u);
+  Machine m(prog);
+  Procedure const& proc = *prog.find(fn);
+
+  bench::Stopwatch sw;
+  Jit jit(u, opts);
+  Jit::Entry entry = jit.compile(fn);
+  double compile = sw.seconds();
+  if (!entry)
+    return -1;
+
+  Value v1;
+  Value v2;
+  double t1 = best_of(rounds, v1, [&]() { return m.call(proc, args); });
+  double t2 = best_of(rounds, v2, [&]() { return entry(args.data()); });
+  if (v1 != v2) {
+    error("the machine returned {} but native code returned {}", v1, v2);
+    return -1;
+  }
+  std::cout << "result:      " << v2 << '\n'
+            << "compilation: " << compile << " s\n"
+            << "machine:     " << t1 << " s\n"
+            << "native:      " << t2 << " s\n"
+            << "speedup:     " << t1 / t2 << "x\n";
+  return error_count() ? -1 : 0;
+}
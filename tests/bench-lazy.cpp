@@ -0,0 +1,73 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares parsing a file with parsing only its declarations,
+// deferring the bodies of functions.
+//
+//    bench-lazy <path>
+//
+// Use bench-file gen to create a large input. Reports the time
+// to parse the whole file, the time to parse its declarations
+// (deferring bodies), and the time to parse all the deferred
+// bodies afterwards, both together and as each is requested.
+
+#include "beaker/token.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+
+#include "bench.hpp"
+
+#include <iostream>
+#include <memory>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  bench::Stopwatch sw1;
+  std::unique_ptr<Unit const> u1(parse(f));
+  double t1 = sw1.seconds();
+
+  bench::Stopwatch sw2;
+  std::unique_ptr<Unit const> u2(parse_declarations(f));
+  double t2 = sw2.seconds();
+
+  bench::Stopwatch sw3;
+  parse_bodies(u2.get());
+  double t3 = sw3.seconds();
+
+  std::unique_ptr<Unit const> u3(parse_declarations(f));
+  bench::Stopwatch sw4;
+  for (Decl const* d : u3->declarations())
+    if (Function_decl const* fn = as<Function_decl>(d))
+      fn->body();
+  double t4 = sw4.seconds();
+
+  std::size_t ndecls = u1->declarations().size();
+  std::cout << "declarations: " << ndecls << '\n'
+            << "parse:        " << t1 << " s ("
+            << bench::mb_per_second(f.size(), t1) << " MB/s)\n"
+            << "deferred:     " << t2 << " s ("
+            << bench::mb_per_second(f.size(), t2) << " MB/s, "
+            << t1 / t2 << "x)\n"
+            << "bodies:       " << t3 << " s\n"
+            << "on request:   " << t4 << " s\n";
+  return error_count() ? -1 : 0;
+}
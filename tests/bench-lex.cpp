@@ -0,0 +1,94 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures lexing throughput for each scanner implementation
+// supported by the host, and for parallel lexing with the best
+// scanner.
+//
+//    bench-lex <path> [megabytes] [threads]
+//
+// The input file (e.g., tests/input/lex/1.bkr) is repeated until
+// the source is at least the given size (64 MB by default). By
+// default, parallel lexing uses one thread per processor.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/scan.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include "bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Lex the buffer several times and return the best time.
+// If `pool` is non-null, lex in parallel.
+double
+time_lex(Buffer& buf, Thread_pool* pool, std::size_t& ntoks)
+{
+  double best = 0;
+  for (int i = 0; i < 3; ++i) {
+    bench::Stopwatch sw;
+    Token_list toks = pool ? lex(buf, *pool) : lex(buf);
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+    ntoks = toks.size();
+  }
+  return best;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  std::size_t size = (argc > 2 ? std::atol(argv[2]) : 64) << 20;
+
+  // Scale up the input.
+  std::stringstream ss;
+  ss << std::ifstream(argv[1]).rdbuf();
+  std::string text = ss.str();
+  char const* path = "bench-lex.bkr";
+  {
+    std::ofstream os(path);
+    for (std::size_t n = 0; n < size; n += text.size())
+      os << text;
+  }
+  Mapped_file f(path);
+  std::remove(path);
+
+  Scan_mode modes[] { scalar_scan, sse2_scan, avx2_scan };
+  for (Scan_mode m : modes) {
+    if (!set_scan_mode(m))
+      continue;
+    std::size_t ntoks;
+    double t = time_lex(f, nullptr, ntoks);
+    std::cout << get_spelling(m) << ": "
+              << bench::mb_per_second(f.size(), t) << " MB/s ("
+              << ntoks << " tokens in " << t << " s)\n";
+  }
+
+  set_scan_mode(get_best_scan_mode());
+  Thread_pool pool(argc > 3 ? std::atoi(argv[3]) : Thread_pool::default_size());
+  std::size_t ntoks;
+  double t = time_lex(f, &pool, ntoks);
+  std::cout << "parallel (" << pool.size() << " threads): "
+            << bench::mb_per_second(f.size(), t) << " MB/s ("
+            << ntoks << " tokens in " << t << " s)\n";
+  return error_count() ? -1 : 0;
+}
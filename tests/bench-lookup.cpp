@@ -0,0 +1,85 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the cost of declaring and looking up names in the
+// scopes of large functions.
+//
+//    bench-lookup [locals] [rounds]
+//
+// Each round enters a function scope, declares the given number
+// of local variables (4096 by default) in nested blocks of 16,
+// and looks up a few earlier locals and globals after each
+// declaration. The rounds (100 by default) are timed together.
+
+#include "beaker/lookup.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/token.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  int nlocals = argc > 1 ? std::atoi(argv[1]) : 4096;
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  Scope gs(global_scope);
+
+  // Declare some globals.
+  std::vector<String const*> globals;
+  for (int i = 0; i < 64; ++i) {
+    globals.push_back(get_identifier("g" + std::to_string(i)));
+    declare(make_variable_decl(globals.back(), get_int_type(), make_int_expr(i)));
+  }
+
+  // Create the declarations for the locals. Every fourth local
+  // hides a global.
+  std::vector<Decl const*> locals;
+  for (int i = 0; i < nlocals; ++i) {
+    String const* n = i % 4 ? get_identifier("x" + std::to_string(i))
+                            : globals[i % globals.size()];
+    locals.push_back(make_variable_decl(n, get_int_type(), make_int_expr(i)));
+  }
+
+  std::size_t found = 0;
+  bench::Stopwatch sw;
+  for (int r = 0; r < rounds; ++r) {
+    Function_scope fs;
+    std::vector<std::unique_ptr<Local_scope>> blocks;
+    for (int i = 0; i < nlocals; ++i) {
+      if (i % 16 == 0)
+        blocks.emplace_back(new Local_scope());
+      declare(locals[i]);
+      found += lookup(locals[i / 2]->name()) != nullptr;
+      found += lookup(locals[i - i % 16]->name()) != nullptr;
+      found += lookup(globals[i % globals.size()]) != nullptr;
+    }
+
+    // Leave the blocks in reverse order.
+    while (!blocks.empty())
+      blocks.pop_back();
+  }
+  double t = sw.seconds();
+
+  std::size_t nops = std::size_t(rounds) * nlocals;
+  std::cout << "declarations: " << nops << '\n'
+            << "lookups:      " << 3 * nops << " (" << found << " found)\n"
+            << "time:         " << t << " s\n"
+            << "per op:       " << t * 1e9 / (4 * nops) << " ns\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the rate at which the machine executes instructions.
+//
+//    bench-loop <path> [iterations] [rounds]
+//
+// Runs the function loop() of the program (see
+// input/interpret/loop.bkr) for the given number of iterations
+// (10^7 by default). The run is repeated for the given number
+// of rounds (5 by default), and the best time is reported.
+//
+// Configure with -DBEAKER_THREADED_DISPATCH=OFF to measure
+// dispatch through a switch instead of computed goto.
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  Value_seq args {argc > 2 ? std::atoi(argv[2]) : 10000000};
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+
+#ifdef BEAKER_THREADED_DISPATCH
+  std::cout << "dispatch:     threaded\n";
+#else
+  std::cout << "dispatch:     switch\n";
+#endif
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, "loop");
+  if (!fn) {
+    error("no function named 'loop'");
+    return -1;
+  }
+
+  Program prog = to_bytecode(u);
+  Procedure const& proc = *prog.find(fn);
+  Machine m(prog);
+
+  // Count the instructions executed by one run.
+  m.counting = true;
+  m.steps = 0;
+  Value v = m.call(proc, args);
+  m.counting = false;
+
+  double best = 0;
+  for (int i = 0; i < rounds; ++i) {
+    bench::Stopwatch sw;
+    m.call(proc, args);
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+  }
+  std::cout << "result:       " << v << '\n'
+            << "instructions: " << m.steps << '\n'
+            << "time:         " << best << " s\n"
+            << "rate:         " << m.steps / best / 1e6 << " M/s\n";
+  return error_count() ? -1 : 0;
+}
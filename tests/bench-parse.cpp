@@ -0,0 +1,45 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Measures the time and memory needed to parse a source file.
+//
+//    bench-parse <path>
+//
+// Use bench-file gen to create a large input.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+
+#include "bench.hpp"
+
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  bench::Stopwatch sw;
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+  parse(f);
+  double t = sw.seconds();
+  std::cout << "bytes:      " << f.size() << '\n'
+            << "time:       " << t << " s\n"
+            << "throughput: " << bench::mb_per_second(f.size(), t) << " MB/s\n"
+            << "peak rss:   " << bench::peak_rss() << " MB\n";
+  return error_count() ? -1 : 0;
+}
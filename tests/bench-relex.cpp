@@ -0,0 +1,94 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares incremental lexing with full lexing for a sequence
+// of single character edits.
+//
+//    bench-relex [megabytes] [edits]
+//
+// The source is generated (1 MB by default) and each edit
+// (100 by default) inserts, removes, or replaces a character
+// at a random position outside of a comment.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns true if the nth character is on a comment line.
+bool
+in_comment(String const& text, std::size_t n)
+{
+  std::size_t p = text.rfind('\n', n);
+  p = (p == String::npos) ? 0 : p + 1;
+  return text.compare(p, 2, "//") == 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  std::size_t size = (argc > 1 ? std::atol(argv[1]) : 1) << 20;
+  int edits = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  std::stringstream ss;
+  bench::generate_source(ss, size);
+  String text = ss.str();
+  std::unique_ptr<Buffer> buf(new Buffer(text));
+  Edit_list toks(*buf);
+
+  std::minstd_rand rng(42);
+  double full = 0;
+  double incr = 0;
+  std::size_t changed = 0;
+  for (int i = 0; i < edits; ++i) {
+    std::size_t n = rng() % text.size();
+    while (in_comment(text, n))
+      n = rng() % text.size();
+    Text_edit e {n, 0, 0};
+    switch (rng() % 3) {
+    case 0:
+      text.insert(n, 1, 'x');
+      e.inserted = 1;
+      break;
+    case 1:
+      text.erase(n, 1);
+      e.removed = 1;
+      break;
+    case 2:
+      text[n] = ' ';
+      e.removed = e.inserted = 1;
+      break;
+    }
+    buf.reset(new Buffer(text));
+
+    bench::Stopwatch sw1;
+    Token_list all = lex(*buf);
+    full += sw1.seconds();
+
+    bench::Stopwatch sw2;
+    Token_range r = toks.relex(*buf, e);
+    incr += sw2.seconds();
+    changed += r.last - r.first;
+  }
+
+  std::cout << "bytes:       " << text.size() << '\n'
+            << "tokens:      " << toks.size() << '\n'
+            << "full lex:    " << full / edits * 1e3 << " ms/edit\n"
+            << "incremental: " << incr / edits * 1e3 << " ms/edit ("
+            << double(changed) / edits << " tokens relexed)\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares type equivalence on the paths that check calls and
+// operands with the previous implementation, which compared
+// the dynamic types of its arguments and then their structure.
+//
+//    bench-same [iterations]
+//
+// Each iteration checks the arguments of a set of calls and
+// the types of their arguments (1M iterations by default).
+
+#include "beaker/token.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/same.hpp"
+#include "beaker/function.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <typeindex>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// -------------------------------------------------------------------------- //
+//                          Structural equivalence
+
+bool legacy_same(Type const*, Type const*);
+
+
+bool
+legacy_same(Type_seq const& a, Type_seq const& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    if (!legacy_same(a[i], b[i]))
+      return false;
+  return true;
+}
+
+
+bool
+legacy_same(Type const* a, Type const* b)
+{
+  struct Fn
+  {
+    bool operator()(Void_type const* t) const { return true; }
+    bool operator()(Boolean_type const* t) const { return true; }
+    bool operator()(Integer_type const* t) const { return true; }
+
+    bool operator()(Function_type const* t) const
+    {
+      Function_type const* u = static_cast<Function_type const*>(b);
+      return legacy_same(t->parameter_types(), u->parameter_types())
+          && legacy_same(t->return_type(), u->return_type());
+    }
+
+    bool operator()(Reference_type const* t) const
+    {
+      Reference_type const* u = static_cast<Reference_type const*>(b);
+      return legacy_same(t->type(), u->type());
+    }
+
+    Type const* b;
+  };
+
+  if (std::type_index(typeid(*a)) != std::type_index(typeid(*b)))
+    return false;
+  return apply(a, Fn{b});
+}
+
+
+bool
+legacy_check_arguments(Function_type const* t, Expr_seq const& args)
+{
+  Type_seq const& parms = t->parameter_types();
+  if (parms.size() != args.size())
+    return false;
+  for (std::size_t i = 0; i < args.size(); ++i)
+    if (!legacy_same(parms[i], args[i]->type()))
+      return false;
+  return true;
+}
+
+
+bool
+legacy_has_integer_type(Expr const* e)
+{
+  return legacy_same(get_int_type(), e->type());
+}
+
+
+// -------------------------------------------------------------------------- //
+//                                Calls
+
+// A call to be checked: the type of the target and the
+// arguments of the call.
+struct Call
+{
+  Function_type const* type;
+  Expr_seq             args;
+};
+
+
+// Returns a set of calls whose arguments match the types of
+// their parameters.
+std::vector<Call>
+make_calls()
+{
+  Type const* b = get_bool_type();
+  Type const* z = get_int_type();
+  Type const* f = get_function_type(Type_seq {z, z}, b);
+
+  Decl const* x = make_parameter_decl(get_identifier("x"), z);
+  Decl const* p = make_parameter_decl(get_identifier("p"), f);
+  Expr const* e1 = make_int_expr(1);
+  Expr const* e2 = make_bool_expr(true);
+
+  std::vector<Call> calls;
+  calls.push_back({get_function_type(Type_seq {z}, z), {e1}});
+  calls.push_back({get_function_type(Type_seq {z, z, z}, z), {e1, e1, e1}});
+  calls.push_back({get_function_type(Type_seq {b, z}, b), {e2, e1}});
+  calls.push_back({get_function_type(Type_seq {get_reference_type(z)}, z),
+                   {make_identifier_expr(x)}});
+  calls.push_back({get_function_type(Type_seq {get_reference_type(f), z}, z),
+                   {make_identifier_expr(p), e1}});
+  return calls;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  long n = argc > 1 ? std::atol(argv[1]) : 1000000;
+  std::vector<Call> calls = make_calls();
+
+  std::size_t k1 = 0;
+  bench::Stopwatch sw1;
+  for (long i = 0; i < n; ++i) {
+    for (Call const& c : calls) {
+      k1 += legacy_check_arguments(c.type, c.args);
+      for (Expr const* e : c.args)
+        k1 += legacy_has_integer_type(e);
+    }
+  }
+  double t1 = sw1.seconds();
+
+  std::size_t k2 = 0;
+  bench::Stopwatch sw2;
+  for (long i = 0; i < n; ++i) {
+    for (Call const& c : calls) {
+      k2 += check_arguments(c.type, c.args);
+      for (Expr const* e : c.args)
+        k2 += has_integer_type(e);
+    }
+  }
+  double t2 = sw2.seconds();
+
+  if (k1 != k2)
+    error("mismatched results ({} and {})", k1, k2);
+
+  std::cout << "structural: " << t1 << " s\n"
+            << "canonical:  " << t2 << " s\n";
+  return error_count() ? -1 : 0;
+}
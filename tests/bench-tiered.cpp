@@ -0,0 +1,151 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares the bytecode machine, native code, and tiered
+// execution by the time needed to produce a first result, and
+// by their steady-state throughput.
+//
+//    bench-tiered <path> <function> [arg] [calls] [threshold]
+//
+// Calls the named function of the program with the given
+// argument, or with no arguments if none is given, for the
+// given number of calls (20 by default). The time to the first
+// result includes the preparation of each tier: translation to
+// bytecode, compilation to native code, or both. The steady
+// state is the best time of the last 5 calls. Tiered execution
+// uses the given threshold (1000 by default). For example:
+//
+//    bench-tiered input/interpret/fib.bkr fib 25
+//    bench-tiered input/interpret/primes.bkr count_primes 20000
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+#include "beaker/engine.hpp"
+#include "beaker/codegen/jit.hpp"
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Timings of a tier.
+struct Timing
+{
+  double first;  // Time to the first result
+  double steady; // Best time of the last calls
+  Value  result; // The value of the last call
+};
+
+
+// Time `n` calls to `fn`, after preparing the tier with `prep`.
+// Returns the times measured.
+template<typename P, typename F>
+Timing
+measure(int n, P prep, F fn)
+{
+  Timing t {0, 0, 0};
+  bench::Stopwatch sw;
+  prep();
+  for (int i = 0; i < n; ++i) {
+    bench::Stopwatch call;
+    t.result = fn();
+    double s = call.seconds();
+    if (i == 0)
+      t.first = sw.seconds();
+    if (i == std::max(0, n - 5) || (i > n - 5 && s < t.steady))
+      t.steady = s;
+  }
+  return t;
+}
+
+
+void
+report(char const* name, Timing const& t)
+{
+  std::cout << std::left << std::setw(10) << name << std::right
+            << std::setw(14) << t.first
+            << std::setw(14) << t.steady << '\n';
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Value_seq args;
+  if (argc > 3)
+    args.push_back(std::atoi(argv[3]));
+  int calls = argc > 4 ? std::atoi(argv[4]) : 20;
+  Tier_options opts;
+  if (argc > 5)
+    opts.threshold = std::atoi(argv[5]);
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, argv[2]);
+  if (!fn) {
+    error("no function named '{}'", argv[2]);
+    return -1;
+  }
+
+  // The bytecode machine.
+  std::unique_ptr<Program> prog;
+  std::unique_ptr<Machine> m;
+  Timing t1 = measure(calls,
+    [&]() {
+      prog.reset(new Program(to_bytecode(u)));
+      m.reset(new Machine(*prog));
+    },
+    [&]() { return m->call(*prog->find(fn), args); });
+
+  // Native code.
+  std::unique_ptr<Jit> jit;
+  Jit::Entry entry = nullptr;
+  Timing t2 = measure(calls,
+    [&]() {
+      jit.reset(new Jit(u));
+      entry = jit->compile(fn);
+    },
+    [&]() { return entry ? entry(args.data()) : 0; });
+
+  // Tiered execution.
+  std::unique_ptr<Engine> e;
+  Timing t3 = measure(calls,
+    [&]() { e.reset(new Engine(u, opts)); },
+    [&]() { return e->call(fn, args); });
+
+  if (t1.result != t2.result || t1.result != t3.result) {
+    error("the tiers disagree: {}, {}, {}", t1.result, t2.result, t3.result);
+    return -1;
+  }
+  std::cout << "result:   " << t1.result << '\n'
+            << "compiled: " << e->compiled << " functions\n\n"
+            << "tier        first (s)    steady (s)\n";
+  report("machine", t1);
+  report("native", t2);
+  report("tiered", t3);
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares the storage of tokens in a token list (an array
+// of tokens) with a compact token buffer (an array for each
+// token attribute).
+//
+//    bench-tokens <path>
+//
+// For each representation, this reports the number of bytes
+// used per token and the time needed to scan the kinds of all
+// tokens, which approximates the parser's lookahead.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/file.hpp"
+#include "beaker/context.hpp"
+
+#include "bench.hpp"
+
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Count the statement terminators in the token list.
+std::size_t
+count_semicolons(Token_list const& toks)
+{
+  std::size_t n = 0;
+  for (Token const& tok : toks)
+    n += tok.kind() == semicolon_tok;
+  return n;
+}
+
+
+// Count the statement terminators in the token buffer.
+std::size_t
+count_semicolons(Token_buffer const& buf)
+{
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < buf.size(); ++i)
+    n += buf.kind(i) == semicolon_tok;
+  return n;
+}
+
+
+template<typename T>
+void
+report(char const* name, T const& toks, std::size_t ntoks, std::size_t bytes)
+{
+  std::size_t n = 0;
+  bench::Stopwatch sw;
+  for (int i = 0; i < 10; ++i)
+    n += count_semicolons(toks);
+  double t = sw.seconds() / 10;
+  std::cout << name << ": "
+            << double(bytes) / ntoks << " bytes/token, "
+            << "scan " << t * 1e3 << " ms (" << n / 10 << " semicolons)\n";
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Token_list toks = lex(f);
+  toks.shrink_to_fit();
+  report("list  ", toks, toks.size(), toks.capacity() * sizeof(Token));
+
+  Token_buffer buf(f);
+  for (Token const& tok : toks) {
+    String const& str = tok.symbol().str;
+    buf.push_back(tok, current_context().symbols.intern(str.data(), str.data() + str.size(), -1));
+  }
+  report("buffer", buf, buf.size(), buf.bytes());
+
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compares the time needed to run a program on the bytecode
+// machine with the time needed to interpret its syntax trees.
+//
+//    bench-vm <path> <function> [arg] [rounds]
+//
+// Calls the named function of the program with the given
+// argument, or with no arguments if none is given. Each call
+// is repeated for the given number of rounds (5 by default),
+// and the best times are reported. For example:
+//
+//    bench-vm input/interpret/fib.bkr fib 27
+//    bench-vm input/interpret/gcd.bkr gcd_sum 300
+//    bench-vm input/interpret/primes.bkr count_primes 200000
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns the best time of `rounds` calls to `fn`, storing
+// the value of the last call in `result`.
+template<typename F>
+double
+best_of(int rounds, Value& result, F fn)
+{
+  double best = 0;
+  for (int i = 0; i < rounds; ++i) {
+    bench::Stopwatch sw;
+    result = fn();
+    double t = sw.seconds();
+    if (i == 0 || t < best)
+      best = t;
+  }
+  return best;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Value_seq args;
+  if (argc > 3)
+    args.push_back(std::atoi(argv[3]));
+  int rounds = argc > 4 ? std::atoi(argv[4]) : 5;
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, argv[2]);
+  if (!fn) {
+    error("no function named '{}'", argv[2]);
+    return -1;
+  }
+
+  bench::Stopwatch sw;
+  Program prog = to_bytecode(u);
+  double translate = sw.seconds();
+  Procedure const& proc = *prog.find(fn);
+
+  Interpreter interp(u);
+  Machine m(prog);
+  Value v1;
+  Value v2;
+  double t1 = best_of(rounds, v1, [&]() { return interp.call(fn, args); });
+  double t2 = best_of(rounds, v2, [&]() { return m.call(proc, args); });
+  if (v1 != v2) {
+    error("the interpreter returned {} but the machine returned {}", v1, v2);
+    return -1;
+  }
+  std::cout << "result:      " << v2 << '\n'
+            << "translation: " << translate << " s\n"
+            << "interpreter: " << t1 << " s\n"
+            << "machine:     " << t2 << " s\n"
+            << "speedup:     " << t1 / t2 << "x\n";
+  return error_count() ? -1 : 0;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_TESTS_BENCH_HPP
+#define BEAKER_TESTS_BENCH_HPP
+
+// Support for the benchmark drivers. These are built with the
+// test drivers but are not run as part of the test suite.
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <sys/resource.h>
+
+
+namespace bench
+{
+
+// Measures elapsed wall clock time.
+struct Stopwatch
+{
+  using Clock = std::chrono::steady_clock;
+
+  Stopwatch()
+    : start(Clock::now())
+  { }
+
+  // Returns the number of seconds since construction.
+  double seconds() const
+  {
+    std::chrono::duration<double> d = Clock::now() - start;
+    return d.count();
+  }
+
+  Clock::time_point start;
+};
+
+
+// Returns the peak resident set size of the process in
+// megabytes.
+inline double
+peak_rss()
+{
+  struct rusage r;
+  getrusage(RUSAGE_SELF, &r);
+  return r.ru_maxrss / 1024.0;
+}
+
+
+// Returns a throughput in megabytes per second.
+inline double
+mb_per_second(std::size_t bytes, double secs)
+{
+  return (bytes / (1024.0 * 1024.0)) / secs;
+}
+
+
+// Write a Beaker translation unit of approximately `bytes`
+// characters to `os`. Each function is distinct so that the
+// output can be parsed as well as lexed.
+inline void
+generate_source(std::ostream& os, std::size_t bytes)
+{
+  std::size_t n = 0;
+  for (int i = 0; n < bytes; ++i) {
+    std::stringstream ss;
+    ss << "// Generated function " << i << ".\n"
+       << "def f" << i << "(a : int, b : int) -> int\n"
+       << "{\n"
+       << "  var x : int = a * 3 + b;\n"
+       << "  var y : bool = x >= 100;\n"
+       << "  if (x >= 100)\n"
+       << "    return x - 100;\n"
+       << "  return (x << 2) % 17;\n"
+       << "}\n\n";
+    std::string s = ss.str();
+    os << s;
+    n += s.size();
+  }
+}
+
+
+} // namespace bench
+
+
+#endif
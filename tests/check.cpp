@@ -0,0 +1,89 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that checking function definitions in parallel produces
+// the same program and the same diagnostics as checking them
+// while parsing. The input should contain no errors other than
+// those found by checking definitions.
+//
+//    test-check <path>
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// The printed program and diagnostics of a parse.
+struct Result
+{
+  std::string text;
+  std::string diags;
+  int         errors;
+};
+
+
+// Parse the file, capturing diagnostics. If `pool` is given,
+// definitions are checked on that pool.
+Result
+compile(Buffer& buf, Thread_pool* pool)
+{
+  std::stringstream diags;
+  std::streambuf* err = std::cerr.rdbuf(diags.rdbuf());
+  int n = error_count();
+  Unit const* u = pool ? parse(buf, *pool) : parse(buf);
+  n = error_count() - n;
+  std::cerr.rdbuf(err);
+
+  std::stringstream ss;
+  Printer p(ss);
+  print(p, u);
+  delete u;
+  return Result{ss.str(), diags.str(), n};
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Result expect = compile(f, nullptr);
+  for (int n = 0; n <= 4; ++n) {
+    Thread_pool pool(n);
+    Result r = compile(f, &pool);
+    if (r.errors != expect.errors) {
+      std::cerr << "error: expected " << expect.errors << " errors but got "
+                << r.errors << " with " << n << " threads\n";
+      return -1;
+    }
+    if (r.diags != expect.diags) {
+      std::cerr << "error: diagnostics differ with " << n << " threads:\n"
+                << r.diags;
+      return -1;
+    }
+    if (r.text != expect.text) {
+      std::cerr << "error: program differs with " << n << " threads:\n"
+                << r.text;
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that a file compiled concurrently in several contexts
+// produces the same program as a file compiled in the default
+// context. An invalid program is compiled alongside them, and
+// its errors must be counted only in its own context.
+//
+// Types are shared by all contexts, so the declarations of each
+// program must have the same types as those of the default
+// context, and each program must outlive its context.
+//
+//    test-context <path> [compilations]
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/context.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns the printed text of the unit.
+std::string
+to_string(Unit const* u)
+{
+  std::stringstream ss;
+  Printer p(ss);
+  print(p, u);
+  return ss.str();
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+  int n = argc > 2 ? std::atoi(argv[2]) : 8;
+
+  // Open the input file.
+  Mapped_file f(argv[1]);
+  Input_context in(f);
+
+  Unit const* base = parse(f);
+  std::string expect = to_string(base);
+  if (error_count())
+    return -1;
+
+  // Compile the file once in each context. Each compilation
+  // owns its context, and the units are checked after the
+  // contexts are destroyed.
+  std::vector<Unit const*> units(n);
+  std::vector<int> errors(n);
+  Context bad;
+  Buffer text(String("def f() -> int { return true; }\ndef g() -> bool { return 1; }\n"));
+  Thread_pool pool(4);
+  pool.submit([&bad, &text]() {
+    Input_context in(text);
+    delete parse(bad, text);
+  });
+  for (int i = 0; i < n; ++i) {
+    pool.submit([&f, &units, &errors, i]() {
+      Context cxt;
+      Input_context in(f);
+      units[i] = parse(cxt, f);
+      errors[i] = cxt.errors;
+    });
+  }
+  pool.wait();
+
+  if (error_count()) {
+    error("errors were emitted by separate contexts");
+    return -1;
+  }
+  if (bad.errors != 2 || bad.diagnostics.entries.size() != 2) {
+    error("expected 2 errors but got {}", bad.errors);
+    return -1;
+  }
+  for (int i = 0; i < n; ++i) {
+    if (errors[i]) {
+      error("compilation {} failed", i);
+      return -1;
+    }
+    std::string result = to_string(units[i]);
+    if (result != expect) {
+      error("compilation {} differs:\n{}", i, result);
+      return -1;
+    }
+    Decl_seq const& ds = units[i]->declarations();
+    for (std::size_t k = 0; k < ds.size(); ++k) {
+      if (ds[k]->type() != base->declarations()[k]->type()) {
+        error("compilation {} has a different type for '{}'", i, *ds[k]->name());
+        return -1;
+      }
+    }
+    delete units[i];
+  }
+}
@@ -0,0 +1,216 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that deeply nested expressions and statements can be
+// parsed, checked, evaluated, reduced, printed, graphed,
+// interpreted, and translated to bytecode without exhausting
+// the call stack.
+//
+//    test-deep [depth]
+//
+// The depth of nesting is 10^6 by default. Nested blocks are
+// parsed and checked, but not printed: each line of a block is
+// indented by its depth, so the output would be quadratic in
+// the depth. Recursive calls are interpreted to a tenth of the
+// depth.
+
+#include "beaker/token.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/evaluate.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+#include "beaker/print.hpp"
+#include "beaker/graph.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// A stream buffer that discards its output, counting the
+// characters and lines written.
+struct Counter : std::streambuf
+{
+  int overflow(int c)
+  {
+    ++chars;
+    if (c == '\n')
+      ++lines;
+    return c;
+  }
+
+  std::size_t chars = 0;
+  std::size_t lines = 0;
+};
+
+
+std::string
+repeat(char const* s, int n)
+{
+  std::string r;
+  for (int i = 0; i < n; ++i)
+    r += s;
+  return r;
+}
+
+
+struct Case
+{
+  std::string text;
+  Value       value;
+  std::size_t nodes;
+};
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  std::size_t m = n;
+
+  // Unary operators, right- and left-nested binary operators,
+  // and nested calls.
+  std::vector<Case> cases {
+    {repeat("- ", n) + "1", n % 2 ? -1 : 1, m + 1},
+    {repeat("1 + (", n) + "1" + repeat(")", n), n + 1, 2 * m + 1},
+    {repeat("1 + ", n) + "1", n + 1, 2 * m + 1},
+    {"f(" + repeat("f(", n) + "1" + repeat(")", n) + ")", 0, m + 2},
+  };
+
+  std::string text = "def f(n : int) -> int { return 0; }\n";
+  for (std::size_t i = 0; i < cases.size(); ++i)
+    text += "var v" + std::to_string(i) + " : int = " + cases[i].text + ";\n";
+  // Nested blocks and if statements.
+  text += "def g() -> int " + repeat("{ ", n) + "return 1;" + repeat(" }", n) + "\n";
+  text += "def h() -> int { " + repeat("if (true) ", n) + "return 1; return 0; }\n";
+  // A long return expression and deep recursion.
+  text += "def r() -> int { return " + repeat("1 + ", n) + "1; }\n";
+  text += "def d(n : int) -> int { if (n == 0) return 0; return 1 + d(n - 1); }\n";
+  Buffer buf(text);
+  Input_context cxt(buf);
+
+  Unit const* u = parse(buf);
+  if (error_count())
+    return -1;
+  if (u->declarations().size() != cases.size() + 5) {
+    error("expected {} declarations but got {}", cases.size() + 5, u->declarations().size());
+    return -1;
+  }
+
+  // Check the value of each initializer, except the call,
+  // which cannot be reduced.
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    Variable_decl const* v = cast<Variable_decl>(u->declarations()[i + 1]);
+    Expr const* e = reduce(v->initializer());
+    if (is<Call_expr>(v->initializer())) {
+      if (e != v->initializer()) {
+        error("v{} should not be reduced", i);
+        return -1;
+      }
+      continue;
+    }
+    Constant_expr const* c = as<Constant_expr>(e);
+    if (!c || c->value() != cases[i].value || evaluate(v->initializer()) != cases[i].value) {
+      error("v{} should be {}", i, cases[i].value);
+      return -1;
+    }
+  }
+
+  // Print and graph each initializer. Each node prints at least
+  // one character. The graph has a line for each node and arrow,
+  // and one each to open and close it.
+  Counter out;
+  std::ostream os(&out);
+  Printer p(os);
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    Variable_decl const* v = cast<Variable_decl>(u->declarations()[i + 1]);
+    out.chars = 0;
+    print(p, v->initializer());
+    if (out.chars < cases[i].nodes) {
+      error("v{} printed only {} characters", i, out.chars);
+      return -1;
+    }
+
+    out.lines = 0;
+    std::streambuf* err = std::cerr.rdbuf(&out);
+    graph(v->initializer());
+    std::cerr.rdbuf(err);
+    if (out.lines != 2 * cases[i].nodes + 1) {
+      error("v{} graphed {} lines", i, out.lines);
+      return -1;
+    }
+  }
+
+  // Print the chain of if statements.
+  out.chars = 0;
+  print(p, find_function(u, "h"));
+  if (out.chars < 10 * m) {
+    error("h printed only {} characters", out.chars);
+    return -1;
+  }
+
+  // Interpret the initializers and functions.
+  Interpreter interp(u);
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    if (interp.store[i] != cases[i].value) {
+      error("v{} was initialized to {}", i, interp.store[i]);
+      return -1;
+    }
+  }
+  std::vector<std::pair<char const*, Value>> calls {
+    {"g", 1}, {"h", 1}, {"r", n + 1},
+  };
+  for (auto const& c : calls) {
+    Value v = interp.call(find_function(u, c.first), {});
+    if (v != c.second) {
+      error("{}() returned {}", c.first, v);
+      return -1;
+    }
+  }
+  Value v = interp.call(find_function(u, "d"), {n / 10});
+  if (v != n / 10) {
+    error("d({}) returned {}", n / 10, v);
+    return -1;
+  }
+
+  // Translate the unit and run the initializers and functions
+  // on the machine.
+  Program prog = to_bytecode(u);
+  if (error_count())
+    return -1;
+  Machine mach(prog);
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    if (mach.globals[i] != cases[i].value) {
+      error("v{} was initialized to {} by the machine", i, mach.globals[i]);
+      return -1;
+    }
+  }
+  for (auto const& c : calls) {
+    Value v = mach.call(*prog.find(find_function(u, c.first)), {});
+    if (v != c.second) {
+      error("{}() returned {} on the machine", c.first, v);
+      return -1;
+    }
+  }
+  v = mach.call(*prog.find(find_function(u, "d")), {n / 10});
+  if (v != n / 10) {
+    error("d({}) returned {} on the machine", n / 10, v);
+    return -1;
+  }
+  if (error_count())
+    return -1;
+}
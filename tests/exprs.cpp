@@ -1,8 +1,14 @@
 // Copyright (c) 2015 Andrew Sutton
 // All rights reserved
 
+#include "beaker/token.hpp"
 #include "beaker/expr.hpp"
+#include "beaker/type.hpp"
+#include "beaker/decl.hpp"
 #include "beaker/less.hpp"
+#include "beaker/same.hpp"
+#include "beaker/hash.hpp"
+#include "beaker/compact.hpp"
 #include "beaker/print.hpp"
 
 #include <iostream>
@@ -39,10 +45,58 @@ test_print()
 }
 
 
+void
+test_compact()
+{
+  Decl const* x = make_parameter_decl(get_identifier("x"), get_int_type());
+
+  // (x + 1) * (x + 1)
+  Expr const* e1 = make_binary_expr(num_add_op, make_identifier_expr(x), make_int_expr(1));
+  Expr const* e2 = make_binary_expr(num_add_op, make_identifier_expr(x), make_int_expr(1));
+  Expr const* e3 = make_binary_expr(num_mul_op, e1, e2);
+  lingo_assert(e1 != e2);
+  lingo_assert(hash(e1) == hash(e2));
+
+  Binary_expr const* c = cast<Binary_expr>(compact(e3));
+  lingo_assert(c->left() == c->right());
+  lingo_assert(hash(c) == hash(e3));
+  print(c);
+
+  // -(x + 1) - -(x + 1)
+  Expr const* e4 = make_unary_expr(num_neg_op, e1);
+  Expr const* e5 = make_unary_expr(num_neg_op, e2);
+  Expr const* e6 = make_binary_expr(num_sub_op, e4, e5);
+  c = cast<Binary_expr>(compact(e6));
+  lingo_assert(c->left() == c->right());
+  lingo_assert(hash(e4) != hash(e1));
+}
+
+
+void
+test_same()
+{
+  Decl const* x = make_parameter_decl(get_identifier("x"), get_int_type());
+
+  Expr const* e1 = make_binary_expr(num_add_op, make_identifier_expr(x), make_int_expr(1));
+  Expr const* e2 = make_binary_expr(num_add_op, make_identifier_expr(x), make_int_expr(1));
+  Expr const* e3 = make_binary_expr(num_sub_op, make_identifier_expr(x), make_int_expr(1));
+  Expr const* e4 = make_unary_expr(num_neg_op, e1);
+  lingo_assert(same(e1, e1));
+  lingo_assert(same(e1, e2));
+  lingo_assert(!same(e1, e3));
+  lingo_assert(!same(e1, e4));
+  lingo_assert(!less(e1, e2) && !less(e2, e1));
+  lingo_assert(less(e1, e3) != less(e3, e1));
+  lingo_assert(less(e1, e4) != less(e4, e1));
+}
+
+
 int
 main()
 {
   test_name();
   test_print();
+  test_compact();
+  test_same();
   return 0;
 }
@@ -0,0 +1,50 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Runs a program, starting with its function main(), and checks
+// the value it returns.
+//
+//    test-interpret <path> <expected>
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+
+  Value expect = std::atoi(argv[2]);
+  Value result = interpret(u, "main");
+  if (error_count())
+    return -1;
+  if (result != expect) {
+    error("main() returned {} but expected {}", result, expect);
+    return -1;
+  }
+  return 0;
+}
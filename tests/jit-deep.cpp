@@ -0,0 +1,102 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that deeply nested expressions and statements can be
+// compiled to native code, and run with tiered execution,
+// without exhausting the call stack.
+//
+//    test-jit-deep [depth]
+//
+// The depth of nesting is 20000 by default.
+
+#include "beaker/token.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/engine.hpp"
+#include "beaker/codegen/jit.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+std::string
+repeat(char const* s, int n)
+{
+  std::string r;
+  for (int i = 0; i < n; ++i)
+    r += s;
+  return r;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  int n = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+  // Chained and nested operators, nested calls, conditions,
+  // blocks, and if statements.
+  std::string text = "def f(n : int) -> int { return n + 1; }\n";
+  text += "var v : int = " + repeat("1 + ", n) + "1;\n";
+  text += "def a() -> int { return " + repeat("1 + ", n) + "1; }\n";
+  text += "def b() -> int { return " + repeat("- ", n) + "1; }\n";
+  text += "def c() -> int { return " + repeat("f(", n) + "0" + repeat(")", n) + "; }\n";
+  text += "def d() -> int { if (" + repeat("true && ", n) + "true) return 1; return 0; }\n";
+  text += "def e() -> int " + repeat("{ ", n) + "return v;" + repeat(" }", n) + "\n";
+  text += "def g() -> int { " + repeat("if (true) ", n) + "return 1; return 0; }\n";
+  Buffer buf(text);
+  Input_context cxt(buf);
+
+  Unit const* u = parse(buf);
+  if (error_count())
+    return -1;
+
+  std::vector<std::pair<char const*, Value>> calls {
+    {"a", n + 1}, {"b", n % 2 ? -1 : 1}, {"c", n}, {"d", 1}, {"e", n + 1}, {"g", 1},
+  };
+  for (char const* p : {"", "default<O2>"}) {
+    Jit_options opts;
+    opts.pipeline = p;
+    for (auto const& c : calls) {
+      Value v = run_jit(u, c.first, {}, opts);
+      if (error_count())
+        return -1;
+      if (v != c.second) {
+        error("{}() returned {} with pipeline '{}'", c.first, v, p);
+        return -1;
+      }
+    }
+  }
+
+  // Compile each function as soon as it is called.
+  Tier_options opts;
+  opts.threshold = 1;
+  opts.background = false;
+  Engine e(u, opts);
+  for (auto const& c : calls) {
+    for (int i = 0; i < 2; ++i) {
+      Value v = e.call(find_function(u, c.first), {});
+      if (v != c.second) {
+        error("{}() returned {} with tiered execution", c.first, v);
+        return -1;
+      }
+    }
+  }
+  if (e.compiled == 0) {
+    error("no functions were compiled");
+    return -1;
+  }
+  if (error_count())
+    return -1;
+}
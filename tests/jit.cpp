@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Compiles a program to native code and runs it, starting with
+// its function main(). Checks that the value it returns is
+// expected, and that the interpreter agrees. The program is
+// compiled with and without optimization.
+//
+//    test-jit <path> <expected>
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/codegen/jit.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+
+  Value expect = std::atoi(argv[2]);
+  for (char const* p : {"", "default<O2>"}) {
+    Jit_options opts;
+    opts.pipeline = p;
+    Value result = run_jit(u, "main", {}, opts);
+    if (error_count())
+      return -1;
+    if (result != expect) {
+      error("main() returned {} but expected {} with pipeline '{}'", result, expect, p);
+      return -1;
+    }
+  }
+  if (interpret(u, "main") != expect) {
+    error("the interpreter disagrees with the JIT");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that parsing the declarations of a file and then
+// parsing the deferred function bodies produces the same
+// program as parsing the file. Bodies are parsed on demand,
+// all at once, and before slots are allocated for a back end.
+//
+// Functions whose bodies fail to check remain in the unit with
+// invalid bodies, whether or not their bodies are deferred. They
+// are printed as declarations, and translating them to LLVM
+// produces no definitions.
+//
+//    test-lazy <path>
+
+#include "beaker/token.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/codegen/llvm.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns the printed text of the unit.
+std::string
+to_string(Unit const* u)
+{
+  std::stringstream ss;
+  Printer p(ss);
+  print(p, u);
+  return ss.str();
+}
+
+
+// Returns the functions in the unit whose bodies are invalid.
+Decl_seq
+invalid_functions(Unit const* u)
+{
+  Decl_seq fns;
+  for (Decl const* d : u->declarations())
+    if (Function_decl const* f = as<Function_decl>(d))
+      if (!is_valid_node(f->body()))
+        fns.push_back(f);
+  return fns;
+}
+
+
+// Returns true if the printed text of the unit `u`, whose bodies
+// were deferred, is the text `expect` of the same program
+// parsed directly, and if its invalid functions are not
+// translated.
+bool
+check_deferred(Unit const* u, std::string const& expect)
+{
+  if (to_string(u) != expect) {
+    error("deferred parsing produced:\n{}", to_string(u));
+    return false;
+  }
+  std::stringstream ss;
+  to_llvm(ss, make_unit(invalid_functions(u)));
+  if (!ss.str().empty()) {
+    error("invalid functions were translated:\n{}", ss.str());
+    return false;
+  }
+  return true;
+}
+
+
+// Returns the number of deferred bodies in the unit.
+int
+count_deferred(Unit const* u)
+{
+  int n = 0;
+  for (Decl const* d : u->declarations())
+    if (Function_decl const* f = as<Function_decl>(d))
+      n += f->is_deferred();
+  return n;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  // Each invalid body is diagnosed once for each parse.
+  std::string expect = to_string(parse(f));
+  int errors = error_count();
+
+  // Bodies are parsed as the printer requests them.
+  Unit const* u1 = parse_declarations(f);
+  if (count_deferred(u1) == 0) {
+    error("no function bodies were deferred");
+    return -1;
+  }
+  to_string(u1);
+  if (count_deferred(u1) != 0) {
+    error("deferred bodies were not parsed");
+    return -1;
+  }
+  if (!check_deferred(u1, expect))
+    return -1;
+
+  // Bodies are parsed all at once.
+  Unit const* u2 = parse_declarations(f);
+  parse_bodies(u2);
+  if (count_deferred(u2) != 0) {
+    error("deferred bodies were not parsed");
+    return -1;
+  }
+  if (!check_deferred(u2, expect))
+    return -1;
+
+  // Bodies are parsed before slots are allocated.
+  Unit const* u3 = parse_declarations(f);
+  allocate_slots(u3);
+  if (count_deferred(u3) != 0) {
+    error("deferred bodies were not parsed");
+    return -1;
+  }
+  if (!check_deferred(u3, expect))
+    return -1;
+  if (error_count() != 4 * errors) {
+    error("expected {} errors but got {}", 4 * errors, error_count());
+    return -1;
+  }
+}
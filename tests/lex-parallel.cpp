@@ -0,0 +1,55 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that lexing a file in parallel produces the same
+// tokens as lexing it sequentially. The chunk size is kept
+// small so that even small inputs are divided.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/file.hpp"
+#include "beaker/thread.hpp"
+
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  // Open the input file.
+  Mapped_file f(argv[1]);
+
+  Token_list toks1 = lex(f);
+
+  // Lex with no workers, in which case the calling thread
+  // lexes every chunk, and with several.
+  for (int n : {0, 4}) {
+    Thread_pool pool(n);
+    Token_list toks2 = lex(f, pool, 16);
+    if (error_count())
+      return -1;
+
+    if (toks1.size() != toks2.size()) {
+      error("expected {} tokens but got {}", toks1.size(), toks2.size());
+      return -1;
+    }
+    for (std::size_t i = 0; i < toks1.size(); ++i) {
+      Token const& a = toks1[i];
+      Token const& b = toks2[i];
+      if (a.kind() != b.kind() || a.symbol() != b.symbol() || a.location() != b.location()) {
+        error(b.location(), "expected '{}' but got '{}'", a, b);
+        return -1;
+      }
+    }
+  }
+}
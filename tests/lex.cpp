@@ -3,8 +3,7 @@
 
 #include "beaker/token.hpp"
 #include "beaker/lexer.hpp"
-
-#include "lingo/file.hpp"
+#include "beaker/file.hpp"
 
 #include <iostream>
 
@@ -23,7 +22,7 @@ main(int argc, char* argv[])
   }
 
   // Open the input file.
-  File& f = open_file(argv[1]);
+  Mapped_file f(argv[1]);
   
   Token_list toks = lex(f);
   if (error_count())
@@ -9,6 +9,7 @@
 
 
 #include <iostream>
+#include <vector>
 
 
 using namespace lingo;
@@ -79,9 +80,42 @@ test_2()
 }
 
 
+// Test lookup through many nested scopes.
+void
+test_3()
+{
+  Scope gs(global_scope);
+
+  String const* n = get_identifier("v");
+  String const* m = get_identifier("w");
+  Decl const* d1 = make_bool_var(n, truth());
+  lingo_assert(declare(d1));
+  {
+    Scope fs(function_scope);
+    std::vector<Decl const*> decls;
+    std::vector<Scope*> scopes;
+    for (int i = 0; i < 100; ++i) {
+      scopes.push_back(new Scope(local_scope));
+      decls.push_back(make_bool_var(i % 2 ? n : m, truth()));
+      lingo_assert(declare(decls.back()));
+      lingo_assert(lookup(i % 2 ? n : m) == decls.back());
+    }
+    for (int i = 99; i >= 0; --i) {
+      lingo_assert(lookup(i % 2 ? n : m) == decls[i]);
+      delete scopes[i];
+    }
+    lingo_assert(lookup(n) == d1);  // OK: finds d1
+    lingo_assert(lookup(m) == nullptr);
+  }
+  lingo_assert(lookup(n) == d1);
+  lingo_assert(lookup("unbound") == nullptr);
+}
+
+
 int
 main()
 {
   test_1();
   test_2();
+  test_3();
 }
@@ -4,8 +4,7 @@
 #include "beaker/token.hpp"
 #include "beaker/lexer.hpp"
 #include "beaker/parse.hpp"
-
-#include "lingo/file.hpp"
+#include "beaker/file.hpp"
 
 #include <iostream>
 
@@ -25,14 +24,10 @@ main(int argc, char* argv[])
   }
 
   // Open the input file.
-  File& f = open_file(argv[1]);
+  Mapped_file f(argv[1]);
   Input_context cxt(f);
   
-  Token_list toks = lex(f);
-  if (error_count())
-    return -1;
-
-  Unit const* unit = parse(toks);
+  Unit const* unit = parse(f);
   if (error_count())
     return -1;
   print(unit);
@@ -0,0 +1,92 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks the precedence and associativity of binary operators.
+// Each expression is parsed as the initializer of a variable,
+// and its reduced value is compared with the value computed by
+// C++.
+
+#include "beaker/token.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/evaluate.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+struct Case
+{
+  char const* type;
+  char const* text;
+  Value       value;
+};
+
+
+// Each case gives the text of an expression and its value in
+// C++, whose operators have the same precedence. The C++ value
+// is written with explicit parentheses where the grouping is
+// not obvious, so that it does not depend on the precedence
+// being tested.
+#define int_case(e, v) Case{"int", #e, Value(v)}
+#define bool_case(e, v) Case{"bool", #e, Value(v)}
+
+std::vector<Case> cases {
+  int_case(1 + 2 * 3, 1 + (2 * 3)),
+  int_case(1 * 2 + 3, (1 * 2) + 3),
+  int_case(10 - 4 - 3, (10 - 4) - 3),
+  int_case(100 / 10 / 5, (100 / 10) / 5),
+  int_case(17 % 5 * 2, (17 % 5) * 2),
+  int_case(1 << 2 + 1, 1 << (2 + 1)),
+  int_case(64 >> 2 >> 1, (64 >> 2) >> 1),
+  int_case(6 & 3 ^ 5 | 8, ((6 & 3) ^ 5) | 8),
+  int_case(8 | 5 ^ 6 & 3, 8 | (5 ^ (6 & 3))),
+  int_case(1 + 2 * (3 - 4) - -5, (1 + (2 * (3 - 4))) - -5),
+  int_case(~1 + 2 * -3, ~1 + (2 * -3)),
+  int_case(0x1F + 0b101 * 10, 31 + (5 * 10)),
+  bool_case(1 + 1 == 2, (1 + 1) == 2),
+  bool_case(1 < 2 == 3 > 4, (1 < 2) == (3 > 4)),
+  bool_case(1 << 2 < 5, (1 << 2) < 5),
+  bool_case(true || false && false, true || (false && false)),
+  bool_case(false && true || true, (false && true) || true),
+  bool_case(1 < 2 && 3 < 4 || 5 > 6, ((1 < 2) && (3 < 4)) || (5 > 6)),
+  bool_case(!false && 2 >= 2, !false && (2 >= 2)),
+};
+
+
+int
+main()
+{
+  init_tokens();
+  init_grammar();
+
+  std::string text;
+  for (std::size_t i = 0; i < cases.size(); ++i)
+    text += "var v" + std::to_string(i) + " : " + cases[i].type + " = " + cases[i].text + ";\n";
+  Buffer buf(text);
+  Input_context cxt(buf);
+
+  Unit const* u = parse(buf);
+  if (error_count())
+    return -1;
+  if (u->declarations().size() != cases.size()) {
+    error("expected {} declarations but got {}", cases.size(), u->declarations().size());
+    return -1;
+  }
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    Variable_decl const* v = cast<Variable_decl>(u->declarations()[i]);
+    Expr const* e = reduce(v->initializer());
+    Constant_expr const* c = as<Constant_expr>(e);
+    if (!c || c->value() != cases[i].value) {
+      error("'{}' should be {}", cases[i].text, cases[i].value);
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Checks that incremental lexing produces the same tokens as
+// lexing the edited text from scratch. A sequence of edits
+// (insertions, deletions, and replacements) is applied to the
+// text of the input file, and each is checked.
+
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/file.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Returns true if the token lists are the same.
+bool
+check(Token_list const& toks1, Token_list const& toks2)
+{
+  if (toks1.size() != toks2.size()) {
+    error("expected {} tokens but got {}", toks1.size(), toks2.size());
+    return false;
+  }
+  for (std::size_t i = 0; i < toks1.size(); ++i) {
+    Token const& a = toks1[i];
+    Token const& b = toks2[i];
+    if (a.kind() != b.kind() || a.symbol() != b.symbol() || a.location() != b.location()) {
+      error(b.location(), "expected '{}' but got '{}'", a, b);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// Apply a sequence of random edits to `text`, checking the
+// tokens after each.
+bool
+check_edits(String text, int count)
+{
+  std::unique_ptr<Buffer> buf(new Buffer(text));
+  Edit_list toks(*buf);
+
+  // Characters that are likely to merge, split, or comment
+  // out tokens, or to form the prefix of an integer literal.
+  char const chars[] = "a1_ /-><=&|\n0xb";
+
+  std::minstd_rand rng(42);
+  for (int i = 0; i < count; ++i) {
+    std::size_t n = rng() % (text.size() + 1);
+    Text_edit e {n, 0, 0};
+    switch (rng() % 3) {
+    case 0:
+      text.insert(n, 1, chars[rng() % (sizeof(chars) - 1)]);
+      e.inserted = 1;
+      break;
+    case 1:
+      if (n < text.size()) {
+        text.erase(n, 1);
+        e.removed = 1;
+      }
+      break;
+    case 2:
+      if (n < text.size()) {
+        text[n] = chars[rng() % (sizeof(chars) - 1)];
+        e.removed = e.inserted = 1;
+      }
+      break;
+    }
+
+    buf.reset(new Buffer(text));
+    toks.relex(*buf, e);
+    Token_list all = toks.tokens();
+    if (all.size() != toks.size()) {
+      error("expected {} tokens but counted {}", all.size(), toks.size());
+      return false;
+    }
+    if (!check(lex(*buf), all))
+      return false;
+  }
+  return true;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+
+  if (argc < 2) {
+    error("invalid arguments");
+    return -1;
+  }
+
+  // An edit that completes the prefix of a hexadecimal literal
+  // preceding it.
+  {
+    String text = "var x : int = 0xg;\n";
+    std::unique_ptr<Buffer> buf(new Buffer(text));
+    Edit_list toks(*buf);
+    text[16] = '1';
+    buf.reset(new Buffer(text));
+    toks.relex(*buf, Text_edit {16, 1, 1});
+    if (!check(lex(*buf), toks.tokens()))
+      return -1;
+  }
+
+  std::stringstream ss;
+  ss << std::ifstream(argv[1]).rdbuf();
+  String text = ss.str();
+  if (!check_edits(text, 1000))
+    return -1;
+
+  // Repeat the text so that the tokens span many blocks of
+  // the edit list.
+  String big;
+  for (int i = 0; i < 64; ++i)
+    big += text;
+  if (!check_edits(big, 2000))
+    return -1;
+
+  return error_count() ? -1 : 0;
+}
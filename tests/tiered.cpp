@@ -0,0 +1,110 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Runs a program with tiered execution, starting with its
+// function main(), and checks the value it returns. The program
+// is then run repeatedly, both waiting for each hot function to
+// be compiled and compiling in the background, so that results
+// are computed by bytecode, by native code, and by their mixture.
+// Those results, and the runtime errors diagnosed while
+// computing them, are checked against the interpreter.
+//
+//    test-tiered <path> <expected>
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/engine.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+// Call main() `n` times, checking that each result, and the
+// number of errors diagnosed, is the same as that of the
+// interpreter `interp`, which runs the same calls. Note that
+// programs may change their globals, so results of later calls
+// may differ from the first.
+bool
+check(Engine& e, Interpreter& interp, Function_decl const* f, int n)
+{
+  for (int i = 0; i < n; ++i) {
+    int n0 = error_count();
+    Value result = e.call(f, {});
+    int n1 = error_count();
+    Value expect = interp.call(f, {});
+    int n2 = error_count();
+    if (n1 - n0 != n2 - n1) {
+      error("main() diagnosed {} errors but expected {}", n1 - n0, n2 - n1);
+      return false;
+    }
+    if (result != expect) {
+      error("main() returned {} but expected {}", result, expect);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+  Function_decl const* fn = find_function(u, "main");
+  Value expect = std::atoi(argv[2]);
+
+  // The first result is known.
+  if (run_tiered(u, "main") != expect) {
+    error("main() should return {}", expect);
+    return -1;
+  }
+
+  // Compile each function as soon as it is called.
+  Tier_options opts;
+  opts.threshold = 1;
+  opts.background = false;
+  {
+    Engine e(u, opts);
+    Interpreter interp(u);
+    if (!check(e, interp, fn, 2))
+      return -1;
+    if (e.compiled == 0) {
+      error("no functions were compiled");
+      return -1;
+    }
+  }
+
+  // Compile in the background.
+  opts.threshold = 2;
+  opts.background = true;
+  {
+    Engine e(u, opts);
+    Interpreter interp(u);
+    if (!check(e, interp, fn, 3))
+      return -1;
+    e.wait();
+    if (!check(e, interp, fn, 1))
+      return -1;
+  }
+  return 0;
+}
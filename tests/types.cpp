@@ -3,6 +3,7 @@
 
 #include "beaker/type.hpp"
 #include "beaker/less.hpp"
+#include "beaker/same.hpp"
 #include "beaker/print.hpp"
 
 #include <iostream>
@@ -91,6 +92,33 @@ test_ref()
 }
 
 
+// Types are canonical, so types with the same structure are
+// the same object.
+void
+test_same()
+{
+  Type const* b = get_bool_type();
+  Type const* z = get_int_type();
+
+  Type const* t1 = get_function_type(Type_seq {z, get_reference_type(b)}, z);
+  Type const* t2 = get_function_type(Type_seq {z, get_reference_type(b)}, z);
+  Type const* t3 = get_function_type(Type_seq {z}, z);
+  Type const* t4 = get_function_type(Type_seq {z, z}, z);
+  lingo_assert(t1 == t2);
+  lingo_assert(same(t1, t2));
+  lingo_assert(!same(t1, t3));
+  lingo_assert(!same(t1, t4));
+  lingo_assert(!same(t3, t4));
+
+  // Nested function types.
+  Type const* t5 = get_function_type(Type_seq {t1}, t3);
+  Type const* t6 = get_function_type(Type_seq {t2}, t3);
+  lingo_assert(t5 == t6);
+  lingo_assert(get_reference_type(z) == get_reference_type(z));
+  lingo_assert(!same(get_reference_type(z), get_reference_type(b)));
+}
+
+
 void 
 test_print()
 {
@@ -115,5 +143,6 @@ main()
   test_name();
   test_less();
   test_ref();
+  test_same();
   test_print();
 }
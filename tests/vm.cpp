@@ -0,0 +1,67 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Translates a program into bytecode and runs it on the machine,
+// starting with its function main(). Checks that the value it
+// returns is expected, and that the interpreter agrees. If the
+// disassembly flag is given, the bytecode is written to standard
+// output.
+//
+//    test-vm <path> <expected> [-d]
+
+#include "beaker/token.hpp"
+#include "beaker/unit.hpp"
+#include "beaker/parse.hpp"
+#include "beaker/file.hpp"
+#include "beaker/interpret.hpp"
+#include "beaker/bytecode.hpp"
+#include "beaker/machine.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+
+using namespace lingo;
+using namespace beaker;
+
+
+int
+main(int argc, char* argv[])
+{
+  init_tokens();
+  init_grammar();
+
+  if (argc < 3) {
+    std::cerr << "error: invalid arguments\n";
+    return -1;
+  }
+
+  Mapped_file f(argv[1]);
+  Input_context cxt(f);
+
+  Unit const* u = parse(f);
+  if (error_count())
+    return -1;
+
+  Program prog = to_bytecode(u);
+  if (error_count())
+    return -1;
+  if (argc > 3 && std::strcmp(argv[3], "-d") == 0)
+    disassemble(std::cout, prog);
+
+  Value expect = std::atoi(argv[2]);
+  Machine m(prog);
+  Value result = m.call(*prog.find(find_function(u, "main")), {});
+  if (error_count())
+    return -1;
+  if (result != expect) {
+    error("main() returned {} but expected {}", result, expect);
+    return -1;
+  }
+  if (interpret(u, "main") != result) {
+    error("the interpreter disagrees with the machine");
+    return -1;
+  }
+  return 0;
+}